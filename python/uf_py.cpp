@@ -19,16 +19,6 @@ static void serialize_append_uint32(serialize_output_t& to, uint32_t size)
     }
 }
 
-class pyobj {
-    std::unique_ptr<PyObject, void(*)(PyObject*)> p;
-public:
-    pyobj(PyObject* o = nullptr) noexcept : p{o, [](PyObject* x) { Py_XDECREF(x); }} {}
-    static pyobj wrap(PyObject* o) noexcept { Py_XINCREF(o); return pyobj(o); }// assumes borrowed references, like PyArg_ParseTuple()
-    operator PyObject* () const noexcept { return p.get(); }
-    explicit operator bool() const noexcept { return bool(p); }
-    PyObject* release() noexcept { return p.release(); }
-};
-
 
 static PyObject* ABC = nullptr, * ABC_Sequence = nullptr, * ABC_Mapping = nullptr;
 static PyObject* enum_Enum = nullptr;
@@ -68,6 +58,98 @@ bool ResolveEnumEnum() {
 
 bool IsEnum(PyObject* o) { return (enum_Enum || ResolveEnumEnum()) && PyObject_IsInstance(o, enum_Enum); }
 
+static PyObject* DictForSerializationName() {
+    static PyObject* name = PyUnicode_FromString(DICT_FOR_SERIALIZATION_ATTR_NAME);
+    return name;
+}
+
+/** What serialize_append_guess() needs to know about the class of an object
+ * that is not one of the builtin types it checks first.*/
+struct ClassInfo {
+    bool dict_for_serialization; ///<The class has a '__dict_for_serialization__' attribute
+    bool instance_attrs;         ///<Instances may have attributes the class does not have
+    bool mapping;
+    bool sequence;
+    bool enumeration;
+    unsigned version_tag;        ///<The 'tp_version_tag' of the class when this was computed
+};
+
+static PyObject* abc_get_cache_token = nullptr;
+
+/** Returns abc.get_cache_token(), which changes whenever a class is register()-ed
+ * with any ABC. Returns -1 on error.*/
+long long AbcCacheToken() {
+    if (!abc_get_cache_token)
+        if (PyObject* abc = PyImport_ImportModule("abc")) {
+            abc_get_cache_token = PyObject_GetAttrString(abc, "get_cache_token");
+            Py_DECREF(abc);
+        }
+    const pyobj token = abc_get_cache_token ? PyObject_CallNoArgs(abc_get_cache_token) : nullptr;
+    const long long ret = token ? PyLong_AsLongLong(token) : -1;
+    PyErr_Clear();
+    return ret;
+}
+
+/** True if the version tag of the class is assigned. It is reset (and later reassigned
+ * to a new value) whenever the class or any of its bases is modified.*/
+bool HasVersionTag(PyTypeObject* t) {
+#ifdef Py_TPFLAGS_VALID_VERSION_TAG
+    if (!PyType_HasFeature(t, Py_TPFLAGS_VALID_VERSION_TAG)) return false;
+#endif
+    return t->tp_version_tag != 0;
+}
+
+/** The ClassInfo of classes seen. We keep a reference to them, so that their address
+ * cannot be reused by a new class.*/
+static std::unordered_map<PyTypeObject*, ClassInfo> class_info_cache;
+static long long class_info_abc_token = -1;
+
+static void ClearClassInfo() {
+    for (auto& [type, _] : class_info_cache)
+        Py_DECREF((PyObject*)type);
+    class_info_cache.clear();
+}
+
+void RevalidateClassInfo() {
+    if (const long long token = AbcCacheToken(); token != class_info_abc_token) {
+        ClearClassInfo();
+        class_info_abc_token = token;
+    }
+}
+
+/** Resolves the ABC and Enum isinstance checks and the class attribute lookup once per class.
+ * These are slow (they walk the MRO and ABC registries), so the result is cached.
+ * An entry is used only while the version tag of the class is unchanged, and the whole
+ * cache is dropped by RevalidateClassInfo() when a class was registered with an ABC,
+ * since that may change the isinstance result of any class.
+ * The cache is bounded to not keep many dynamically created classes alive. */
+ClassInfo GetClassInfo(PyObject* o) {
+    auto& cache = class_info_cache;
+    PyTypeObject* const t = Py_TYPE(o);
+    if (auto i = cache.find(t); i != cache.end()) {
+        if (HasVersionTag(t) && i->second.version_tag == t->tp_version_tag)
+            return i->second;
+        cache.erase(i);
+        Py_DECREF((PyObject*)t);
+    }
+    ClassInfo info{
+        PyObject_HasAttr((PyObject*)t, DictForSerializationName()) != 0,
+        t->tp_dictoffset != 0 || t->tp_getattro != PyObject_GenericGetAttr,
+        PyDict_Check(o) || IsMapping(o),
+        PyList_Check(o) || IsSequence(o),
+        IsEnum(o),
+        0
+    };
+    PyErr_Clear();
+    if (!HasVersionTag(t)) //The attribute lookup above normally assigns one. If not, we cannot detect changes.
+        return info;
+    info.version_tag = t->tp_version_tag;
+    if (cache.size() >= 256)
+        ClearClassInfo();
+    Py_INCREF((PyObject*)t);
+    return cache.emplace(t, info).first->second;
+}
+
 //also clears the exception. Returns empty if no exception
 std::string GetExceptionText() {
     if (!PyErr_Occurred()) return {};
@@ -80,6 +162,102 @@ std::string GetExceptionText() {
     return ret;
 }
 
+/** Returns the struct module format character of the elements of a one-dimensional
+ * buffer in native byte order, or zero if it has some other format.*/
+static char buffer_format(const Py_buffer &view) noexcept
+{
+    if (view.ndim > 1) return 0;
+    std::string_view fmt = view.format ? view.format : "B";
+    constexpr char native = std::endian::native == std::endian::little ? '<' : '>';
+    if (fmt.size() == 2 && (fmt[0] == '@' || fmt[0] == '=' || fmt[0] == native))
+        fmt.remove_prefix(1);
+    return fmt.size() == 1 ? fmt[0] : 0;
+}
+
+/** Returns the ufser type of the elements of a one-dimensional, contiguous buffer
+ * if they can be serialized in bulk: 'i' for 4-byte, 'I' for 8-byte signed integers, 'd' for
+ * doubles and 'b' for bools, all in native byte order. Returns zero for other buffers.
+ * Unsigned integers (formats 'ILQN') may not fit the signed wire types, so they are
+ * left to the per-element path, which picks a type for their values.*/
+static char buffer_element_type(const Py_buffer &view) noexcept
+{
+    const char fmt = buffer_format(view);
+    if (fmt == 'd' && view.itemsize == 8) return 'd';
+    if (fmt == '?' && view.itemsize == 1) return 'b';
+    if (!fmt || std::string_view("ilqn").find(fmt) == std::string_view::npos) return 0;
+    return view.itemsize == 4 ? 'i' : view.itemsize == 8 ? 'I' : 0;
+}
+
+/** Serializes the content of a buffer (with a type returned by buffer_element_type())
+ * as a list in one go. We release the GIL for large buffers. */
+static void serialize_append_buffer(serialize_output_t &to, const Py_buffer &view, char elem)
+{
+    const size_t n = view.len / view.itemsize;
+    const size_t len = 4 + n * view.itemsize;
+    char *p;
+    switch (to.index()) {
+    case 0: std::get<0>(to).append(len, 0); p = std::get<0>(to).data() + std::get<0>(to).size() - len; break;
+    case 1: p = std::get<1>(to).first; std::get<1>(to).first += len; break;
+    case 2: std::get<2>(to) += len; return;
+    default: assert(0); return;
+    }
+    uf::impl::serialize_to(uint32_t(n), p);
+    auto bulk = [&] {
+        switch (elem) {
+        case 'i': uf::impl::serialize_bulk_to<false>((const int32_t *)view.buf, n, p); break;
+        case 'I': uf::impl::serialize_bulk_to<false>((const int64_t *)view.buf, n, p); break;
+        case 'd': uf::impl::serialize_bulk_to<false>((const double *)view.buf, n, p); break;
+        default: for (size_t u = 0; u < n; u++) *p++ = ((const char *)view.buf)[u] != 0; break;
+        }
+    };
+    if (len < 65536) bulk();
+    else {
+        Py_BEGIN_ALLOW_THREADS
+        bulk();
+        Py_END_ALLOW_THREADS
+    }
+}
+
+/** Serializes what the '__dict_for_serialization__()' of 'v' returns.
+ * If 'known_class' is set, the class of 'v' is known to have the attribute and we call it
+ * via the method cache, without creating a bound method object.*/
+static std::string serialize_append_dict_for_serialization(serialize_output_t &to, std::string& type,
+                                                           PyObject* v, uf::impl::ParseMode mode,
+                                                           bool known_class = false)
+{
+    pyobj v3;
+    if (known_class)
+        v3 = PyObject_VectorcallMethod(DictForSerializationName(), &v, 1, nullptr);
+    else {
+        pyobj v2 = PyObject_GetAttr(v, DictForSerializationName());
+        if (!v2) {
+            std::string err = GetExceptionText();
+            return uf::concat("Error obtaining (the existing) '__dict_for_serialization__' attr of value '", to_string(v), "' of type '", to_string((PyObject*)Py_TYPE(v)), "'",
+                              err.empty() ? "." : ": " + err + ".");
+        }
+        if (!PyCallable_Check(v2))
+            return uf::concat("The '__dict_for_serialization__' attr of value '", to_string(v), "' of type '", to_string((PyObject*)Py_TYPE(v)), "' is not callable, but is of value '",
+                              to_string(v2), "' and of type '", to_string((PyObject*)Py_TYPE(v2)), "'.");
+        v3 = PyObject_CallNoArgs(v2);
+    }
+    if (PyErr_Occurred())
+        return uf::concat("Exception calling '__dict_for_serialization__()' attr of value '", to_string(v), "' of type '", to_string((PyObject*)Py_TYPE(v)), "': ",
+                          GetExceptionText(), ".");
+    std::string ret = serialize_append_guess(to, type, v3, mode);
+    if (ret.size()) ret.append(" (Value returned by __dict_for_serialization__() of value '").append(to_string(v)).append("' of type '").append(to_string((PyObject*)Py_TYPE(v))).append("'.)");
+    return ret;
+}
+
+/** Returns the class of 'o' if serialize_append_guess() serializes all its instances via
+ * the '__dict_for_serialization__' attribute of the class, else null.*/
+static PyTypeObject* DictForSerializationClass(PyObject* o) {
+    if (!o || PyLong_Check(o) || PyFloat_Check(o) || PyUnicode_Check(o) || PyBytes_Check(o)
+        || PyTuple_Check(o) || error_value_check(o) || PyObject_CheckBuffer(o))
+        return nullptr;
+    const ClassInfo info = GetClassInfo(o);
+    return info.dict_for_serialization && info.version_tag ? Py_TYPE(o) : nullptr;
+}
+
 std::string serialize_append_guess(serialize_output_t &to,
                                    std::string& type, PyObject* v, uf::impl::ParseMode mode)
 {
@@ -106,9 +284,14 @@ std::string serialize_append_guess(serialize_output_t &to,
             type.push_back('d');
             return {};
         }
+        const int64_t val = PyLong_AsLongLong(v);
+        if (val == -1 && PyErr_Occurred()) {
+            PyErr_Clear();
+            return uf::concat("Value '", to_string(v), "' does not fit into 64 bits.");
+        }
         switch (to.index()) {
-        case 0: std::get<0>(to).append(uf::serialize(int64_t(PyLong_AsSsize_t(v)))); break;
-        case 1: uf::impl::serialize_to(int64_t(PyLong_AsSsize_t(v)), std::get<1>(to).first); break;
+        case 0: std::get<0>(to).append(uf::serialize(val)); break;
+        case 1: uf::impl::serialize_to(val, std::get<1>(to).first); break;
         case 2: std::get<2>(to) += 8; break;
         default: assert(0);
         }
@@ -181,41 +364,41 @@ std::string serialize_append_guess(serialize_output_t &to,
         case 2: std::get<2>(to) += uf::impl::serialize_len(*error); break;
         case 1: uf::impl::serialize_to(*error, std::get<1>(to).first); break;
         case 0:
-            std::get<0>(to).reserve(std::get<0>(to).length() + uf::impl::serialize_len(*error));
-            char* p = std::get<0>(to).data() + std::get<0>(to).length(); //current pos at end
+            const size_t len = uf::impl::serialize_len(*error);
+            std::get<0>(to).append(len, 0);
+            char *p = std::get<0>(to).data() + std::get<0>(to).length() - len;
             uf::impl::serialize_to(*error, p);
             break;
         }
         type.push_back('e');
         return {};
     }
-    //Check if the type has "__dict_for_serialization__" member
-    static PyObject* __dict_for_serialization__ = PyUnicode_FromString(DICT_FOR_SERIALIZATION_ATTR_NAME);
-    if (PyObject_HasAttr(v, __dict_for_serialization__)) {
-        pyobj v2 = PyObject_GetAttr(v, __dict_for_serialization__);
-        if (!v2) {
-            std::string err = GetExceptionText();
-            return uf::concat("Error obtaining (the existing) '__dict_for_serialization__' attr of value '", to_string(v), "' of type '", to_string((PyObject*)Py_TYPE(v)), "'",
-                              err.empty() ? "." : ": " + err + ".");
-        }
-        if (!PyCallable_Check(v2))
-            return uf::concat("The '__dict_for_serialization__' attr of value '", to_string(v), "' of type '", to_string((PyObject*)Py_TYPE(v)), "' is not callable, but is of value '",
-                              to_string(v2), "' and of type '", to_string((PyObject*)Py_TYPE(v2)), "'.");
-        pyobj v3 = PyObject_CallNoArgs(v2);
-        if (PyErr_Occurred())
-            return uf::concat("Exception calling '__dict_for_serialization__()' attr of value '", to_string(v), "' of type '", to_string((PyObject*)Py_TYPE(v)), "': ",
-                              GetExceptionText(), ".");
-        std::string ret = serialize_append_guess(to, type, v3, mode);
-        if (ret.size()) ret.append(" (Value returned by __dict_for_serialization__() of value '").append(to_string(v)).append("' of type '").append(to_string((PyObject*)Py_TYPE(v))).append("'.)");
-        return ret;
+    //Arrays of numbers (array.array, memoryview, numpy) are serialized in bulk as lists.
+    if (PyObject_CheckBuffer(v) && !PyByteArray_Check(v)) {
+        Py_buffer view;
+        if (PyObject_GetBuffer(v, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == 0) {
+            const char elem = buffer_element_type(view);
+            if (elem) {
+                serialize_append_buffer(to, view, elem);
+                type.push_back('l');
+                type.push_back(elem);
+            }
+            PyBuffer_Release(&view);
+            if (elem) return {};
+        } else
+            PyErr_Clear();
     }
+    const ClassInfo info = GetClassInfo(v);
+    //Check if the type has "__dict_for_serialization__" member
+    if (info.dict_for_serialization || (info.instance_attrs && PyObject_HasAttr(v, DictForSerializationName())))
+        return serialize_append_dict_for_serialization(to, type, v, mode);
     //Here we do a bit of an optimization for vanilla dicts
     //For dicts the PyDict_Next() can iterate the dict without allocating new objects
     //For all other objects supporting the Mapping protocol, we convert them to a
     //sequence of (key,value) tuples and iterate the list.
     //Note: for very large mappables that are iterable, we may be cheaper by using an iterator instead.
     const bool is_dict = PyDict_Check(v);
-    if (is_dict || IsMapping(v))
+    if (is_dict || info.mapping)
         if (const pyobj items = is_dict ? pyobj::wrap(v) : pyobj(PyMapping_Items(v))) {
             const uint32_t size = PyMapping_Size(v); //works for anything supporting the mapping protocol
             serialize_append_uint32(to, size);
@@ -322,7 +505,7 @@ std::string serialize_append_guess(serialize_output_t &to,
             type.append(mapped_type);
             return {};
         } //else (if items is null) we continue. This may happen if IsMapping(v) is true, but we are still not a map nevertheless.
-    if (PyList_Check(v) || IsSequence(v)) {
+    if (info.sequence) {
         const uint32_t size = PySequence_Size(v);
         serialize_append_uint32(to, size);
         if (size==0) {
@@ -337,13 +520,23 @@ std::string serialize_append_guess(serialize_output_t &to,
                 to.index() == 1 ? std::variant<size_t, char*>(std::in_place_index<1>, std::get<1>(to).first) :
                 to.index() == 2 ? std::variant<size_t, char*>(std::in_place_index<0>, std::get<2>(to)) :
                 std::variant<size_t, char*>(std::in_place_index<0>, 0);
+            //If the first element is of a class with '__dict_for_serialization__', elements of
+            //the very same (unmodified) class skip the type dispatch.
+            PyTypeObject* dfs_class = nullptr;
+            unsigned dfs_version_tag = 0;
             for (unsigned u = 0; u < size; u++) {
                 std::string tmp_type;
-                auto err = serialize_append_guess(to, tmp_type, pyobj{PySequence_GetItem(v, u)}, mode);
+                const pyobj item{PySequence_GetItem(v, u)};
+                auto err = dfs_class && item && Py_TYPE(item) == dfs_class && dfs_class->tp_version_tag == dfs_version_tag
+                    ? serialize_append_dict_for_serialization(to, tmp_type, item, mode, true)
+                    : serialize_append_guess(to, tmp_type, item, mode);
                 if (err.length())
                     return err;
-                if (u == 0)
+                if (u == 0) {
                     my_type = std::move(tmp_type);
+                    if ((dfs_class = DictForSerializationClass(item)))
+                        dfs_version_tag = dfs_class->tp_version_tag;
+                }
                 else if (my_type != tmp_type) {
                     if (mode == uf::impl::ParseMode::Normal)
                         return uf::concat("Cannot serialize: non-uniform types ('", my_type,
@@ -445,7 +638,7 @@ std::string serialize_append_guess(serialize_output_t &to,
         type.append("la");
         return {};
     }
-    if (IsEnum(v) && PyObject_HasAttrString(v, "_name_")) {
+    if (info.enumeration && PyObject_HasAttrString(v, "_name_")) {
         if (pyobj name = PyObject_GetAttrString(v, "_name_"))
             return serialize_append_guess(to, type, name, mode);
         std::string err = GetExceptionText();
@@ -497,6 +690,10 @@ std::string serialize_append(serialize_output_t &to, std::string_view &type, PyO
             return uf::concat("Cannot serialize '", v, "' as int.");
         Py_ssize_t val = PyLong_Check(v) ? PyLong_AsSsize_t(v) :
             v==Py_True;
+        if (val == -1 && PyErr_Occurred()) {
+            PyErr_Clear();
+            return uf::concat("Value '", to_string(v), "' does not fit into 64 bits for '", type.front(), "'.");
+        }
         if (type.front()=='i') {
             if (val<-0x100000000 || val>=0x100000000)
                 return uf::concat("Value '", val, "' does not fit into 32 bits for 'i'.");
@@ -589,8 +786,9 @@ std::string serialize_append(serialize_output_t &to, std::string_view &type, PyO
                 uf::impl::serialize_to(t, std::get<1>(to).first);
                 break;
             case 0:
-                std::get<0>(to).reserve(std::get<0>(to).length() + uf::impl::serialize_len(t));
-                char *p = std::get<0>(to).data() + std::get<0>(to).length(); //current pos at end
+                const size_t len = uf::impl::serialize_len(t);
+                std::get<0>(to).append(len, 0);
+                char *p = std::get<0>(to).data() + std::get<0>(to).length() - len;
                 uf::impl::serialize_to(t, p);
                 break;
             }
@@ -606,8 +804,9 @@ std::string serialize_append(serialize_output_t &to, std::string_view &type, PyO
             uf::impl::serialize_to(true, std::get<1>(to).first);
             break;
         case 0:
-            std::get<0>(to).reserve(std::get<0>(to).length() + 1);
-            char *p = std::get<0>(to).data() + std::get<0>(to).length(); //current pos at end
+            const size_t len = 1;
+            std::get<0>(to).append(len, 0);
+            char *p = std::get<0>(to).data() + std::get<0>(to).length() - len;
             uf::impl::serialize_to(true, p);
             break;
         }
@@ -628,8 +827,9 @@ std::string serialize_append(serialize_output_t &to, std::string_view &type, PyO
                 uf::impl::serialize_to(*error, std::get<1>(to).first);
                 break;
             case 0:
-                std::get<0>(to).reserve(std::get<0>(to).length() + uf::impl::serialize_len(*error));
-                char *p = std::get<0>(to).data() + std::get<0>(to).length(); //current pos at end
+                const size_t len = uf::impl::serialize_len(*error);
+                std::get<0>(to).append(len, 0);
+                char *p = std::get<0>(to).data() + std::get<0>(to).length() - len;
                 uf::impl::serialize_to(*error, p);
                 break;
             }
@@ -648,8 +848,9 @@ std::string serialize_append(serialize_output_t &to, std::string_view &type, PyO
             uf::impl::serialize_to(has_value, std::get<1>(to).first);
             break;
         case 0:
-            std::get<0>(to).reserve(std::get<0>(to).length() + 1);
-            char *p = std::get<0>(to).data() + std::get<0>(to).length(); //current pos at end
+            const size_t len = 1;
+            std::get<0>(to).append(len, 0);
+            char *p = std::get<0>(to).data() + std::get<0>(to).length() - len;
             uf::impl::serialize_to(has_value, p);
             break;
         }
@@ -682,6 +883,28 @@ std::string serialize_append(serialize_output_t &to, std::string_view &type, PyO
                 else
                     std::get<2>(to) += 4;
                 type.remove_prefix(1);
+            } else if (type.size() >= 2 && std::string_view("iIdb").find(type[1]) != std::string_view::npos
+                       && PyObject_CheckBuffer(v)) {
+                //An array of numbers: serialize in bulk, if the element type matches
+                Py_buffer view;
+                if (PyObject_GetBuffer(v, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT))
+                    return uf::concat("Cannot serialize '", to_string(v), "' as list: ", GetExceptionText());
+                const char elem = buffer_element_type(view);
+                const std::string fmt = view.format ? view.format : "B";
+                const bool integers = buffer_format(view) && std::string_view("bBhHiIlLqQnN").find(buffer_format(view)) != std::string_view::npos;
+                if (elem == type[1])
+                    serialize_append_buffer(to, view, elem);
+                PyBuffer_Release(&view);
+                if (elem == type[1]) {
+                    type.remove_prefix(2);
+                    return {};
+                }
+                //Other integers (e.g., unsigned ones) element by element, checking each value
+                if (integers && (type[1] == 'i' || type[1] == 'I'))
+                    if (pyobj list = PySequence_List(v))
+                        return serialize_append(to, type, list);
+                PyErr_Clear();
+                return uf::concat("Cannot serialize a buffer of format '", fmt, "' as '", type.substr(0, 2), "'.");
             } else
                 return uf::concat("Cannot serialize '", to_string(v), "' as list.");
             if (len==0) {
@@ -773,7 +996,8 @@ std::string serialize_append(serialize_output_t &to, std::string_view &type, PyO
     }
 }
 
-PyObject *deserialize_as_python(std::string_view original_type, std::string_view &type, const char *&p, const char *end)
+PyObject *deserialize_as_python(std::string_view original_type, std::string_view &type, const char *&p, const char *end,
+                                bool as_buffers)
 {
     if (type.empty()) {
         if (p==end)
@@ -838,7 +1062,7 @@ PyObject *deserialize_as_python(std::string_view original_type, std::string_view
         const char *p2 = val.value().data();
         std::string_view ty(val.type());
         try {
-            return deserialize_as_python(val.type(), ty, p2, p2+val.value().length());
+            return deserialize_as_python(val.type(), ty, p2, p2+val.value().length(), as_buffers);
         } catch (uf::value_error &e) {
             const size_t consumed = type.data()-original_type.data();
             e.types[0].prepend('(');
@@ -858,16 +1082,70 @@ PyObject *deserialize_as_python(std::string_view original_type, std::string_view
             p += len;
             type.remove_prefix(2);
             return ret;
+        } else if (as_buffers && type.length() >= 2 && std::string_view("iIdb").find(type[1]) != std::string_view::npos) {
+            //A memoryview over a bytearray, filled in one go
+            uint32_t size = 0;
+            if (uf::impl::deserialize_from<false>(p, end, size)) goto value_mismatch;
+            const char elem = type[1];
+            const size_t esize = elem == 'b' ? 1 : elem == 'i' ? 4 : 8;
+            if (size_t(end - p) < size * esize) goto value_mismatch;
+            pyobj bytes = PyByteArray_FromStringAndSize(nullptr, size * esize);
+            if (!bytes) return nullptr;
+            char *dst = PyByteArray_AS_STRING((PyObject *)bytes);
+            auto bulk = [&] {
+                switch (elem) {
+                case 'i': uf::impl::deserialize_bulk_from<false>(p, (int32_t *)dst, size); break;
+                case 'I': uf::impl::deserialize_bulk_from<false>(p, (int64_t *)dst, size); break;
+                case 'd': uf::impl::deserialize_bulk_from<false>(p, (double *)dst, size); break;
+                default: for (uint32_t u = 0; u < size; u++) dst[u] = *p++ != 0; break;
+                }
+            };
+            if (size * esize < 65536) bulk();
+            else {
+                Py_BEGIN_ALLOW_THREADS
+                bulk();
+                Py_END_ALLOW_THREADS
+            }
+            type.remove_prefix(2);
+            const pyobj view = PyMemoryView_FromObject(bytes);
+            if (!view) return nullptr;
+            return PyObject_CallMethod(view, "cast", "s", elem == 'b' ? "?" : elem == 'i' ? "i" : elem == 'I' ? "q" : "d");
         } else {
             uint32_t size = 0;
             if (uf::impl::deserialize_from<false>(p, end, size)) goto value_mismatch;
             pyobj val = PyList_New(size);
             type.remove_prefix(1);
-            if (size) {
+            if (size && std::string_view("iIds").find(type.front()) != std::string_view::npos) {
+                //Lists of primitives in a tight loop, without dispatching on the type for each element
+                const char elem = type.front();
+                const size_t esize = elem == 'i' ? 4 : elem == 's' ? 0 : 8;
+                if (esize && size_t(end - p) < size * esize) goto value_mismatch;
+                for (unsigned u = 0; u<size; u++) {
+                    PyObject *o;
+                    switch (elem) {
+                    case 'i': o = PyLong_FromLong(int32_t(uf::impl::get_wire32<false>(p))); p += 4; break;
+                    case 'I': o = PyLong_FromLongLong(int64_t(uf::impl::get_wire64<false>(p))); p += 8; break;
+                    case 'd': o = PyFloat_FromDouble(uf::impl::get_wire_double(p)); p += 8; break;
+                    default: {
+                        uint32_t len = 0;
+                        if (uf::impl::deserialize_from<false>(p, end, len) || size_t(end - p) < len) goto value_mismatch;
+                        o = PyUnicode_FromStringAndSize(p, len);
+                        if (!o) {
+                            PyErr_Clear();
+                            o = PyByteArray_FromStringAndSize(p, len);
+                        }
+                        p += len;
+                    }
+                    }
+                    if (!o) return nullptr;
+                    PyList_SET_ITEM((PyObject *)val, u, o);
+                }
+                type.remove_prefix(1);
+            } else if (size) {
                 const std::string_view my_type = type;
                 for (unsigned u = 0; u<size; u++) {
                     type = my_type;
-                    PyList_SetItem(val, u, deserialize_as_python(original_type, type, p, end));
+                    PyList_SetItem(val, u, deserialize_as_python(original_type, type, p, end, as_buffers));
                 }
             } else
                 if (auto [l, err] = uf::impl::parse_type(type, false); !err)
@@ -887,8 +1165,8 @@ PyObject *deserialize_as_python(std::string_view original_type, std::string_view
             for (unsigned u = 0; u<size; u++) {
                 type = my_type;
                 //These may throw
-                const pyobj key = deserialize_as_python(original_type, type, p, end);
-                const pyobj value = deserialize_as_python(original_type, type, p, end);
+                const pyobj key = deserialize_as_python(original_type, type, p, end, as_buffers);
+                const pyobj value = deserialize_as_python(original_type, type, p, end, as_buffers);
                 if (-1==PyDict_SetItem(val, key, value)) //does NOT steal a ref
                     throw uf::value_mismatch_error(uf::concat("Error in inserting to dictionary: '", key, "'."),
                                                    original_type, type.data()-original_type.data());
@@ -912,7 +1190,7 @@ PyObject *deserialize_as_python(std::string_view original_type, std::string_view
         }
         pyobj val = PyTuple_New(size);
         for (unsigned u = 0; u<size; u++)
-            PyTuple_SetItem(val, u, deserialize_as_python(original_type, type, p, end));
+            PyTuple_SetItem(val, u, deserialize_as_python(original_type, type, p, end, as_buffers));
         return val.release();
     }
     case 'x':
@@ -923,7 +1201,7 @@ PyObject *deserialize_as_python(std::string_view original_type, std::string_view
         type.remove_prefix(1);
         if (has_value) {
             if (is_void) Py_RETURN_NONE;
-            return deserialize_as_python(original_type, type, p, end);
+            return deserialize_as_python(original_type, type, p, end, as_buffers);
         }
         if (!is_void) {
             if (auto [l, err] = uf::impl::parse_type(type, false); !err)
@@ -934,18 +1212,20 @@ PyObject *deserialize_as_python(std::string_view original_type, std::string_view
         }
     } [[fallthrough]]; //fallthrough to error
     case 'e': {
-        auto ret = [] {
+        //The Error type is a static object of the module, so we can look it up only once.
+        static PyObject *err_type = nullptr;
+        if (!err_type) {
             auto mod = PyDict_GetItemString(PyImport_GetModuleDict(), UF_MODNAME);
             if (!mod)
                 throw uf::error("Module '" UF_MODNAME "' needs to be loaded to deserialize an " UF_ERRNAME ".");
-            auto err_type = PyDict_GetItemString(PyModule_GetDict(mod), UF_ERRNAME_ONLY);
+            err_type = PyDict_GetItemString(PyModule_GetDict(mod), UF_ERRNAME_ONLY);
             if (!err_type)
                 throw uf::error("Module '" UF_MODNAME "' lacks " UF_ERRNAME ".");
-            //all borrowed references so far
-            if (auto ret = PyObject_Call(err_type, nullptr, nullptr))
-                return ret;
+            Py_INCREF(err_type);
+        }
+        auto ret = PyObject_CallNoArgs(err_type);
+        if (!ret)
             throw uf::error(UF_ERRNAME "() call failed.");
-        }();
         if (!ret)
             return ret;
         if (uf::impl::deserialize_from<false>(p, end, *((uf_error_value*)ret)->error)) {
@@ -960,7 +1240,7 @@ PyObject *deserialize_as_python(std::string_view original_type, std::string_view
         if (uf::impl::deserialize_from<false>(p, end, has_value)) goto value_mismatch;
         type.remove_prefix(1);
         if (has_value)
-            return deserialize_as_python(original_type, type, p, end);
+            return deserialize_as_python(original_type, type, p, end, as_buffers);
         if (auto [l, err] = uf::impl::parse_type(type, false); !err)
             type.remove_prefix(l);
         else
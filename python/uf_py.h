@@ -36,6 +36,17 @@ inline std::string to_string(PyObject *v)
     return ret;
 }
 
+/** Owning reference to a Python object.*/
+class pyobj {
+    std::unique_ptr<PyObject, void(*)(PyObject*)> p;
+public:
+    pyobj(PyObject* o = nullptr) noexcept : p{o, [](PyObject* x) { Py_XDECREF(x); }} {}
+    static pyobj wrap(PyObject* o) noexcept { Py_XINCREF(o); return pyobj(o); }// assumes borrowed references, like PyArg_ParseTuple()
+    operator PyObject* () const noexcept { return p.get(); }
+    explicit operator bool() const noexcept { return bool(p); }
+    PyObject* release() noexcept { return p.release(); }
+};
+
 namespace
 {
 
@@ -85,6 +96,10 @@ using serialize_output_t = std::variant<
 std::string serialize_append_guess(serialize_output_t &to,
                                    std::string& type, PyObject* v, uf::impl::ParseMode mode = uf::impl::ParseMode::Liberal);
 
+/** Drops what serialize_append_guess() cached about classes if a class was registered with
+ * an ABC since the last call. Call before serializing a top-level value.*/
+void RevalidateClassInfo();
+
 /** Attempts to serialize a python variable to a specific type or determine
  * the number of bytes needed.
  * @param [out] to The string to append the type description to or the length
@@ -101,16 +116,19 @@ std::string serialize_append_guess(serialize_output_t &to,
 std::string serialize_append(serialize_output_t &to, std::string_view &type, PyObject* v);
 
 /** Deserialize memory into a python object.
+ * If 'as_buffers' is set, lists of 'i', 'I', 'd' and 'b' are returned as a memoryview
+ * (of format 'i', 'q', 'd' and '?', respectively) over a bytearray, filled in one go.
  * We throw a value_error on problems or an error on x<> containing errors.*/
-PyObject *deserialize_as_python(std::string_view original_type, std::string_view &type, const char *&p, const char *end);
+PyObject *deserialize_as_python(std::string_view original_type, std::string_view &type, const char *&p, const char *end,
+                                bool as_buffers = false);
 
 /** Deserialize memory into a python object.
  * We throw value_error on an error (and then release any python references taken so far. */
-inline PyObject *deserialize_as_python(const uf::any_view &value)
+inline PyObject *deserialize_as_python(const uf::any_view &value, bool as_buffers = false)
 {
     const char *p = value.value().data();
     std::string_view ty(value.type());
-    return deserialize_as_python(value.type(), ty, p, p + value.value().length());
+    return deserialize_as_python(value.type(), ty, p, p + value.value().length(), as_buffers);
 }
 
 /** Parses through a Python object for serialization or length.
@@ -128,6 +146,7 @@ inline std::string serialize_as_helper(PyObject* v, std::optional<std::string_vi
                                        serialize_output_t &value)
 {
     assert(value.index()<=2);
+    RevalidateClassInfo();
     std::string type;
     if (t) {
         type = t.value();
@@ -57,12 +57,14 @@ PyObject *python_serialize(PyObject *, PyObject *args, PyObject *kwargs) {
     }
 }
 
-PyObject *python_deserialize(PyObject *, PyObject *args) {
+PyObject *python_deserialize(PyObject *, PyObject *args, PyObject *kwargs) {
     Py_buffer buff;
-    if (!PyArg_ParseTuple(args, "y*", &buff))
+    int buffers = false;
+    static char const *kws[] = {"data", "buffers", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*|p", const_cast<char **>(kws), &buff, &buffers))
         return nullptr;
     try {
-        PyObject *ret = deserialize_as_python(uf::any_view{uf::from_raw, std::string_view{(char*)buff.buf, (size_t)buff.len}});
+        PyObject *ret = deserialize_as_python(uf::any_view{uf::from_raw, std::string_view{(char*)buff.buf, (size_t)buff.len}}, buffers);
         PyBuffer_Release(&buff);
         return ret;
     } catch (uf::value_error const &e) {
@@ -80,9 +82,196 @@ PyObject *python_deserialize(PyObject *, PyObject *args) {
     }
 }
 
+PyObject *python_serialize_many(PyObject *, PyObject *args, PyObject *kwargs) {
+    PyObject *iterable = nullptr;
+    int liberal = true;
+    const char *type_ptr = nullptr;
+    Py_ssize_t type_len = 0;
+    static char const *kws[] = {"values", "liberal", "type", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|pz#", const_cast<char **>(kws),
+                                     &iterable, &liberal, &type_ptr, &type_len))
+        return nullptr;
+    std::optional<std::string_view> type;
+    if (type_ptr) {
+        type = std::string_view(type_ptr, type_len);
+        if (auto [len, problem] = uf::impl::parse_type(type_ptr, type_ptr + type_len, true); !!problem || len < size_t(type_len))
+            return err(PyExc_ValueError, uf::concat("Invalid typestring: '", *type, "'."));
+    }
+    PyObject *iter = PyObject_GetIter(iterable);
+    if (!iter) return nullptr;
+    PyObject *ret = PyList_New(0);
+    if (!ret) { Py_DECREF(iter); return nullptr; }
+    //Reused for all items, so that after the first few we allocate only the resulting bytes objects.
+    serialize_output_t value(std::in_place_index<0>);
+    size_t index = 0;
+    try {
+        while (PyObject *item = PyIter_Next(iter)) {
+            std::get<0>(value).clear();
+            std::string ty;
+            try {
+                ty = serialize_as_helper(item, type, liberal ? uf::impl::ParseMode::Liberal : uf::impl::ParseMode::Normal, value);
+            } catch (...) {
+                Py_DECREF(item);
+                throw;
+            }
+            Py_DECREF(item);
+            const std::string &val = std::get<0>(value);
+            PyObject *bytes = PyBytes_FromStringAndSize(nullptr, 8 + ty.size() + val.size());
+            if (!bytes || PyList_Append(ret, bytes)) {
+                Py_XDECREF(bytes);
+                Py_DECREF(iter);
+                Py_DECREF(ret);
+                return nullptr;
+            }
+            Py_DECREF(bytes); //the list holds it
+            char *p = PyBytes_AS_STRING(bytes);
+            uf::impl::serialize_to(std::string_view(ty), p);
+            uf::impl::serialize_to(uint32_t(val.size()), p);
+            if (val.size() < 65536)
+                memcpy(p, val.data(), val.size());
+            else {
+                Py_BEGIN_ALLOW_THREADS
+                memcpy(p, val.data(), val.size());
+                Py_END_ALLOW_THREADS
+            }
+            index++;
+        }
+        Py_DECREF(iter);
+        if (PyErr_Occurred()) { Py_DECREF(ret); return nullptr; }
+        return ret;
+    } catch (uf::value_error const &e) {
+        Py_DECREF(iter); Py_DECREF(ret);
+        return err(PyExc_ValueError, uf::concat("Item #", index, ": ", e.what()));
+    } catch (uf::api_error const &e) {
+        Py_DECREF(iter); Py_DECREF(ret);
+        return err(PyExc_AttributeError, uf::concat("Item #", index, ": ", e.what()));
+    } catch (std::bad_alloc const &e) {
+        Py_DECREF(iter); Py_DECREF(ret);
+        return err(PyExc_MemoryError, e.what());
+    } catch (std::exception const &e) {
+        Py_DECREF(iter); Py_DECREF(ret);
+        return err(PyExc_RuntimeError, e.what());
+    } catch (...) {
+        Py_DECREF(iter); Py_DECREF(ret);
+        return err(PyExc_RuntimeError, "unhandled C++ exception of type "+current_exception_type());
+    }
+}
+
+PyObject *python_deserialize_many(PyObject *, PyObject *args, PyObject *kwargs) {
+    PyObject *list = nullptr;
+    const char *type_ptr = nullptr;
+    Py_ssize_t type_len = 0;
+    int buffers = false;
+    static char const *kws[] = {"data", "type", "buffers", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|z#p", const_cast<char **>(kws),
+                                     &list, &type_ptr, &type_len, &buffers))
+        return nullptr;
+    const std::optional<std::string_view> type = type_ptr ? std::optional<std::string_view>(std::string_view(type_ptr, type_len)) : std::nullopt;
+    if (type)
+        if (auto [len, problem] = uf::impl::parse_type(type_ptr, type_ptr + type_len, true); !!problem || len < size_t(type_len))
+            return err(PyExc_ValueError, uf::concat("Invalid typestring: '", *type, "'."));
+    const pyobj seq = PySequence_Fast(list, "deserialize_many() expects a sequence of bytes-like objects.");
+    if (!seq) return nullptr;
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE((PyObject *)seq);
+    //Hold the buffers of all items for the duration of the call.
+    std::vector<Py_buffer> views;
+    views.reserve(n);
+    struct releaser {
+        std::vector<Py_buffer> &v;
+        ~releaser() { for (auto &b : v) PyBuffer_Release(&b); }
+    } release_views{views};
+    for (Py_ssize_t i = 0; i < n; i++) {
+        Py_buffer b;
+        if (PyObject_GetBuffer(PySequence_Fast_GET_ITEM((PyObject *)seq, i), &b, PyBUF_SIMPLE))
+            return nullptr;
+        views.push_back(b);
+    }
+    //Validate all items without the GIL
+    std::vector<uf::any_view> values(n);
+    std::string error;
+    Py_ssize_t index = 0;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        for (; index < n; index++) {
+            const std::string_view data((const char *)views[index].buf, views[index].len);
+            if (type) values[index] = uf::any_view(uf::from_type_value, *type, data);
+            else values[index] = uf::any_view(uf::from_raw, data);
+        }
+    } catch (uf::value_error const &e) {
+        error = uf::concat("Item #", index, ": ", e.what());
+    } catch (std::exception const &e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (error.size())
+        return err(PyExc_ValueError, error);
+    pyobj ret = PyList_New(n);
+    if (!ret) return nullptr;
+    try {
+        for (index = 0; index < n; index++) {
+            PyObject *o = deserialize_as_python(values[index], buffers);
+            if (!o) return nullptr;
+            PyList_SET_ITEM((PyObject *)ret, index, o);
+        }
+        return ret.release();
+    } catch (uf::value_error const &e) {
+        return err(PyExc_ValueError, uf::concat("Item #", index, ": ", e.what()));
+    } catch (std::bad_alloc const &e) {
+        return err(PyExc_MemoryError, e.what());
+    } catch (std::exception const &e) {
+        return err(PyExc_RuntimeError, e.what());
+    } catch (...) {
+        return err(PyExc_RuntimeError, "unhandled C++ exception of type "+current_exception_type());
+    }
+}
+
+const char *stat_event_name(uf::stat_event e) {
+    switch (e) {
+    case uf::stat_event::get: return "get";
+    case uf::stat_event::convert: return "convert";
+    case uf::stat_event::converts_to: return "converts_to";
+    case uf::stat_event::converts_to_failed: return "converts_to_failed";
+    case uf::stat_event::policy_refused: return "policy_refused";
+    case uf::stat_event::scan: return "scan";
+    case uf::stat_event::error: return "error";
+    case uf::stat_event::any_alloc: return "any_alloc";
+    }
+    return "unknown";
+}
+
+PyObject *python_stats(PyObject *, PyObject *) {
+    try {
+        const auto stats = uf::stats_snapshot();
+        pyobj ret = PyList_New(stats.size());
+        if (!ret) return nullptr;
+        Py_ssize_t i = 0;
+        for (const auto &[k, v] : stats) {
+            PyObject *o = Py_BuildValue("(sss#s#KK)", stat_event_name(k.event),
+                                        k.reason ? uf::to_string(k.reason).c_str() : "",
+                                        k.type.data(), Py_ssize_t(k.type.size()),
+                                        k.target.data(), Py_ssize_t(k.target.size()),
+                                        (unsigned long long)v.calls, (unsigned long long)v.bytes);
+            if (!o) return nullptr;
+            PyList_SET_ITEM((PyObject *)ret, i++, o);
+        }
+        return ret.release();
+    } catch (std::bad_alloc const &e) {
+        return err(PyExc_MemoryError, e.what());
+    }
+}
+
+PyObject *python_stats_reset(PyObject *, PyObject *) {
+    uf::stats_reset();
+    Py_RETURN_NONE;
+}
+
 PyMethodDef methods[] = {
+    {"serialize_many", (PyCFunction)python_serialize_many, METH_VARARGS | METH_KEYWORDS, "Serialize each value of an iterable into a bytes object: 'serialize_many(values, liberal=True, type=None)'. Returns a list with the same content as calling 'serialize' on each value, but the typestring is checked only once and no intermediate copies are made."},
+    {"deserialize_many", (PyCFunction)python_deserialize_many, METH_VARARGS | METH_KEYWORDS, "Deserialize a sequence of bytes-like objects into a list of Python values: 'deserialize_many(data, type=None, buffers=False)'. Each item is a result of 'serialize', or if a type is given, a serialized value of that type (as returned by 'serialize(..., type_value=True)'). All items are validated with the GIL released before Python objects are created. See 'deserialize' for 'buffers'."},
     {"serialize", (PyCFunction)python_serialize, METH_VARARGS | METH_KEYWORDS, "Serialize the Python value into a bytes object in memory: 'serialize(value, liberal=True, type=None, type_value=False)'. Setting liberal allows serializing heterogeneous lists and dicts with 'la' or 'maa' types; You can specify a wanted type (ValueError is raised if 'value' is not that type). Returns a bytes object that contains both type and value encoded and can be fed to 'deserialize', but if type_value is True, a two-element tuple is returned with 2 bytes objects separate for typestring and serialized value."},
-    {"deserialize", python_deserialize, METH_VARARGS, "Deserialize a bytes object into a Python value: 'deserialize(bytes)'."},
+    {"deserialize", (PyCFunction)python_deserialize, METH_VARARGS | METH_KEYWORDS, "Deserialize a bytes object into a Python value: 'deserialize(bytes, buffers=False)'. If buffers is True, lists of integers, floats and bools ('li', 'lI', 'ld' and 'lb') are returned as memoryview objects of format 'i', 'q', 'd' and '?' (decoded in one go, usable with numpy.asarray() without copy) instead of Python lists. Objects exposing the buffer protocol with such formats (array.array, memoryview, numpy arrays) are serialized as lists by 'serialize' without iterating their elements."},
+    {"stats", (PyCFunction)python_stats, METH_NOARGS, "Return the statistics counted by the C++ library as a list of tuples: (event, missing flag, type, target type, calls, bytes). Empty unless the library was built with --enable-stats. Events are 'get', 'convert', 'converts_to', 'converts_to_failed', 'policy_refused', 'scan', 'error' and 'any_alloc'; see uf::stat_event."},
+    {"stats_reset", (PyCFunction)python_stats_reset, METH_NOARGS, "Zero the statistics counters of the C++ library. Not exact if other threads are counting meanwhile."},
     {0},
 };
 
@@ -7,6 +7,14 @@
 #include <list>
 #include <span>
 #include <ranges>
+#include <filesystem>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include <thread>
+#include <cmath>
+#include <set>
+#include <unordered_set>
 
 using namespace std::string_view_literals;
 
@@ -439,6 +447,82 @@ TEST_CASE("span, array_inserter")
     REQUIRE_THROWS_AS(ser.get(a2), uf::value_mismatch_error);
 }
 
+TEST_CASE("bulk lists of primitives")
+{
+    static_assert(uf::impl::is_bulk_serializable_container<std::span<const int64_t>>::value);
+    static_assert(!uf::impl::is_bulk_serializable_container<std::list<int64_t>>::value);
+    static_assert(!uf::impl::is_bulk_deserializable_container<std::span<const double>>::value);
+    const std::vector<int64_t> vI{1, -2, 0x0102030405060708};
+    const std::vector<int32_t> vi{1, -2, 0x01020304};
+    const std::vector<double> vd{1.5, -2.25};
+    const std::vector<char> vc{'a', 'b'};
+    //bulk and element-wise encoding must give the same bytes
+    CHECK(uf::serialize(vI) == uf::serialize(std::list<int64_t>(vI.begin(), vI.end())));
+    CHECK(uf::serialize(vi) == uf::serialize(std::list<int32_t>(vi.begin(), vi.end())));
+    CHECK(uf::serialize(vd) == uf::serialize(std::list<double>(vd.begin(), vd.end())));
+    CHECK(uf::serialize(vc) == uf::serialize(std::string("ab")));
+    CHECK(uf::impl::serialize_len(std::span<const int64_t>(vI)) == 4 + 3 * 8);
+    CHECK(uf::serialize(std::span<const int64_t>(vI)) == uf::serialize(vI));
+    CHECK(uf::serialize(vi)== "\0\0\0\3\0\0\0\1\xff\xff\xff\xfe\1\2\3\4"sv);
+
+    std::vector<int64_t> I{7, 7, 7, 7, 7};
+    uf::deserialize(uf::serialize(vI), I);
+    CHECK(I == vI);
+    std::vector<int32_t> i;
+    uf::deserialize(uf::serialize(vi), i);
+    CHECK(i == vi);
+    std::vector<double> d;
+    uf::deserialize(uf::serialize(vd), d);
+    CHECK(d == vd);
+    std::vector<char> c;
+    uf::deserialize(uf::serialize(vc), c);
+    CHECK(c == vc);
+    //overrun by the count must be detected before resize
+    CHECK_THROWS_AS(uf::deserialize("\0\0\0\5\0\0\0\1"sv, i), uf::value_mismatch_error);
+    CHECK_THROWS_AS(uf::deserialize("\xff\xff\xff\xff"sv, d), uf::value_mismatch_error);
+}
+
+TEST_CASE("pmr allocators")
+{
+    std::pmr::monotonic_buffer_resource mr;
+    const auto on_mr = [&mr](const std::pmr::string &s) { return s.get_allocator().resource() == &mr; };
+    const std::string long_str(100, 'x');
+    CHECK(uf::serialize_type<std::pmr::string>() == "s");
+    CHECK(uf::serialize_type<std::pmr::map<std::pmr::string, std::pmr::vector<int>>>() == "msli");
+    CHECK(uf::serialize(std::pmr::string(long_str)) == uf::serialize(long_str));
+    CHECK(uf::any(std::pmr::string("abc")).print() == "<s>\"abc\"");
+
+    //With the default resource disabled, any allocation not from 'mr' would throw
+    std::pmr::memory_resource *const old_default = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    const std::string sv = uf::serialize(std::vector<std::string>{"a", long_str});
+    const auto v = uf::deserialize_as<std::pmr::vector<std::pmr::string>>(sv, &mr);
+    REQUIRE(v.size() == 2);
+    CHECK(std::string_view(v[1]) == long_str);
+    CHECK(on_mr(v[0]));
+    CHECK(on_mr(v[1]));
+    const std::string sm = uf::serialize(std::map<std::string, std::vector<int>>{{long_str, {1, 2, 3}}});
+    const auto m = uf::deserialize_as<std::pmr::map<std::pmr::string, std::pmr::vector<int>>>(sm, &mr);
+    REQUIRE(m.size() == 1);
+    CHECK(on_mr(m.begin()->first));
+    CHECK(m.begin()->second.get_allocator().resource() == &mr);
+    CHECK(m.begin()->second == std::pmr::vector<int>({1, 2, 3}, &mr));
+    //converting path: llc -> ls
+    const uf::any allc(std::vector<std::vector<char>>{{'a', 'b'}, std::vector<char>(long_str.begin(), long_str.end())});
+    std::pmr::vector<std::pmr::string> v2(&mr);
+    allc.get(v2, uf::allow_converting_aux);
+    REQUIRE(v2.size() == 2);
+    CHECK(v2[0] == "ab");
+    CHECK(on_mr(v2[1]));
+    std::pmr::set_default_resource(old_default);
+
+    const uf::any a(std::tuple{1, long_str});
+    const uf::any_view c = a.copy_to(&mr);
+    CHECK(c == a);
+    CHECK(c.value().data() != a.value().data());
+    CHECK(c.get_as<std::tuple<int, std::string>>() == std::tuple{1, long_str});
+    CHECK(uf::any_view().copy_to(&mr).is_void());
+}
+
 struct myexc : public std::runtime_error { using runtime_error::runtime_error; };
 
 struct locking_struct
@@ -533,6 +617,142 @@ TEST_CASE("before/after serialization")
     CHECK_THROWS_WITH(uf::serialize(mil3), "aaa");
     REQUIRE(mil3[0].a.count == 0);
     CHECK(mil3[0].c.count == 0);
+
+    uf::serialize_sink sink;
+    CHECK(uf::serialize(sink, vl2) == s);
+    REQUIRE(vl2[0].a.count == 0);
+    CHECK_THROWS_WITH(uf::serialize(sink, mil3), "aaa");
+    REQUIRE(mil3[0].a.count == 0);
+    CHECK(mil3[0].c.count == 0);
+}
+
+TEST_CASE("serialize_sink")
+{
+    struct S {
+        std::map<std::string, std::list<int>> m{{"a", {1, 2}}, {"bb", {}}};
+        std::optional<std::vector<double>> od{{1.5}};
+        std::unique_ptr<std::string> ps = std::make_unique<std::string>("ps");
+        const char *cs = "cs";
+        uf::expected<int> ei = 3;
+        uf::expected<void> ev = uf::error_value("t", "m");
+        uf::any a{std::tuple{1, 'c'}};
+        std::array<int64_t, 2> ar{5, 6};
+        std::vector<std::monostate> vm{{}, {}};
+        std::vector<bool> vb{true, false};
+        auto tuple_for_serialization() const noexcept { return std::tie(m, od, ps, cs, ei, ev, a, ar, vm, vb); }
+    } s;
+    uf::serialize_sink sink(4); //force a few reallocations
+    CHECK(uf::serialize(sink, s) == uf::serialize(s));
+    const size_t cap = sink.capacity();
+    CHECK(uf::serialize(sink, 42) == uf::serialize(42));
+    CHECK(sink.capacity() == cap);
+    CHECK(uf::serialize(sink, std::tuple<>{}).empty());
+    auto v = std::views::iota(0, 3) | std::views::transform([](int i) { return i * 2; });
+    CHECK(uf::serialize(sink, v) == uf::serialize(std::vector<int>{0, 2, 4}));
+    CHECK(sink.release() == uf::serialize(std::vector<int>{0, 2, 4}));
+    CHECK(sink.empty());
+}
+
+TEST_CASE("serialize_iov")
+{
+    const std::string big(100, 'x');
+    const uf::any a(std::string(50, 'y'));
+    const std::vector<double> vd(20, 1.5);
+    const std::string small = "small";
+    const std::vector<int64_t> vI(20, 3);
+    auto t = std::tie(big, big, small, a, vd, vI);
+    auto iov = uf::serialize_iov(t, 32);
+    CHECK(iov.size() == uf::serialize(t).size());
+    CHECK(iov.flatten() == uf::serialize(t));
+    const auto segs = iov.segments();
+    REQUIRE(segs.size() == 9);
+    CHECK(segs[0].size() == 4);
+    CHECK(segs[1].data() == big.data());
+    CHECK(segs[3].data() == big.data());
+    CHECK(segs[5].data() == a.value().data());
+    CHECK(segs[7].data() == (const char *)vd.data());
+    auto moved = std::move(iov);
+    CHECK(moved.flatten() == uf::serialize(t));
+    CHECK(uf::serialize_iov(t, 1000).segments().size() == 1);
+    CHECK(uf::serialize_iov(std::tuple<>{}).segments().empty());
+
+    //after_serialization is deferred until the segments are released
+    std::vector<locking_struct2> vl2(2);
+    {
+        auto iov2 = uf::serialize_iov(vl2);
+        CHECK(vl2[0].a.count == 1);
+        CHECK(iov2.flatten() == uf::serialize(vl2));
+        auto iov3 = std::move(iov2);
+        CHECK(vl2[1].a.count == 1);
+    }
+    CHECK(vl2[0].a.count == 0);
+    CHECK(vl2[1].a.count == 0);
+    std::map<int, locking_struct3> mil3;
+    mil3[0];
+    CHECK_THROWS_WITH(uf::serialize_iov(mil3), "aaa");
+    CHECK(mil3[0].a.count == 0);
+    //an exception from the after_serialization pass is reported by release() only
+    struct late_throw {
+        locking_struct a;
+        bool armed = false;
+        auto tuple_for_serialization() const { if (armed) throw myexc("ccc"); return std::tie(a); }
+    } lt;
+    {
+        auto iov4 = uf::serialize_iov(lt);
+        auto iov5 = uf::serialize_iov(lt);
+        lt.armed = true;
+        CHECK_THROWS_WITH(iov4.release(), "ccc");
+        CHECK(iov4.segments().empty());
+        iov5 = uf::serialized_iov();
+        auto iov6 = uf::serialize_iov(std::tuple<>{});
+        lt.armed = false;
+        iov6 = uf::serialize_iov(lt);
+        lt.armed = true;
+    }
+    CHECK(lt.a.count == 3); //none of the three serializations released while armed could unlock
+}
+
+TEST_CASE("little-endian wire variant")
+{
+    CHECK(uf::serialize(int32_t(0x01020304), uf::use_tags, uf::little_endian) == std::string("\4\3\2\1", 4));
+    CHECK(uf::serialize(int32_t(0x01020304)) == std::string("\1\2\3\4", 4));
+    CHECK(uf::serialize(3.14, uf::use_tags, uf::little_endian) == uf::serialize(3.14));
+    const std::vector<int64_t> vI = {1, -2, 0x0102030405060708};
+    const std::string svI = uf::serialize(vI, uf::use_tags, uf::little_endian);
+    if constexpr (std::endian::native == std::endian::little)
+        CHECK(svI.substr(4) == std::string_view(reinterpret_cast<const char*>(vI.data()), vI.size() * 8));
+
+    using T = std::tuple<std::vector<int64_t>, std::map<std::string, std::optional<int>>, uf::expected<double>,
+                         uf::expected<int>, uf::any, std::vector<std::pair<char, uint32_t>>, bool>;
+    const T t = {vI, {{"a", 1}, {"b", {}}}, 2.5, uf::error_value("type", "msg", uf::any(42)), uf::any(std::tuple{1, "s"}),
+                 {{'x', 7}, {'y', 8}}, true};
+    const std::string le = uf::serialize(t, uf::use_tags, uf::little_endian);
+    const std::string be = uf::serialize(t);
+    CHECK(le.size() == be.size());
+    CHECK(le != be);
+    CHECK(uf::serialize(uf::deserialize_as<T>(le, false, uf::use_tags, uf::little_endian)) == be);
+    const std::string_view type = uf::serialize_type<T>();
+    CHECK(uf::convert_byte_order(type, le, true) == be);
+    CHECK(uf::convert_byte_order(type, be, false) == le);
+    //the contained any stays in the standard encoding
+    CHECK(std::get<4>(uf::deserialize_as<T>(le, false, uf::use_tags, uf::little_endian)).get_as<std::tuple<int, std::string>>() ==
+          std::tuple{1, "s"});
+
+    //single-pass serialization
+    uf::serialize_sink sink;
+    CHECK(uf::serialize(sink, t, uf::use_tags, uf::little_endian) == le);
+    const std::vector<int32_t> big(100, 0x01020304);
+    auto iov = uf::serialize_iov(big, 32, uf::use_tags, uf::little_endian);
+    CHECK(iov.flatten() == uf::serialize(big, uf::use_tags, uf::little_endian));
+    if constexpr (std::endian::native == std::endian::little) {
+        REQUIRE(iov.segments().size() == 2);
+        CHECK(iov.segments()[1].data() == reinterpret_cast<const char *>(big.data()));
+    }
+
+    CHECK_THROWS_AS((void)uf::convert_byte_order(type, std::string_view(le).substr(1), true), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)uf::convert_byte_order("i", "12345", true), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)uf::convert_byte_order("t2i", "1234", true), uf::typestring_error);
+    CHECK(uf::convert_byte_order("", "", true) == "");
 }
 
 struct custom_des
@@ -575,6 +795,112 @@ TEST_CASE("before/after deserialization")
     CHECK(int(c.i) == 42);
 }
 
+struct fixed_rec {
+    bool b; char c; int32_t i; int64_t I; double d; float f; uint16_t u; std::array<std::pair<int8_t, uint32_t>, 2> a;
+    auto tuple_for_serialization() const noexcept { return std::tie(b, c, i, I, d, f, u, a); }
+    auto tuple_for_serialization() noexcept { return std::tie(b, c, i, I, d, f, u, a); }
+    bool operator==(const fixed_rec&) const = default;
+};
+
+TEST_CASE("fixed layout")
+{
+    static_assert(uf::impl::fixed_layout_len<true, fixed_rec>() == 1+1+4+8+8+8+4+2*(1+4));
+    static_assert(uf::impl::fixed_layout_len<false, std::tuple<bool, double, int[2]>>() == 1+8+8);
+    static_assert(!uf::impl::is_fixed_layout_v<false, fixed_rec>); //length is taken via tuple_for_serialization()
+    static_assert(!uf::impl::is_fixed_layout_v<true, std::tuple<int, std::string>>);
+    static_assert(!uf::impl::is_fixed_layout_v<true, std::optional<int>>);
+    static_assert(!uf::impl::is_fixed_layout_v<true, char[4]>); //a string
+    static_assert(!uf::impl::is_fixed_layout_v<true, custom_des>); //has after_deserialization()
+    const fixed_rec r{true, 'x', -42, -4242, 4.25, 1.5f, 65535, {{{-1, 7}, {2, 0xffffffff}}}};
+    const std::string s = uf::serialize(r);
+    CHECK(s.size() == uf::impl::fixed_layout_len<true, fixed_rec>());
+    fixed_rec r2{};
+    CHECK_NOTHROW(uf::deserialize(s, r2));
+    CHECK(r2 == r);
+    //the same via a little-endian wire
+    const std::string sle = uf::serialize(r, uf::use_tags, uf::little_endian);
+    r2 = {};
+    CHECK_NOTHROW(uf::deserialize(sle, r2, false, uf::use_tags, uf::little_endian));
+    CHECK(r2 == r);
+    //truncated input is detected by the up-front check
+    for (size_t len = 0; len < s.size(); len++)
+        CHECK_THROWS_AS(uf::deserialize(std::string_view(s).substr(0, len), r2), uf::value_mismatch_error);
+    //lists of them check the size of all elements at once
+    std::vector<fixed_rec> v(3, r), v2;
+    v[1].i = 1;
+    const std::string sv = uf::serialize(v);
+    CHECK_NOTHROW(uf::deserialize(sv, v2));
+    CHECK(v2 == v);
+    CHECK_THROWS_AS(uf::deserialize(std::string_view(sv).substr(0, sv.size()-1), v2), uf::value_mismatch_error);
+    std::map<int, std::pair<bool, double>> m{{1, {true, 1.5}}, {2, {false, 2.5}}}, m2;
+    CHECK_NOTHROW(uf::deserialize(uf::serialize(m), m2));
+    CHECK(m2 == m);
+    CHECK(uf::impl::serialize_len(m) == 4 + 2*(4+1+8));
+    //conversion from any still works
+    CHECK(uf::any(r).get_as<fixed_rec>() == r);
+}
+
+TEST_CASE("reuse capacity")
+{
+    using rec = std::tuple<int, std::string, std::vector<double>>;
+    std::vector<rec> big = {{1, std::string(100, 'a'), std::vector<double>(50, 1)}, {2, std::string(200, 'b'), {}}};
+    std::vector<rec> small = {{3, "c", {2.5}}};
+    std::vector<rec> v;
+    uf::deserialize(uf::serialize(big), v, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(v == big);
+    const char *str = std::get<1>(v[0]).data();
+    const double *dbl = std::get<2>(v[0]).data();
+    uf::deserialize(uf::serialize(small), v, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(v == small);
+    CHECK(std::get<1>(v[0]).data() == str);   //the same buffers were reused
+    CHECK(std::get<2>(v[0]).data() == dbl);
+    CHECK(std::get<1>(v[0]).capacity() >= 100);
+    uf::deserialize(uf::serialize(big), v, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(v == big);
+
+    std::list<std::string> l;
+    uf::deserialize(uf::serialize(std::vector<std::string>{"a", "b", "c"}), l, false, uf::use_tags, uf::reuse_capacity);
+    const std::string *first = &l.front();
+    uf::deserialize(uf::serialize(std::vector<std::string>{"x", "y"}), l, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(l == std::list<std::string>{"x", "y"});
+    CHECK(&l.front() == first);
+
+    //maps reuse their nodes, also when the keys change
+    std::map<std::string, std::vector<int>> m;
+    const std::map<std::string, std::vector<int>> m1 = {{"a", {1, 2}}, {"b", {3}}}, m2 = {{"c", {4}}, {"a", {5, 6, 7}}};
+    uf::deserialize(uf::serialize(m1), m, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(m == m1);
+    std::set<const void *> nodes;
+    for (auto &[k, val] : m) nodes.insert(&k);
+    uf::deserialize(uf::serialize(m2), m, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(m == m2);
+    for (auto &[k, val] : m) CHECK(nodes.contains(&k));
+    uf::deserialize(uf::serialize(std::map<std::string, std::vector<int>>{{"d", {}}, {"e", {}}, {"f", {}}}), m, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(m.size() == 3);
+    std::unordered_set<std::string> us = {"a", "b"};
+    uf::deserialize(uf::serialize(std::set<std::string>{"x"}), us, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(us == std::unordered_set<std::string>{"x"});
+    //duplicate keys in the data: the first wins, as without the tag
+    const std::string dup = uf::serialize(std::vector<std::pair<int, int>>{{1, 1}, {1, 2}});
+    std::map<int, int> mi = {{5, 5}, {6, 6}}, mi2;
+    uf::deserialize(dup, mi);
+    uf::deserialize(dup, mi2, false, uf::use_tags, uf::reuse_capacity);
+    CHECK(mi == mi2);
+    //combines with other tags
+    std::vector<std::string> vs = {"long string to keep"};
+    uf::deserialize(uf::serialize(std::vector<std::string>{"le"}, uf::use_tags, uf::little_endian), vs, false,
+                    uf::use_tags, uf::little_endian, uf::reuse_capacity);
+    CHECK(vs == std::vector<std::string>{"le"});
+    CHECK_THROWS_AS(uf::deserialize(uf::serialize(big).substr(0, 30), v, false, uf::use_tags, uf::reuse_capacity), uf::value_mismatch_error);
+    //a huge element count in a short message is rejected before creating the elements
+    const std::string huge = uf::serialize(uint32_t(0xffffffff)) + std::string(4, '\0');
+    std::list<std::string> hl;
+    std::deque<int> hd;
+    CHECK_THROWS_AS(uf::deserialize(huge, hl, false, uf::use_tags, uf::reuse_capacity), uf::value_mismatch_error);
+    CHECK_THROWS_AS(uf::deserialize(huge, hd, false, uf::use_tags, uf::reuse_capacity), uf::value_mismatch_error);
+    CHECK(hl.size() + hd.size() == 0);
+}
+
 TEST_CASE("convert")
 {
     uf::expected<int> ei = 3;
@@ -586,6 +912,31 @@ TEST_CASE("convert")
     CHECK(uf::any(aei).convert_to("d").print() == "<d>3.");
     CHECK(uf::any(uf::from_text, "<a><xi>3.0").print() == "<a><a><xi>3");
     CHECK(uf::any(uf::from_text, "<xs>['h','e','l','l','o']").print() == "<a><xs>\"hello\"");
+
+    const uf::any la = uf::any(std::vector<int>{1, 2}).convert_to("la");
+    std::vector<int64_t> vI;
+    CHECK(uf::deserialize_convert(la.value(), la.type(), vI).empty());
+    CHECK(vI == std::vector<int64_t>{1, 2});
+    int64_t I;
+    const uf::any ai(5);
+    CHECK(uf::deserialize_convert(ai.value(), ai.type(), std::tie(I)).empty()); //rvalue target
+    CHECK(I == 5);
+    const uf::any lxi(std::vector<uf::expected<int>>{1, uf::error_value("t", "e")});
+    CHECK_THROWS_AS(uf::deserialize_convert(lxi.value(), lxi.type(), vI), uf::expected_with_error);
+    //the errors name both the source and the target type and list the errors
+    CHECK_THROWS_WITH(uf::deserialize_convert(lxi.value(), lxi.type(), vI), doctest::Contains("<lx*i> -> <lI*> cannot place errors in expected values. Errors: t:e"));
+    std::vector<std::string_view> vs;
+    const uf::any lxs(std::vector<uf::expected<std::string>>{std::string("a"), uf::error_value("t", "e")});
+    CHECK_THROWS_WITH(uf::deserialize_view_convert(lxs.value(), lxs.type(), vs), doctest::Contains("<lx*s> -> <ls*>"));
+    //rvalue targets convert and honour allow_longer_data, too
+    std::string str;
+    const uf::any aai(std::tuple<uf::any, int>(uf::any("x"), 5));
+    const std::string longer = std::string(aai.value()) + "zz";
+    CHECK(uf::deserialize_convert(longer, aai.type(), std::tie(str, I), uf::allow_converting_all, true) == "zz");
+    CHECK(str == "x");
+    CHECK(I == 5);
+    CHECK_THROWS_AS(uf::deserialize_convert(longer, aai.type(), std::tie(str, I)), uf::value_mismatch_error);
+    CHECK_THROWS_AS(uf::deserialize_convert(aai.value(), aai.type(), std::tie(str, I), uf::allow_converting_none), uf::type_mismatch_error);
 }
 
 namespace check_equality_op
@@ -672,6 +1023,55 @@ TEST_CASE("primitive conversions")
     TCO2(int64_t(1), bool(), uf::allow_converting_bool);
 }
 
+/** Check that a conversion plan gives the same result (or error) as any_view::get().*/
+template <typename T, typename S>
+void check_plan(const S &source, uf::serpolicy policy = uf::allow_converting_all, bool compiled = true) {
+    const uf::any a(source);
+    uf::conversion_plan<T> plan(a.type(), policy);
+    CHECK(plan.is_compiled() == compiled);
+    std::string expected_error, error;
+    T t1{}, t2{};
+    try { a.get(t1, policy); } catch (const uf::value_error &e) { expected_error = e.what(); }
+    try { plan.get(a, t2); } catch (const uf::value_error &e) { error = e.what(); }
+    CHECK(error == expected_error);
+    if (error.empty()) CHECK(uf::any(t1) == uf::any(t2));
+}
+
+TEST_CASE("conversion_plan")
+{
+    using namespace std::string_literals;
+    check_plan<std::vector<int64_t>>(std::vector<int>{1, -2, 3});
+    check_plan<std::vector<int64_t>>(std::vector<int>{1, -2, 3}, uf::allow_converting_none, false);
+    check_plan<std::tuple<bool, uf::expected<char>, int, int64_t, double>>(std::tuple{true, 'a', 42, int64_t(4242), 1.5});
+    check_plan<std::tuple<char, int64_t>>(std::tuple{true, 'a'});
+    check_plan<std::tuple<char, int64_t>>(std::tuple{1000, 1.5});
+    check_plan<std::tuple<bool, double, int, double>>(std::tuple{'\2', int64_t(1) << 40, 3.7, 4});
+    check_plan<std::map<std::string, std::optional<int64_t>>>(std::map<std::string, std::optional<int>>{{"a", 1}, {"b", {}}});
+    check_plan<std::vector<std::pair<std::string, uf::any>>>(std::vector<std::pair<std::string, uf::any>>{{"a", uf::any(1)}});
+    check_plan<std::pair<std::vector<std::string>, int64_t>>(std::pair{std::vector<std::string>{"a", "bb"}, 1});
+    check_plan<std::tuple<int, int>>(std::tuple{uf::expected<int>(1), 2});
+    //error in an expected: the plan falls back to the generic path, and throws the same
+    check_plan<std::tuple<int, int>>(std::tuple{uf::expected<int>(uf::error_value("t", "m")), 2});
+    //not compiled: handled by the generic path
+    check_plan<std::vector<int>>(std::tuple{1, 2}, uf::allow_converting_all, false);
+    check_plan<std::tuple<int, int>>(std::tuple{uf::any(5), 1}, uf::allow_converting_all, false);
+    check_plan<std::string>(5, uf::allow_converting_all, false);
+    check_plan<int>(5);
+    //A bad value is reported the same way
+    uf::conversion_plan<int64_t> plan("i");
+    CHECK_THROWS_AS(plan.get(uf::any_view(uf::from_type_value_unchecked, "i", "\0\0"s), *std::make_unique<int64_t>()), uf::value_mismatch_error);
+    const uf::any a7(7), a75(7.5);
+    CHECK(plan.get_as(a7) == 7);
+    CHECK(plan.get_as(a75) == 7); //not our source type
+
+    auto p1 = uf::conversion_plan<int64_t>::cached("i");
+    CHECK(p1 == uf::conversion_plan<int64_t>::cached("i"));
+    CHECK(p1 != uf::conversion_plan<int64_t>::cached("i", uf::allow_converting_ints));
+    CHECK(p1->is_compiled());
+    for (int i = 0; i < 300; i++)
+        (void)uf::conversion_plan<std::vector<int64_t>>::cached(uf::concat("t", 2 + i, std::string(2 + i, 'i')));
+}
+
 TEST_CASE("container conversions") 
 {
     TCF2(bool(), std::vector<uf::any>{});
@@ -775,6 +1175,559 @@ TEST_CASE("get<any>")
     }
 }
 
+TEST_CASE("try_get")
+{
+    const uf::any a(std::tuple{1, std::string("x"), 2.5});
+    std::tuple<int, std::string, double> t;
+    CHECK(a.try_get(t));
+    CHECK(t == std::tuple{1, std::string("x"), 2.5});
+    std::tuple<int64_t, std::optional<std::string>, int> t2;
+    CHECK(a.try_get(t2)); //conversion
+    CHECK(std::get<1>(t2) == "x");
+    std::tuple<int, int, double> t3;
+    const uf::get_status st = a.try_get(t3);
+    CHECK(!st);
+    CHECK(st.status == uf::get_status::code::type_mismatch);
+    CHECK(st.source_pos == 3);
+    CHECK(st.target_pos == 3);
+    CHECK(st.message() == "type mismatch");
+    //the error of a failed probe is kept for the next one
+    CHECK(uf::impl::spare_quiet_error<uf::type_mismatch_error>);
+    CHECK(!a.try_get(t3));
+    CHECK(a.try_get(t3).target_pos == 3);
+    CHECK(a.try_get(t3, uf::allow_converting_none).status == uf::get_status::code::type_mismatch);
+    //the same as if get() threw
+    try {
+        a.get(t3);
+        CHECK(false);
+    } catch (const uf::value_error &e) {
+        CHECK(uf::get_status::from(e).status == st.status);
+        CHECK(std::string(e.what()) == "Type mismatch when converting <t3i*sd> to <t3i*id>");
+    }
+    //errors of expected values
+    const uf::any ax(uf::expected<int>(uf::error_value("type", "msg")));
+    int i;
+    CHECK(ax.try_get(i).status == uf::get_status::code::expected_error);
+    const uf::any_view bad(uf::from_type_value_unchecked, "i", std::string_view("\0\0", 2));
+    CHECK(bad.try_get(i).status == uf::get_status::code::value_mismatch);
+    const uf::any_view bad2(uf::from_type_value_unchecked, "li", std::string_view("\0\0\0\1\0\0", 6));
+    std::vector<int64_t> v;
+    CHECK(bad2.try_get(v).status == uf::get_status::code::value_mismatch);
+    //quiet probes do not disturb error messages created later
+    CHECK(!a.converts_to<int>());
+    CHECK_THROWS_WITH((void)a.get_as<int>(), "Type mismatch when converting <t3i*sd> to <i*>");
+    //errors are reformatted as they are extended
+    uf::type_mismatch_error e("Mismatch", "t2ii", "t2is", 3, 3);
+    e.prepend_type0("lt2ii", "t2ii");
+    CHECK(std::string(e.what()) == "Mismatch (<lt2i*i> -> <t2i*s>)");
+    auto pe = std::make_unique<uf::value_mismatch_error>("Bad value");
+    CHECK(std::string(pe->what()) == "Bad value");
+}
+
+TEST_CASE("any_index")
+{
+    const std::vector<std::string> ls = {"a", "bb", "ccc", "", "eeeee"};
+    const uf::any al(ls);
+    uf::any_index il(al);
+    REQUIRE(il.size() == 5);
+    CHECK(!il.is_map());
+    for (size_t k = 0; k < ls.size(); k++) {
+        CHECK(il[k].get_as<std::string>() == ls[k]);
+        CHECK(il[k] == al.get_content()[k]);
+    }
+    CHECK_THROWS_AS((void)il.at(5), std::out_of_range);
+    CHECK(!il.find("a"));
+
+    //tuple with nested containers, index owning its value
+    const std::map<std::string, int> msi = {{"one", 1}, {"three", 3}, {"two", 2}, {"zz", 26}};
+    uf::any_index it(uf::any(std::tuple{42, msi, ls}));
+    REQUIRE(it.size() == 3);
+    CHECK(it[0].get_as<int>() == 42);
+    auto &im = it.child(1);
+    CHECK(&im == &it.child(1)); //built once
+    REQUIRE(im.is_map());
+    CHECK(im.size() == 4);
+    for (auto &[k, v] : msi) {
+        auto f = im.find(k);
+        REQUIRE(f);
+        CHECK(f->get_as<int>() == v);
+    }
+    CHECK(!im.find(std::string("four")));
+    CHECK(!im.find(1)); //key type mismatch
+    CHECK(im[1].get_as<std::string>() == "three");
+    CHECK(im.mapped(1).get_as<int>() == 3);
+    CHECK(im.child(3).view().get_as<int>() == 26);
+    CHECK(it.child(2)[4].get_as<std::string>() == "eeeee");
+    CHECK(it.child(0).empty());
+
+    //unsigned keys are serialized in byte order, duplicates return the first
+    const std::vector<std::pair<uint32_t, char>> vp = {{1, 'a'}, {5, 'b'}, {5, 'c'}, {300, 'd'}};
+    uf::any_index iu(uf::any(std::map<uint32_t, char>(vp.begin(), vp.end())));
+    CHECK(iu.find(uint32_t(300))->get_as<char>() == 'd');
+    CHECK(!iu.find(uint32_t(2)));
+    const std::string rev = uf::serialize(std::vector(vp.rbegin(), vp.rend()));
+    uf::any_index id(uf::any_view(uf::from_type_value, "mic", rev));
+    CHECK(id.find(uint32_t(5))->get_as<char>() == 'c');
+    CHECK(id.find(uint32_t(1))->get_as<char>() == 'a');
+
+    CHECK_THROWS_AS(uf::any_index(uf::any_view(uf::from_type_value_unchecked, "li", std::string_view("\0\0\0\1", 4))), uf::value_error);
+}
+
+TEST_CASE("stream_decoder")
+{
+    //list of tuples fed in chunks of every size
+    std::vector<std::tuple<int, std::string, uf::any>> lt;
+    for (int i = 0; i < 20; i++)
+        lt.emplace_back(i, std::string(i * 7, 'x'), uf::any(std::vector<double>(i % 3, 1.5)));
+    const std::string s = uf::serialize(lt);
+    for (size_t chunk : {size_t(1), size_t(3), size_t(17), size_t(1000), s.size()}) {
+        std::vector<int> got;
+        uf::stream_decoder d(uf::serialize_type(lt), uf::stream_decoder::typed<std::tuple<int, std::string, uf::any>>(
+            [&](std::tuple<int, std::string, uf::any> &&t) { got.push_back(std::get<0>(t)); CHECK(t == lt[std::get<0>(t)]); }));
+        size_t reported = 0;
+        for (size_t i = 0; i < s.size(); i += chunk) {
+            reported += d.feed(std::string_view(s).substr(i, chunk));
+            CHECK(d.buffered() < 300);
+        }
+        CHECK(reported == lt.size());
+        CHECK(d.done());
+        CHECK(d.count() == 20);
+        CHECK(d.finish() == 0);
+        CHECK(got.size() == lt.size());
+        CHECK(std::is_sorted(got.begin(), got.end()));
+    }
+
+    //maps are reported as pairs, other types as one value
+    const std::map<std::string, int> msi = {{"a", 1}, {"bb", 2}};
+    std::vector<std::string> views;
+    uf::stream_decoder dm("msi", [&](uf::any_view v) { views.push_back(v.print()); });
+    const std::string sm = uf::serialize(msi);
+    CHECK(dm.feed(std::string_view(sm).substr(0, 14)) == 1);
+    CHECK(dm.feed(std::string_view(sm).substr(14)) == 1);
+    CHECK(views == std::vector<std::string>{"<t2si>(\"a\",1)", "<t2si>(\"bb\",2)"});
+    views.clear();
+    uf::stream_decoder dt("t2is", [&](uf::any_view v) { views.push_back(v.print()); });
+    const std::string st = uf::serialize(std::tuple{5, std::string("abc")});
+    CHECK(dt.feed(std::string_view(st).substr(0, 5)) == 0);
+    CHECK(!dt.done());
+    CHECK(dt.feed(std::string_view(st).substr(5)) == 1);
+    CHECK(views == std::vector<std::string>{"<t2is>(5,\"abc\")"});
+
+    //errors
+    CHECK_THROWS_AS(uf::stream_decoder("l", {}), uf::typestring_error);
+    CHECK_THROWS_AS(uf::stream_decoder("li", [](uf::any_view) {}).feed(uf::serialize(std::vector<int>{1}) + "x"), uf::value_mismatch_error);
+    uf::stream_decoder di("li", [](uf::any_view) {});
+    di.feed(std::string_view(uf::serialize(std::vector<int>{1, 2})).substr(0, 10));
+    CHECK(di.buffered() == 2);
+    CHECK_THROWS_AS(di.finish(), uf::value_mismatch_error);
+    uf::stream_decoder da("la", [](uf::any_view) {}, true);
+    CHECK_THROWS_AS(da.feed(std::string_view("\0\0\0\1\0\0\0\1@\0\0\0\0", 13)), uf::typestring_error);
+
+    //elements longer than the limit: by their length prefix or by the bytes received
+    uf::stream_decoder dl("ls", [](uf::any_view) {}, false, 1000);
+    CHECK_THROWS_AS(dl.feed(std::string_view("\0\0\0\1\xff\xff\xff\xff", 8)), uf::value_mismatch_error);
+    uf::stream_decoder dli("lli", [](uf::any_view) {}, false, 1000);
+    CHECK_THROWS_AS(dli.feed(std::string_view("\0\0\0\1\0\0\1\0", 8)), uf::value_mismatch_error); //256 ints
+    uf::stream_decoder dla("la", [](uf::any_view) {}, false, 1000);
+    CHECK_THROWS_AS(dla.feed(std::string_view("\0\0\0\1\0\0\0\1i\0\1\0\0", 13)), uf::value_mismatch_error);
+    const std::string lt2 = uf::serialize(std::vector<std::tuple<int, std::string>>{{1, std::string(600, 'x')}, {2, "y"}});
+    uf::stream_decoder dt2("lt2is", [](uf::any_view) {}, false, 500);
+    CHECK(dt2.feed(std::string_view(lt2).substr(0, 300)) == 0);
+    CHECK_THROWS_AS(dt2.feed(std::string_view(lt2).substr(300, 300)), uf::value_mismatch_error);
+    size_t ok = 0;
+    uf::stream_decoder dt3("lt2is", [&](uf::any_view) { ok++; }, false, 700);
+    for (size_t i = 0; i < lt2.size(); i += 100)
+        dt3.feed(std::string_view(lt2).substr(i, 100));
+    CHECK(ok == 2);
+    CHECK(dt3.done());
+}
+
+#ifndef _WIN32
+TEST_CASE("record log")
+{
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("ufser_log_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "log").string();
+    {
+        uf::record_log_writer w(path, 256);
+        for (int i = 0; i < 50; i++)
+            if (i % 2) w.append_as(std::pair(i, std::string(i, 'x')));
+            else w.append(uf::any(i));
+        CHECK(w.segment() > 1);
+        w.close();
+        CHECK_THROWS_AS(w.append(uf::any(1)), uf::api_error);
+    }
+    {
+        uf::record_log_reader r(path);
+        REQUIRE(r.size() == 50);
+        CHECK(r.segments() > 2);
+        for (int i = 0; i < 50; i++)
+            if (i % 2) CHECK(r.at(i).get_as<std::pair<int, std::string>>() == std::pair(i, std::string(i, 'x')));
+            else CHECK(r[i].get_as<int>() == i);
+        int n = 0;
+        r.for_each([&n](uf::any_view a) { CHECK(a.type() == (n++ % 2 ? "t2is" : "i")); });
+        CHECK(n == 50);
+        CHECK_THROWS_AS((void)r.at(50), std::out_of_range);
+    }
+
+    //A reopened log continues in a new segment, which can be read before closing.
+    uf::record_log_writer w(path);
+    const unsigned seg = w.segment();
+    w.append_as(std::string("flushed"));
+    w.append_as(std::string("torn"));
+    w.flush();
+    CHECK(uf::record_log_reader(path).size() == 52);
+    const std::string file = path + "." + std::string(6 - std::to_string(seg).size(), '0') + std::to_string(seg);
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 2);
+    {
+        uf::record_log_reader r(path);
+        REQUIRE(r.size() == 51);
+        CHECK(r.at(50).get_as<std::string>() == "flushed");
+    }
+    std::filesystem::resize_file(file, 4); //shorter than the magic: just created
+    CHECK(uf::record_log_reader(path).size() == 50);
+    std::filesystem::resize_file(file, 0);
+    std::filesystem::resize_file(file, 20);
+    CHECK_THROWS_AS(uf::record_log_reader{path}, uf::value_mismatch_error);
+    std::filesystem::remove_all(dir);
+}
+#endif //_WIN32
+
+TEST_CASE("typestring interning")
+{
+    const std::string t1 = "t2is", t2 = "t2is";
+    CHECK(uf::intern_typestring(t1).data() == uf::intern_typestring(t2).data());
+    CHECK(uf::intern_typestring(t1).data() != t1.data());
+    CHECK(uf::intern_typestring("t2is").data() != uf::intern_typestring("t2si").data());
+
+    //anys from C++ values share the interned type, others can be interned
+    uf::any a(std::pair(1, std::string("a"))), b(std::pair(2, std::string("b")));
+    CHECK(a.has_interned_type());
+    CHECK(a.type().data() == b.type().data());
+    CHECK(a.type().data() == uf::intern_typestring("t2is").data());
+    uf::any c(uf::from_type_value, "t2is", uf::serialize(std::pair(3, std::string("c"))));
+    CHECK(!c.has_interned_type());
+    c.intern_type();
+    CHECK(c.has_interned_type());
+    CHECK(c.type().data() == a.type().data());
+    CHECK(c.print() == R"(<t2is>(3,"c"))");
+
+    //copy, move and swap keep the interned type and relocate the value
+    uf::any d = a;
+    CHECK(d.type().data() == a.type().data());
+    CHECK(d.value().data() != a.value().data());
+    CHECK(d == a);
+    uf::any e(uf::from_text, "\"x\"");
+    d.swap(e);
+    CHECK(d.print() == "<s>\"x\"");
+    CHECK(e.type().data() == a.type().data());
+    CHECK(e.get_as<std::pair<int, std::string>>() == std::pair(1, std::string("a")));
+    d = std::move(e);
+    CHECK(d.has_interned_type());
+    CHECK(d == a);
+    CHECK(uf::deserialize_as<uf::any>(uf::serialize(d)) == a);
+}
+
+TEST_CASE("type dictionary encoding")
+{
+    uf::type_dict_encoder enc;
+    std::string wire;
+    for (int i = 0; i < 10; i++)
+        enc.encode(wire, uf::any(i % 2 ? uf::any(i) : uf::any(std::pair(i, std::string("x")))));
+    enc.encode(wire, uf::any{});
+    CHECK(enc.types() == 3);
+    //Each typestring is sent once: smaller than serializing the anys
+    std::string plain;
+    for (int i = 0; i < 10; i++)
+        plain += uf::serialize(i % 2 ? uf::any(i) : uf::any(std::pair(i, std::string("x"))));
+    CHECK(wire.size() < plain.size() + 4 + 4 + 4 + 4);
+
+    //decode in pieces of every size
+    for (size_t chunk : {size_t(1), size_t(5), size_t(1000)}) {
+        uf::type_dict_decoder dec;
+        std::string buf;
+        std::vector<std::string> got;
+        std::string_view first_type;
+        for (size_t i = 0; i < wire.size(); i += chunk) {
+            buf += wire.substr(i, chunk);
+            std::string_view data = buf;
+            while (auto a = dec.decode(data)) {
+                got.push_back(a->print());
+                if (a->type() == "t2is") {
+                    if (first_type.empty()) first_type = a->type();
+                    CHECK(a->type().data() == first_type.data());
+                }
+            }
+            //the views point into 'buf', keep it until printed
+            buf.erase(0, buf.size() - data.size());
+        }
+        CHECK(buf.empty());
+        REQUIRE(got.size() == 11);
+        CHECK(got[0] == "<t2is>(0,\"x\")");
+        CHECK(got[1] == "<i>1");
+        CHECK(got[10] == "<>");
+    }
+
+    //errors
+    uf::type_dict_decoder dec;
+    std::string_view bad("\0\0\0\0\0\0\0\0", 8);
+    CHECK_THROWS_AS((void)dec.decode(bad), uf::value_mismatch_error);
+    const std::string mismatch = uf::type_dict_encoder().encode(uf::any_view(uf::from_type_value_unchecked, "i", "ab"));
+    std::string_view m = mismatch;
+    CHECK_THROWS_AS((void)dec.decode(m), uf::value_mismatch_error);
+    m = mismatch;
+    CHECK(uf::type_dict_decoder(false).decode(m)->value() == "ab");
+}
+
+TEST_CASE("statistics")
+{
+    uf::stats_reset();
+    const uf::any ai(42), ls(std::vector<std::string>(100, "x"));
+    CHECK(ai.get_as<int>() == 42);
+    CHECK(ai.get_as<int>(uf::allow_converting_none) == 42); //no conversion needed
+    CHECK(ai.get_as<double>() == 42);
+    CHECK(ai.get_as<double>() == 42);
+    CHECK(ai.converts_to<std::string>() == false);
+    CHECK_THROWS_AS((void)ai.get_as<double>(uf::allow_converting_none), uf::type_mismatch_error);
+    (void)uf::any_view(uf::from_type_value, ls.type(), ls.value());
+    std::thread([&] { CHECK(ls.get_as<std::vector<std::string>>().size() == 100); }).join();
+    const auto s = uf::stats_snapshot();
+    if constexpr (!uf::stats_enabled) {
+        CHECK(s.empty());
+        return;
+    }
+    const auto count = [&s](uf::stat_event e, std::string_view t, std::string_view target = {}, uf::serpolicy reason = uf::allow_converting_none) {
+        auto i = s.find(uf::stat_key{e, reason, std::string(t), std::string(target)});
+        return i == s.end() ? uf::stat_value{} : i->second;
+    };
+    CHECK(count(uf::stat_event::get, "i", "i").calls == 2);
+    CHECK(count(uf::stat_event::get, "i", "i").bytes == 8);
+    CHECK(count(uf::stat_event::convert, "i", "d").calls == 3);
+    CHECK(count(uf::stat_event::converts_to_failed, "i", "s").calls == 1);
+    CHECK(count(uf::stat_event::policy_refused, "i", "d", uf::allow_converting_double).calls == 1);
+    CHECK(count(uf::stat_event::error, "i", "d").calls == 1);
+    CHECK(count(uf::stat_event::scan, "ls").bytes == ls.value().size());
+    CHECK(count(uf::stat_event::get, "ls", "ls").calls == 1); //from an exited thread
+    CHECK(count(uf::stat_event::any_alloc, "ls").calls == 1);
+    uf::stats_reset();
+    CHECK(uf::stats_snapshot().empty());
+}
+
+TEST_CASE("compressed any")
+{
+    std::vector<std::string> ls(2000, "a string that repeats a lot");
+    const uf::any a(ls);
+    const uf::compressed_any c(a);
+    CHECK(c.type() == "ls");
+    CHECK(c.size() == a.value().size());
+#ifdef HAVE_ZLIB
+    CHECK(c.compressed());
+    CHECK(c.stored_size() * 5 < c.size());
+#endif
+    CHECK(c.view() == uf::any_view(a));
+    CHECK(c.view().value().data() == c.view().value().data()); //cached per thread
+    CHECK(c.get_as<std::vector<std::string>>() == ls);
+    CHECK(c.to_any() == a);
+    CHECK(uf::any(c.view()) == a);
+
+    //small values are stored, as are ones that do not shrink
+    const uf::compressed_any small(42);
+    CHECK_FALSE(small.compressed());
+    CHECK(small.view().get_as<int>() == 42);
+    std::string noise(4096, 0);
+    uint64_t x = 88172645463325252u;
+    for (char &ch : noise) { x ^= x << 13; x ^= x >> 7; x ^= x << 17; ch = char(x); }
+    CHECK_FALSE(uf::compressed_any(noise).compressed());
+    CHECK_FALSE(uf::compressed_any(a, a.value().size() + 1).compressed());
+    CHECK(uf::compressed_any().view().type().empty());
+
+    //travels as a regular tuple, also inside other values
+    CHECK(uf::serialize_type<uf::compressed_any>() == "t4csis");
+    std::map<int, uf::compressed_any> m{{1, c}, {2, small}};
+    const std::string s = uf::serialize(m);
+    CHECK(s.size() < a.value().size() / 5 + 100);
+    CHECK_FALSE(std::get<0>(uf::impl::serialize_scan_by_type(uf::serialize_type(m), s, false, true)));
+    const uf::any am(m);
+    auto back = am.get_as<std::map<int, uf::compressed_any>>();
+    CHECK(back[1].get_as<std::vector<std::string>>() == ls);
+    CHECK(back[2].get_as<int>() == 42);
+    //copies share the decompressed bytes
+    const uf::compressed_any copy = c;
+    const char *p = c.view().value().data();
+    CHECK(copy.view().value().data() == p);
+    CHECK(back[1].view() == uf::any_view(a));
+    //views of different values can be used together
+    const uf::compressed_any c2(std::vector<std::string>(2000, "another string that repeats a lot"));
+    CHECK_FALSE(uf::equivalent(c.view(), c2.view()));
+    CHECK(uf::equivalent(c.view(), copy.view()));
+    const auto v1 = c.view();
+    (void)c2.view();
+    CHECK(v1 == uf::any_view(a));
+
+    //errors
+    uf::compressed_any bad;
+    CHECK_THROWS_AS(uf::deserialize(uf::serialize(std::tuple(char(0), std::string("i"), uint32_t(5), std::string("ab"))), bad),
+                    uf::value_mismatch_error);
+    CHECK_THROWS_AS(uf::deserialize(uf::serialize(std::tuple(char(0), std::string("i"), uint32_t(2), std::string("ab"))), bad),
+                    uf::value_mismatch_error);
+    uf::deserialize(uf::serialize(std::tuple(char(7), std::string("i"), uint32_t(4), std::string("abcd"))), bad);
+    CHECK_THROWS_AS((void)bad.view(), uf::api_error);
+#ifdef HAVE_ZLIB
+    uf::deserialize(uf::serialize(std::tuple(char(1), std::string("i"), uint32_t(4), std::string("abcd"))), bad);
+    CHECK_THROWS_AS((void)bad.view(), uf::value_mismatch_error);
+#endif
+    //a small payload cannot claim a huge length (decompression bomb)
+    CHECK_THROWS_AS(uf::deserialize(uf::serialize(std::tuple(char(1), std::string("ls"), uint32_t(0xffffffff), std::string(16, 'x'))), bad),
+                    uf::value_mismatch_error);
+}
+
+TEST_CASE("content compare and hash")
+{
+    const auto eq = [](const uf::any &a, const uf::any &b) {
+        INFO(a.print(), " vs ", b.print());
+        CHECK(uf::equivalent(a, b));
+        CHECK(uf::hash(a) == uf::hash(b));
+    };
+    //numbers compare by value
+    eq(uf::any(5), uf::any(int64_t(5)));
+    eq(uf::any(5), uf::any(5.0));
+    eq(uf::any(0.0), uf::any(-0.0));
+    eq(uf::any(std::nan("")), uf::any(-std::nan("")));
+    CHECK(uf::compare(uf::any(-1), uf::any(1)) < 0);
+    CHECK(uf::compare(uf::any(2), uf::any(1.5)) > 0);
+    CHECK(uf::compare(uf::any(int64_t(1) << 62), uf::any(1e300)) < 0);
+    CHECK(uf::compare(uf::any(int64_t(9007199254740993)), uf::any(9007199254740992.0)) > 0);
+    CHECK(uf::compare(uf::any(1e300), uf::any(std::nan(""))) < 0);
+    //bytewise order of the serialized form would give the opposite
+    CHECK(uf::any(-1) > uf::any(1));
+    eq(uf::any(std::vector<int>{1, -2, 3}), uf::any(std::vector<double>{1, -2, 3}));
+    eq(uf::any(std::vector<int64_t>{1, -2, 3}), uf::any(std::vector<double>{1, -2, 3}));
+    CHECK(uf::compare(uf::any(std::vector<int>{1, -2}), uf::any(std::vector<int>{1, 2})) < 0);
+    CHECK(uf::compare(uf::any(std::vector<int>{1, 2}), uf::any(std::vector<int>{1, 2, 0})) < 0);
+    eq(uf::any(std::tuple(1, std::string("a"), 2.0)), uf::any(std::tuple(1.0, std::string("a"), 2)));
+    CHECK(uf::compare(uf::any(std::pair(1, std::string("b"))), uf::any(std::pair(1, std::string("ab")))) > 0);
+    CHECK(uf::compare(uf::any(std::string("ab")), uf::any(std::string("abc"))) < 0);
+    CHECK(uf::compare(uf::any(std::string("\xff")), uf::any(std::string("a"))) > 0);
+    eq(uf::any(std::vector<char>{'a', 'b'}), uf::any(std::vector<char>{'a', 'b'}));
+    //a 'lc' followed by more members
+    using Tci = std::tuple<std::vector<char>, int>;
+    using Tcs = std::tuple<std::vector<char>, std::string>;
+    CHECK(uf::compare(uf::any(Tci{{'a', 'b'}, 1}), uf::any(Tci{{'a', 'b'}, 2})) < 0);
+    CHECK(std::hash<uf::any>()(uf::any(Tci{{'a', 'b'}, 1})) != std::hash<uf::any>()(uf::any(Tci{{'a', 'b'}, 2})));
+    eq(uf::any(Tci{{'a', 'b'}, 2}), uf::any(std::tuple<std::vector<char>, double>{{'a', 'b'}, 2}));
+    CHECK(uf::compare(uf::any(Tcs{{'a'}, "x"}), uf::any(Tcs{{'a'}, "y"})) < 0);
+    eq(uf::any(Tcs{{'a'}, "x"}), uf::any(Tcs{{'a'}, "x"}));
+    //different kinds are ordered by kind
+    CHECK(uf::compare(uf::any(), uf::any(1)) < 0);
+    CHECK(uf::compare(uf::any(1), uf::any(std::string("1"))) < 0);
+    CHECK(!uf::equivalent(uf::any(true), uf::any(1)));
+
+    //maps are compared as if sorted
+    const std::vector<std::pair<std::string, int>> sorted = {{"a", 1}, {"b", 2}, {"c", 3}}, unsorted = {{"c", 3}, {"a", 1}, {"b", 2}};
+    const uf::any m1(uf::from_type_value, "msi", uf::serialize(sorted)), m2(uf::from_type_value, "msi", uf::serialize(unsorted));
+    CHECK(m1 != m2);
+    eq(m1, m2);
+    eq(m1, uf::any(std::map<std::string, double>{{"a", 1}, {"b", 2}, {"c", 3}}));
+    CHECK(uf::compare(m1, uf::any(std::map<std::string, int>{{"a", 1}, {"b", 3}})) < 0);
+
+    //optionals, expecteds, anys
+    CHECK(uf::compare(uf::any(std::optional<int>{}), uf::any(std::optional<int>{-5})) < 0);
+    eq(uf::any(std::optional<int>{5}), uf::any(std::optional<double>{5}));
+    eq(uf::any(std::optional<int>{}), uf::any(std::optional<std::string>{}));
+    CHECK(uf::compare(uf::any(uf::expected<int>(uf::error_value("t", "m", uf::any()))), uf::any(uf::expected<int>(1))) < 0);
+    eq(uf::any(uf::expected<int>(1)), uf::any(uf::expected<double>(1)));
+    eq(uf::any(uf::any(5)), uf::any(uf::any(5.0)));
+    eq(uf::any(std::vector<uf::any>{uf::any(1), uf::any(std::string("x"))}), uf::any(std::vector<uf::any>{uf::any(1.0), uf::any(std::string("x"))}));
+    eq(uf::any(uf::expected<void>()), uf::any(uf::expected<void>()));
+
+    //use as keys
+    std::unordered_set<uf::any, uf::any_hash, uf::any_equivalent> set = {uf::any(1), uf::any(1.0), uf::any(int64_t(1)), uf::any(2), m1, m2};
+    CHECK(set.size() == 3);
+    const uf::any two(2.0);
+    CHECK(set.contains(uf::any_view(two)));
+    std::set<uf::any, uf::any_less> ordered = {uf::any(3), uf::any(-1), uf::any(2.5), uf::any(-1.0)};
+    CHECK(ordered.size() == 3);
+    CHECK(ordered.begin()->print() == "<i>-1");
+    CHECK(std::hash<uf::any>()(m1) == std::hash<uf::any_view>()(m2));
+
+    //malformed values
+    const uf::any_view bad(uf::from_type_value_unchecked, "li", std::string_view("\0\0\0\2\0\0\0\1", 8));
+    CHECK_THROWS_AS((void)uf::hash(bad), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)uf::compare(bad, bad), uf::value_mismatch_error);
+    CHECK_NOTHROW((void)std::hash<uf::any_view>()(bad));
+    CHECK_THROWS_AS((void)uf::hash(uf::any_view(uf::from_type_value_unchecked, "@", "")), uf::typestring_error);
+}
+
+/** Runs the tasks on 4 threads for parallel serialization and checks.*/
+void thread_exec(size_t n, const std::function<void(size_t)> &f)
+{
+    std::atomic<size_t> next = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+        threads.emplace_back([&] { for (size_t u; (u = next++) < n; ) f(u); });
+    for (auto &t : threads) t.join();
+}
+
+TEST_CASE("parallel serialization")
+{
+    std::vector<std::tuple<int, std::string, std::vector<double>>> v;
+    for (int i = 0; i < 1000; i++)
+        v.emplace_back(i, std::string(i % 17, 'a'), std::vector<double>(i % 5, 1.5));
+    const std::string s = uf::serialize(v);
+    for (size_t chunk : {size_t(0), size_t(1), size_t(7), size_t(1000), size_t(5000)})
+        CHECK(uf::serialize_parallel(v, thread_exec, chunk) == s);
+    const std::vector<std::pair<int, double>> fixed(999, {1, 2.5});
+    CHECK(uf::serialize_parallel(fixed, thread_exec, 10) == uf::serialize(fixed));
+    CHECK(uf::serialize_parallel(std::vector<std::string>{}, thread_exec) == uf::serialize(std::vector<std::string>{}));
+    CHECK(uf::serialize_parallel(std::vector<int>{1, 2}, thread_exec) == uf::serialize(std::vector<int>{1, 2}));
+    const std::map<int, std::string> m = {{1, "a"}, {2, "b"}};
+    CHECK(uf::serialize_parallel(m, thread_exec) == uf::serialize(m));
+    CHECK(uf::serialize_parallel(v, [](size_t n, const std::function<void(size_t)> &f) { for (size_t i = 0; i < n; i++) f(i); }, 3) == s);
+    //errors in any chunk are propagated
+    std::vector<uf::expected<int>> ve(100, 1);
+    ve[77] = uf::error_value("err", "msg", uf::any());
+    CHECK(uf::serialize_parallel(ve, thread_exec, 10) == uf::serialize(ve));
+
+    //checking a list of anys in parallel
+    std::vector<uf::any> la;
+    for (int i = 0; i < 1000; i++)
+        la.emplace_back(i % 2 ? uf::any(i) : uf::any(std::vector<uf::any>{uf::any(std::string("x")), uf::any(i)}));
+    std::string sla = uf::serialize(la);
+    uf::check_parallel("la", sla, thread_exec, 10);
+    uf::check_parallel("la", sla, thread_exec, 100000);
+    uf::check_parallel(uf::serialize_type(v), s, thread_exec, 10);
+    uf::check_parallel("msa", uf::serialize(std::map<std::string, uf::any>{{"a", uf::any(1)}, {"b", uf::any{}}}), thread_exec);
+    uf::check_parallel("li", uf::serialize(std::vector<int>{}), thread_exec);
+    uf::check_parallel("i", uf::serialize(5), thread_exec);
+    //corrupt a typestring inside an any deep in the list
+    const size_t pos = sla.rfind("la");
+    REQUIRE(pos != std::string::npos);
+    sla[pos] = '@';
+    std::string seq_error;
+    try { (void)uf::any_view(uf::from_type_value, "la", sla); } catch (const uf::value_error &e) { seq_error = e.what(); }
+    CHECK(!seq_error.empty());
+    CHECK_THROWS_WITH_AS(uf::check_parallel("la", sla, thread_exec, 10), seq_error.c_str(), uf::typestring_error);
+    const std::string good = uf::serialize(la);
+    CHECK_THROWS_AS(uf::check_parallel("la", std::string_view(good).substr(0, good.size() - 1), thread_exec, 10), uf::value_mismatch_error);
+    CHECK_THROWS_AS(uf::check_parallel("l@", sla, thread_exec, 10), uf::typestring_error);
+    CHECK_THROWS_AS(uf::check_parallel("mi", uf::serialize(std::vector<int>{}), thread_exec), uf::typestring_error);
+    //a bad any inside an error ('X' carries an 'a' the shallow scan skips)
+    const auto error_with_int = [](size_t len) {
+        return std::string(1, '\0') + uf::serialize(std::string("t")) + uf::serialize(std::string("m")) +
+               uf::serialize(std::string("i")) + uf::serialize(std::string(len, '\0'));
+    };
+    std::string slX = uf::serialize(uint32_t(100));
+    for (int i = 0; i < 100; i++)
+        slX += error_with_int(4);
+    uf::check_parallel("lX", slX, thread_exec, 10);
+    slX = uf::serialize(uint32_t(100));
+    for (int i = 0; i < 100; i++)
+        slX += error_with_int(i == 50 ? 2 : 4);
+    CHECK_THROWS_AS((void)uf::any_view(uf::from_type_value, "lX", slX), uf::value_mismatch_error);
+    CHECK_THROWS_AS(uf::check_parallel("lX", slX, thread_exec, 10), uf::value_mismatch_error);
+}
+
 using psli = std::pair<std::string, std::vector<int>>;
 TEST_CASE_TEMPLATE("any::create_serialized", T, int, double, psli)
 {
@@ -1370,6 +2323,44 @@ TEST_CASE("Error messages") {
     test_error_msgs<std::pair<char, char>>("t2c", "ab", "Unexpected end of typestring", "t2c*", "*t2cc");
 }
 
+TEST_CASE("scan of large containers") {
+    auto scan = [](const auto &t, size_t cut = 0) {
+        const uf::any a(t);
+        auto [err, tlen, vlen] = uf::impl::serialize_scan_by_type(a.type(), a.value().substr(0, a.value().size()-cut), false, true);
+        if (err) return std::string(err->what());
+        CHECK(tlen == a.type().size());
+        CHECK(vlen == a.value().size());
+        return std::string{};
+    };
+    const std::vector<int> li(1000, 42);
+    const std::vector<std::pair<int, char>> lt(1000, {1, 'a'});
+    const std::map<int, double> mid = {{1, 1.}, {2, 2.}, {3, 3.}};
+    const std::vector<std::string> ls(1000, "abc");
+    const std::vector<uf::any> la(1000, uf::any(7));
+    const std::vector<uf::any> lal = {uf::any(li), uf::any(ls), uf::any('c')};
+    CHECK(scan(li) == "");
+    CHECK(scan(lt) == "");
+    CHECK(scan(mid) == "");
+    CHECK(scan(ls) == "");
+    CHECK(scan(la) == "");
+    CHECK(scan(lal) == "");
+    CHECK(scan(std::vector<std::vector<std::string>>(10, ls)) == "");
+    //Truncated values are reported at the element that is short
+    CHECK(scan(li, 1) == "Value does not match type (scan) <l*i>.");
+    CHECK(scan(lt, 1) == "Value does not match type (scan) <lt2i*c>.");
+    CHECK(scan(mid, 1) == "Value does not match type (scan) <mi*d>.");
+    CHECK(scan(ls, 1) == "Value does not match type (scan) <l*s>.");
+    CHECK(scan(la, 1) == "Value does not match type (scan) <la(*i)>.");
+    CHECK(scan(lal, 1) == "Value does not match type (scan) <la(*c)>.");
+    //Inconsistent inner length of an any with a primitive type
+    const std::string bad_any = uf::serialize(uf::any(7)) + '\0';
+    std::string bad_len = bad_any;
+    bad_len[8] = 5; //vsize
+    auto [err, tlen, vlen] = uf::impl::serialize_scan_by_type("a", bad_len, false, true);
+    REQUIRE(err);
+    CHECK(std::string(err->what()) == "Extra bytes after value (<a*>)");
+}
+
 
 TEST_CASE("noexcept ser") {
     struct tuple_for_serialization_throws {
@@ -1778,6 +2769,36 @@ TEST_CASE("floating point print") {
     CHECK(uf::serialize_print(ld, true)=="216306000004.");
 }
 
+TEST_CASE("print to sink") {
+    std::vector<std::pair<std::string, std::map<int, double>>> v;
+    for (int i = 0; i < 200; i++)
+        v.emplace_back(std::to_string(i), std::map<int, double>{{i, i * 0.5}, {-i, 1e20}});
+    const uf::any a(v);
+    for (bool json : {false, true}) {
+        std::string text;
+        size_t chunks = 0, largest = 0;
+        a.print_to_sink([&](std::string_view s) { text.append(s); chunks++; largest = std::max(largest, s.size()); },
+                        256, {}, '%', json);
+        CHECK(text == a.print(0, {}, '%', json));
+        CHECK(chunks > 10);
+        CHECK(largest < 256 + 64);
+    }
+    std::string text;
+    a.print_json_to_sink([&](std::string_view s) { text.append(s); });
+    CHECK(text == a.print_json());
+    //nested anys are printed into the same buffer
+    const uf::any aa(std::vector<uf::any>(50, a));
+    size_t chunks = 0;
+    text.clear();
+    aa.print_to_sink([&](std::string_view s) { text.append(s); chunks++; }, 1024);
+    CHECK(text == aa.print());
+    CHECK(chunks > 50);
+    //errors are thrown as with print()
+    const uf::any_view bad(uf::from_type_value_unchecked, "li", std::string_view("\0\0\0\2\0\0\0\1", 8));
+    CHECK_THROWS_AS(bad.print_to_sink([](std::string_view) {}), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)bad.print(), uf::value_mismatch_error);
+}
+
 TEST_CASE("serialize_print void-like") {
     struct { 
         std::monostate m; 
@@ -1817,3 +2838,199 @@ TEST_CASE("JSON parsing") {
     CHECK(invalid_json("{\"a\":(0,1)}", "mst2ii") == "{\"a\":*(0,1)}");
     CHECK(invalid_json("error(\"type\",\"id\")", "e") == "*error(\"type\",\"id\")");
 }
+
+TEST_CASE("typed text parsing") {
+    struct Rec {
+        std::string name;
+        int id;
+        double score;
+        std::optional<bool> flag;
+        auto tuple_for_serialization() const noexcept { return std::tie(name, id, score, flag); }
+        auto tuple_for_serialization() noexcept { return std::tie(name, id, score, flag); }
+        bool operator==(const Rec &) const = default;
+    };
+    const std::vector<Rec> v = {{"a", 1, 0.5, true}, {"b%c", -2, 3, {}}, {"", 2147483647, -1e300, false}};
+    for (bool json : {false, true}) {
+        const std::string text = uf::serialize_print(v, json);
+        CHECK(uf::parse_text_as<std::vector<Rec>>(text, json) == v);
+        const uf::any a = uf::parse_text_as(uf::serialize_type(v), text, json);
+        CHECK(a == uf::any(v));
+    }
+    //JSON objects directly into maps, values of other types converted
+    using M = std::map<std::string, std::vector<double>>;
+    CHECK(uf::parse_text_as<M>(R"({"x": [1, 2.5, -3e2], "y": []})", true) == M{{"x", {1, 2.5, -300}}, {"y", {}}});
+    CHECK(uf::parse_text_as<std::vector<int64_t>>("[0x10, 5000000000, -7]") == std::vector<int64_t>{16, 5000000000, -7});
+    CHECK(uf::parse_text_as("la", "[1, \"a\", <d>2]").print() == "<la>[<i>1,<s>\"a\",<d>2.]");
+    CHECK(uf::parse_text_as("t2ia", "(1, 2)").print() == "<t2ia>(1,<i>2)");
+    CHECK(uf::parse_text_as("loi", "[1,,null]").print() == "<loi>[1,,]");
+    CHECK(uf::parse_text_as<std::vector<double>>(" [ 1 , 2 ] ") == std::vector<double>{1, 2});
+    //errors
+    CHECK_THROWS_AS((void)uf::parse_text_as("li", "[1, \"2\"]"), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)uf::parse_text_as("li", "[1, 2"), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)uf::parse_text_as("t2ii", "(1,2,3)"), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)uf::parse_text_as("i", "1 2"), uf::value_mismatch_error);
+    CHECK_THROWS_AS((void)uf::parse_text_as("lq", "[]"), uf::typestring_error);
+    CHECK_THROWS_WITH((void)uf::parse_text_as("msi", R"({"a": 1, "b": "x"})", true),
+                      doctest::Contains(R"({"a": 1, "b": "x"*})"));
+}
+
+/** A minimal eager coroutine task, to drive the async adapters of frame_reader/writer.*/
+template <typename T>
+struct sync_task {
+    struct promise_base {
+        std::exception_ptr ex;
+        sync_task get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(static_cast<promise_type &>(*this))}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void unhandled_exception() { ex = std::current_exception(); }
+    };
+    struct value_promise : promise_base {
+        std::optional<T> value;
+        void return_value(T t) { value = std::move(t); }
+    };
+    struct void_promise : promise_base {
+        void return_void() {}
+    };
+    using promise_type = std::conditional_t<std::is_void_v<T>, void_promise, value_promise>;
+    std::coroutine_handle<promise_type> h;
+    sync_task(std::coroutine_handle<promise_type> h) : h(h) {}
+    sync_task(const sync_task &) = delete;
+    ~sync_task() { h.destroy(); }
+    T get() {
+        REQUIRE(h.done()); //all our awaitables are ready immediately
+        if (h.promise().ex) std::rethrow_exception(h.promise().ex);
+        if constexpr (!std::is_void_v<T>) return std::move(*h.promise().value);
+    }
+};
+
+struct ready_size {
+    size_t n;
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    size_t await_resume() const noexcept { return n; }
+};
+
+TEST_CASE("framed messages") {
+    //Writer: frames of anys, serialized in place
+    uf::frame_writer w(64);
+    w.write(42);
+    w.write(std::string("hello"));
+    w.write(uf::any(std::map<std::string, int>{{"a", 1}}));
+    std::string stream;
+    for (auto s : w.segments()) stream += s;
+    CHECK(w.pending() == stream.size());
+    CHECK(stream == uf::serialize(uint32_t(uf::serialize(uf::any(42)).size())) + uf::serialize(uf::any(42)) +
+                    uf::serialize(uint32_t(uf::serialize(uf::any("hello")).size())) + uf::serialize(uf::any("hello")) +
+                    uf::serialize(uint32_t(uf::serialize(uf::any(std::map<std::string, int>{{"a", 1}})).size())) +
+                    uf::serialize(uf::any(std::map<std::string, int>{{"a", 1}})));
+
+    //Reader: all frames in one read are returned without further reads
+    uf::frame_reader r;
+    auto b = r.buffer();
+    REQUIRE(b.size() >= stream.size());
+    std::memcpy(b.data(), stream.data(), stream.size());
+    r.commit(stream.size());
+    CHECK(r.next()->get_as<int>() == 42);
+    CHECK(r.next()->get_view_as<std::string_view>() == "hello");
+    CHECK((r.next()->get_as<std::map<std::string, int>>() == std::map<std::string, int>{{"a", 1}}));
+    CHECK(!r.next());
+    CHECK(r.buffered() == 0);
+
+    //Partial frames: byte by byte
+    for (size_t i = 0; i < stream.size(); i++) {
+        auto b = r.buffer(1);
+        b[0] = stream[i];
+        r.commit(1);
+        if (auto f = r.next()) {
+            CHECK(i + 1 == stream.find(f->value(), 0) + f->value().size());
+            CHECK(r.buffered() == 0);
+        } else
+            CHECK(r.buffered() > 0);
+    }
+
+    //Writer: the ring buffer wraps around and the pending bytes are in two segments
+    const std::string s30(30, 'x');
+    const size_t flen = 4 + uf::serialize(uf::any(s30)).size(); //51 bytes
+    uf::frame_writer w2(2 * flen + 10);
+    w2.write(s30);
+    w2.write(s30);
+    w2.consume(flen);
+    w2.write(s30);
+    CHECK(w2.segments().size() == 2);
+    CHECK(w2.capacity() == 2 * flen + 10);
+    CHECK(w2.pending() == 2 * flen);
+    //If serialization throws, nothing is added
+    struct throws {
+        auto tuple_for_serialization() const { throw std::runtime_error("oops"); return std::tuple<int>(); }
+    };
+    CHECK_THROWS_AS(w2.write(throws()), std::runtime_error);
+    CHECK(w2.pending() == 2 * flen);
+    //Partial writes across segments, then growing (linearizing) the buffer
+    w2.consume(flen + 3);
+    CHECK(w2.pending() == flen - 3);
+    w2.write(s30);
+    w2.write(s30);
+    CHECK(w2.segments().size() == 1);
+    CHECK(w2.capacity() > 2 * flen + 10);
+    CHECK(w2.pending() == 3 * flen - 3);
+    w2.consume(w2.pending());
+    CHECK(w2.segments().size() == 0);
+
+    //Coroutines: a writer flushing into a transport that takes 7 bytes at a time
+    uf::frame_writer w3(100);
+    std::string wire;
+    for (int i = 0; i < 20; i++)
+        w3.write(std::make_tuple(i, std::string(i, 'a')));
+    auto writev = [&](std::span<const std::string_view> segs) {
+        size_t n = 0;
+        for (auto s : segs)
+            for (char c : s) if (n < 7) wire.push_back(c), n++;
+        return ready_size{n};
+    };
+    w3.async_flush<sync_task>(writev).get();
+    CHECK(w3.pending() == 0);
+    //...and a reader reading it in 5 byte chunks
+    size_t pos = 0;
+    auto read = [&](std::span<char> buf) {
+        const size_t n = std::min({buf.size(), size_t(5), wire.size() - pos});
+        std::memcpy(buf.data(), wire.data() + pos, n);
+        pos += n;
+        return ready_size{n};
+    };
+    uf::frame_reader r3;
+    for (int i = 0; i < 20; i++) {
+        auto f = r3.async_next<sync_task>(read).get();
+        REQUIRE(f);
+        CHECK((f->get_as<std::tuple<int, std::string>>() == std::make_tuple(i, std::string(i, 'a'))));
+    }
+    CHECK(!r3.async_next<sync_task>(read).get());
+    //End of the stream inside a frame
+    wire.resize(wire.size() - 1);
+    pos = 0;
+    uf::frame_reader r4;
+    for (int i = 0; i < 19; i++)
+        CHECK(r4.async_next<sync_task>(read).get());
+    CHECK_THROWS_AS(r4.async_next<sync_task>(read).get(), uf::value_mismatch_error);
+    w3.write(1);
+    CHECK_THROWS_AS(w3.async_flush<sync_task>([](auto) { return ready_size{0}; }).get(), uf::api_error);
+
+    //Malformed frames
+    uf::frame_reader r5(100);
+    auto b5 = r5.buffer();
+    const std::string big = uf::serialize(uint32_t(101));
+    std::memcpy(b5.data(), big.data(), 4);
+    r5.commit(4);
+    CHECK_THROWS_AS((void)r5.next(), uf::value_mismatch_error);
+    //...and we do not grow the buffer for it, even if next() is not called
+    uf::frame_reader r7(100);
+    const std::string huge = uf::serialize(uint32_t(0xffffffff));
+    std::memcpy(r7.buffer().data(), huge.data(), 4);
+    r7.commit(4);
+    CHECK_THROWS_AS((void)r7.buffer(), uf::value_mismatch_error);
+    uf::frame_reader r6;
+    const std::string bad = uf::serialize(uint32_t(9)) + uf::serialize(uf::any(42)).substr(0, 9);
+    auto b6 = r6.buffer();
+    std::memcpy(b6.data(), bad.data(), bad.size());
+    r6.commit(bad.size());
+    CHECK_THROWS_AS((void)r6.next(), uf::value_mismatch_error);
+}
@@ -1,5 +1,52 @@
 #include <benchmark/benchmark.h>
 #include <ufser.h>
+#include <wany.h>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//Count allocations per thread, so that benchmarks can report them per iteration.
+//Replacing the global operators affects the library as well.
+//GCC sees our operator delete calling free() on memory from operator new and flags every
+//(matching) new/delete pair with -Wmismatched-new-delete, so we silence it for these.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+thread_local uint64_t allocations = 0;
+void *operator new(std::size_t n) {
+    ++allocations;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void *operator new(std::size_t n, std::align_val_t a) {
+    ++allocations;
+    const size_t al = std::max(size_t(a), sizeof(void *));
+    if (void *p = std::aligned_alloc(al, (std::max(n, size_t(1)) + al - 1) / al * al)) return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t n) { return operator new(n); }
+void *operator new[](std::size_t n, std::align_val_t a) { return operator new(n, a); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { try { return operator new(n); } catch (...) { return nullptr; } }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { try { return operator new(n); } catch (...) { return nullptr; } }
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept { try { return operator new(n, a); } catch (...) { return nullptr; } }
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept { try { return operator new(n, a); } catch (...) { return nullptr; } }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
 
 void BM_construct_type_mismatch_error(benchmark::State &state) {
     for (auto _ : state)
@@ -32,6 +79,17 @@ void BM_cnv(benchmark::State &state, uf::any_view a, T &t) {
     }
 }
 
+template <class T>
+void BM_pln(benchmark::State &state, uf::any_view a, T &t) {
+    auto plan = uf::conversion_plan<T>::cached(a.type());
+    for (auto _ : state) {
+        try {
+            plan->get(a, t);
+        } catch (...) {
+        }
+    }
+}
+
 void BM_scn(benchmark::State &state, std::string_view type, std::string_view value) {
     for (auto _ : state) {
         try {
@@ -47,6 +105,13 @@ void BM_cto(benchmark::State &state, uf::any_view a, T &) {
     }
 }
 
+template <class T>
+void BM_try(benchmark::State &state, uf::any_view a, T &t) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.try_get(t));
+    }
+}
+
 template <class T>
 void BM_ser(benchmark::State &state, const T &t) {
     for (auto _ : state) {
@@ -54,6 +119,14 @@ void BM_ser(benchmark::State &state, const T &t) {
     }
 }
 
+template <class T>
+void BM_sink(benchmark::State &state, const T &t) {
+    uf::serialize_sink sink;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(uf::serialize(sink, t));
+    }
+}
+
 
 struct A     {
     bool b; char c; int32_t i; int64_t I; double d;
@@ -97,24 +170,31 @@ BENCHMARK_CAPTURE(BM_get, dese_t5bsiId, aas, as);
 BENCHMARK_CAPTURE(BM_ser, ser_t5bciId, a);
 BENCHMARK_CAPTURE(BM_get, dese_t5bciId, aa, a);
 BENCHMARK_CAPTURE(BM_scn, scan_t5bciId, aa.type(), aa.value());
+std::vector<A> va(1000, a);
+uf::any ava(va);
+BENCHMARK_CAPTURE(BM_get, dese_lt5bciId, ava, va);
 BENCHMARK_CAPTURE(BM_scn, scan_t5bciId_err, aa.type(), aa.value().substr(1));
 //deserialize a matching value into an expected
 BENCHMARK_CAPTURE(BM_get, conv_t5bciId_t5bxciId, aa, ax1);
 BENCHMARK_CAPTURE(BM_cnv, conv_t5bciId_t5bxciId, aa, ax1);
 BENCHMARK_CAPTURE(BM_cto, conv_t5bciId_t5bxciId, aa, ax1);
+BENCHMARK_CAPTURE(BM_pln, conv_t5bciId_t5bxciId, aa, ax1);
 //deserialize a non-matching value into an expected
 BENCHMARK_CAPTURE(BM_get, conv_t5bciId_t5bxsiId_err, aa, ax2);
 BENCHMARK_CAPTURE(BM_cnv, conv_t5bciId_t5bxsiId_err, aa, ax2);
 BENCHMARK_CAPTURE(BM_cto, conv_t5bciId_t5bxsiId_err, aa, ax2);
+BENCHMARK_CAPTURE(BM_try, conv_t5bciId_t5bxsiId_err, aa, ax2);
 //deserialize a matching expected into a value
 uf::any aax(ax1);
 BENCHMARK_CAPTURE(BM_get, conv_t5bdiId_t5bxciId, aax, ax1);
 BENCHMARK_CAPTURE(BM_cnv, conv_t5bdiId_t5bxciId, aax, ax1);
 BENCHMARK_CAPTURE(BM_cto, conv_t5bdiId_t5bxciId, aax, ax1);
+BENCHMARK_CAPTURE(BM_pln, conv_t5bdiId_t5bxciId, aax, ax1);
 //then into a non-matching value
 BENCHMARK_CAPTURE(BM_get, conv_t5bciId_t5bxsiId_err, aax, a3);
 BENCHMARK_CAPTURE(BM_cnv, conv_t5bciId_t5bxsiId_err, aax, a3);
 BENCHMARK_CAPTURE(BM_cto, conv_t5bciId_t5bxsiId_err, aax, a3);
+BENCHMARK_CAPTURE(BM_try, conv_t5bciId_t5bxsiId_err, aax, a3);
 
 
 //Do a more complex muti-level struct
@@ -131,6 +211,7 @@ struct AM {
 
 uf::any aam(am);
 BENCHMARK_CAPTURE(BM_ser, ser_am, am);
+BENCHMARK_CAPTURE(BM_sink, sink_am, am);
 BENCHMARK_CAPTURE(BM_get, dese_am, aam, am);
 BENCHMARK_CAPTURE(BM_scn, scan_am, aam.type(), aam.value());
 BENCHMARK_CAPTURE(BM_scn, scan_am_err, aam.type(), aam.value().substr(1));
@@ -152,6 +233,7 @@ struct AMM {
 
 uf::any aamm(amm);
 BENCHMARK_CAPTURE(BM_ser, ser_amm, amm);
+BENCHMARK_CAPTURE(BM_sink, sink_amm, amm);
 BENCHMARK_CAPTURE(BM_get, dese_amm, aamm, amm);
 BENCHMARK_CAPTURE(BM_scn, scan_amm, aamm.type(), aamm.value());
 BENCHMARK_CAPTURE(BM_scn, scan_amm_err, aamm.type(), aamm.value().substr(1));
@@ -160,6 +242,393 @@ BENCHMARK_CAPTURE(BM_get, conv_amm, aamm, amm);
 BENCHMARK_CAPTURE(BM_cnv, conv_amm, aamm, amm);
 BENCHMARK_CAPTURE(BM_cto, conv_amm, aamm, amm);
 
+//Long lists of primitives
+std::vector<int64_t> vI(1000, 0x0102030405060708);
+std::vector<double> vd(1000, 3.14);
+uf::any avI(vI), avd(vd);
+BENCHMARK_CAPTURE(BM_ser, ser_lI, vI);
+BENCHMARK_CAPTURE(BM_get, dese_lI, avI, vI);
+BENCHMARK_CAPTURE(BM_ser, ser_ld, vd);
+BENCHMARK_CAPTURE(BM_get, dese_ld, avd, vd);
+BENCHMARK_CAPTURE(BM_scn, scan_lI, avI.type(), avI.value());
+std::string slI_le = uf::serialize(vI, uf::use_tags, uf::little_endian);
+void BM_ser_le(benchmark::State &state, const std::vector<int64_t> &v) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::serialize(v, uf::use_tags, uf::little_endian));
+}
+void BM_des_le(benchmark::State &state, std::string_view s, std::vector<int64_t> &v) {
+    for (auto _ : state)
+        uf::deserialize(s, v, false, uf::use_tags, uf::little_endian);
+}
+void BM_conv_bo(benchmark::State &state, std::string_view s) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::convert_byte_order("lI", s, true));
+}
+BENCHMARK_CAPTURE(BM_ser_le, ser_lI_le, vI);
+BENCHMARK_CAPTURE(BM_des_le, dese_lI_le, slI_le, vI);
+BENCHMARK_CAPTURE(BM_conv_bo, convert_lI_le, slI_le);
+
+//Random access into a long list and a big map
+void BM_cnt_k(benchmark::State &state, uf::any_view a) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.get_content()[state.range(0)]);
+}
+void BM_idx_k(benchmark::State &state, uf::any_view a) {
+    uf::any_index idx(a);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(idx[state.range(0)]);
+}
+void BM_idx_find(benchmark::State &state, uf::any_view a) {
+    uf::any_index idx(a);
+    const uf::any key(std::to_string(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(idx.find(key));
+}
+std::vector<std::string> ls = [] { std::vector<std::string> r; for (int i = 0; i < 1000; i++) r.push_back(std::to_string(i)); return r; }();
+std::map<std::string, AS> msas = [] { std::map<std::string, AS> r; for (int i = 0; i < 1000; i++) r[std::to_string(i)] = as; return r; }();
+uf::any als(ls), amsas(msas);
+BENCHMARK_CAPTURE(BM_cnt_k, content_ls_999, als)->Arg(999);
+BENCHMARK_CAPTURE(BM_idx_k, index_ls_999, als)->Arg(999);
+BENCHMARK_CAPTURE(BM_idx_find, index_msas_find, amsas)->Arg(777);
+BENCHMARK_CAPTURE(BM_scn, scan_ls, als.type(), als.value());
+std::vector<std::string> lls(1000, std::string(40, 'x'));
+std::string slls = uf::serialize(lls);
+void BM_des_ls(benchmark::State &state, std::string_view s) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::deserialize_as<std::vector<std::string>>(s));
+}
+void BM_des_ls_pmr(benchmark::State &state, std::string_view s) {
+    std::pmr::monotonic_buffer_resource mr;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(uf::deserialize_as<std::pmr::vector<std::pmr::string>>(s, &mr));
+        mr.release();
+    }
+}
+BENCHMARK_CAPTURE(BM_des_ls, dese_ls, slls);
+BENCHMARK_CAPTURE(BM_des_ls_pmr, dese_ls_pmr, slls);
+void BM_stream(benchmark::State &state, std::string_view s, size_t chunk) {
+    for (auto _ : state) {
+        size_t n = 0;
+        uf::stream_decoder d("ls", [&n](uf::any_view v) { n += v.value().size(); });
+        for (size_t i = 0; i < s.size(); i += chunk)
+            d.feed(s.substr(i, chunk));
+        d.finish();
+        benchmark::DoNotOptimize(n);
+    }
+}
+BENCHMARK_CAPTURE(BM_stream, stream_ls_1k, slls, 1024);
+BENCHMARK_CAPTURE(BM_stream, stream_ls_64k, slls, 65536);
+BENCHMARK_CAPTURE(BM_scn, scan_msas, amsas.type(), amsas.value());
+void BM_print(benchmark::State &state, uf::any_view a) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.print_json());
+}
+void BM_print_sink(benchmark::State &state, uf::any_view a) {
+    for (auto _ : state) {
+        size_t n = 0;
+        a.print_json_to_sink([&n](std::string_view s) { n += s.size(); });
+        benchmark::DoNotOptimize(n);
+    }
+}
+std::vector<double> ld_print(100000, 3.14159);
+uf::any ald_print(ld_print);
+BENCHMARK_CAPTURE(BM_print, print_ld, ald_print);
+BENCHMARK_CAPTURE(BM_print_sink, print_sink_ld, ald_print);
+BENCHMARK_CAPTURE(BM_print, print_msas, amsas);
+BENCHMARK_CAPTURE(BM_print_sink, print_sink_msas, amsas);
+std::string json_msas = amsas.print_json();
+void BM_parse_json(benchmark::State &state, std::string_view s, std::string_view type) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::any(uf::from_text, s, true).convert_to(type));
+}
+void BM_parse_json_as(benchmark::State &state, std::string_view s, std::string_view type) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::parse_text_as(type, s, true));
+}
+BENCHMARK_CAPTURE(BM_parse_json, parse_json_msas, json_msas, amsas.type());
+BENCHMARK_CAPTURE(BM_parse_json_as, parse_json_as_msas, json_msas, amsas.type());
+void BM_wv_search(benchmark::State &state, const uf::any &a, bool indexed) {
+    uf::wview w(uf::from_raw, uf::any_view(a));
+    if (indexed) (void)w.create_index(1);
+    const uf::wview key(std::to_string(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(w.linear_search(key, 1));
+}
+BENCHMARK_CAPTURE(BM_wv_search, wv_search_msas, amsas, false)->Arg(777);
+BENCHMARK_CAPTURE(BM_wv_search, wv_search_msas_indexed, amsas, true)->Arg(777);
+void BM_wv_append(benchmark::State &state, bool many) {
+    std::vector<uf::wview> elems;
+    for (int i = 0; i < state.range(0); i++)
+        elems.emplace_back(i);
+    for (auto _ : state) {
+        uf::wview w{std::pair(uf::any(std::vector<int>{}), 0)};
+        uf::wview l = w[0][0];
+        if (many)
+            l.insert_many_after(-1, elems);
+        else
+            for (int i = 0; i < state.range(0); i++)
+                l.insert_after(i-1, elems[i]);
+        benchmark::DoNotOptimize(w.as_any());
+    }
+}
+BENCHMARK_CAPTURE(BM_wv_append, wv_append_one_by_one, false)->Arg(1000);
+BENCHMARK_CAPTURE(BM_wv_append, wv_append_many, true)->Arg(1000);
+
+void BM_ser_lt(benchmark::State &state, const std::vector<std::tuple<int, std::string, std::vector<double>>> &v, bool parallel) {
+    const auto exec = [](size_t n, const std::function<void(size_t)> &f) {
+        std::atomic<size_t> next = 0;
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < std::thread::hardware_concurrency(); i++)
+            threads.emplace_back([&] { for (size_t u; (u = next++) < n; ) f(u); });
+        for (auto &t : threads) t.join();
+    };
+    for (auto _ : state)
+        benchmark::DoNotOptimize(parallel ? uf::serialize_parallel(v, exec, 4096) : uf::serialize(v));
+}
+std::vector<std::tuple<int, std::string, std::vector<double>>> vlt = [] {
+    std::vector<std::tuple<int, std::string, std::vector<double>>> r;
+    for (int i = 0; i < 100000; i++) r.emplace_back(i, std::string(i % 50, 'x'), std::vector<double>(i % 7, 1.5));
+    return r;
+}();
+BENCHMARK_CAPTURE(BM_ser_lt, ser_lt3isld, vlt, false);
+BENCHMARK_CAPTURE(BM_ser_lt, ser_lt3isld_parallel, vlt, true);
+
+void BM_hash(benchmark::State &state, uf::any_view a) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::hash(a));
+}
+void BM_compare(benchmark::State &state, uf::any_view a) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::compare(a, a));
+}
+const uf::any as4k(std::string(4096, 'x'));
+BENCHMARK_CAPTURE(BM_hash, hash_s4k, as4k);
+BENCHMARK_CAPTURE(BM_hash, hash_ld, avd);
+BENCHMARK_CAPTURE(BM_hash, hash_msas, amsas);
+BENCHMARK_CAPTURE(BM_compare, compare_ld, avd);
+BENCHMARK_CAPTURE(BM_compare, compare_msas, amsas);
+
+template <typename T>
+void des_reuse(benchmark::State &state, std::string_view s, bool reuse) {
+    T t;
+    for (auto _ : state)
+        if (reuse) uf::deserialize(s, t, false, uf::use_tags, uf::reuse_capacity);
+        else uf::deserialize(s, t);
+}
+void BM_des_reuse_ls(benchmark::State &state, std::string_view s, bool reuse) { des_reuse<std::vector<std::string>>(state, s, reuse); }
+void BM_des_reuse_msas(benchmark::State &state, std::string_view s, bool reuse) { des_reuse<decltype(msas)>(state, s, reuse); }
+std::string smsas = uf::serialize(msas);
+BENCHMARK_CAPTURE(BM_des_reuse_ls, dese_ls, slls, false);
+BENCHMARK_CAPTURE(BM_des_reuse_ls, dese_ls_reuse, slls, true);
+BENCHMARK_CAPTURE(BM_des_reuse_msas, dese_msas, smsas, false);
+BENCHMARK_CAPTURE(BM_des_reuse_msas, dese_msas_reuse, smsas, true);
+
+void BM_compress(benchmark::State &state, const uf::any &a) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::compressed_any(a));
+}
+void BM_decompress(benchmark::State &state, const uf::any &a) {
+    const std::string s = uf::serialize(uf::compressed_any(a));
+    uf::compressed_any c;
+    for (auto _ : state) {
+        uf::deserialize(s, c); //new content, so view() decompresses
+        benchmark::DoNotOptimize(c.view());
+    }
+}
+BENCHMARK_CAPTURE(BM_compress, compress_msas, amsas);
+BENCHMARK_CAPTURE(BM_decompress, decompress_msas, amsas);
+
+//Workloads of realistic shapes, parameterized by the number of elements.
+//Each reports the throughput in serialized bytes and the allocations per operation.
+//Use 'make bench-baseline' to save a JSON baseline of all benchmarks and
+//'make bench-check' to compare against it (see serperf_compare.py).
+using wl_lI = std::vector<int64_t>;
+using wl_ls = std::vector<std::string>;
+using wl_lt3sid = std::vector<std::tuple<std::string, int32_t, double>>;
+using wl_msls = std::map<std::string, std::vector<std::string>>;
+using wl_msmsI = std::map<std::string, std::map<std::string, int64_t>>;
+
+template <typename T> T make_workload(size_t n);
+template <> wl_lI make_workload<wl_lI>(size_t n) {
+    wl_lI r(n);
+    for (size_t i = 0; i < n; i++) r[i] = int64_t(i * 0x9e3779b97f4a7c15);
+    return r;
+}
+template <> wl_ls make_workload<wl_ls>(size_t n) {
+    wl_ls r;
+    for (size_t i = 0; i < n; i++) r.emplace_back(8 + i % 56, char('a' + i % 26));
+    return r;
+}
+template <> wl_lt3sid make_workload<wl_lt3sid>(size_t n) {
+    wl_lt3sid r;
+    for (size_t i = 0; i < n; i++) r.emplace_back("name" + std::to_string(i), int32_t(i), i * 0.5);
+    return r;
+}
+template <> wl_msls make_workload<wl_msls>(size_t n) {
+    wl_msls r;
+    for (size_t i = 0; i < n; i++) r["key" + std::to_string(i)] = std::vector<std::string>(i % 5, "value" + std::to_string(i));
+    return r;
+}
+template <> wl_msmsI make_workload<wl_msmsI>(size_t n) {
+    wl_msmsI r;
+    for (size_t i = 0; i < n; i++) r["outer" + std::to_string(i / 16)]["inner" + std::to_string(i % 16)] = int64_t(i);
+    return r;
+}
+
+/** The type to deserialize_view() a workload into: strings replaced by string_views.*/
+template <typename T> struct view_of { using type = T; };
+template <> struct view_of<std::string> { using type = std::string_view; };
+template <typename T> struct view_of<std::vector<T>> { using type = std::vector<typename view_of<T>::type>; };
+template <typename K, typename V> struct view_of<std::map<K, V>> { using type = std::map<typename view_of<K>::type, typename view_of<V>::type>; };
+template <typename ...T> struct view_of<std::tuple<T...>> { using type = std::tuple<typename view_of<T>::type...>; };
+
+/** A typestring the workload converts to (and can be converted back from): elements or mapped values as 'a'.*/
+template <typename T> std::string_view any_elements_type() { return uf::serialize_type<T>().front() == 'm' ? std::string_view("msa") : std::string_view("la"); }
+
+void set_counters(benchmark::State &state, size_t bytes, uint64_t allocations_before) {
+    state.SetBytesProcessed(int64_t(state.iterations() * bytes));
+    state.counters["allocs"] = benchmark::Counter(double(allocations - allocations_before), benchmark::Counter::kAvgIterations);
+}
+
+template <typename T>
+void BM_wl_serialize(benchmark::State &state) {
+    const T t = make_workload<T>(state.range(0));
+    const size_t len = uf::serialize(t).size();
+    const uint64_t before = allocations;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::serialize(t));
+    set_counters(state, len, before);
+}
+template <typename T>
+void BM_wl_deserialize(benchmark::State &state) {
+    const std::string s = uf::serialize(make_workload<T>(state.range(0)));
+    const uint64_t before = allocations;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::deserialize_as<T>(s));
+    set_counters(state, s.size(), before);
+}
+template <typename T>
+void BM_wl_deserialize_view(benchmark::State &state) {
+    const std::string s = uf::serialize(make_workload<T>(state.range(0)));
+    const uint64_t before = allocations;
+    for (auto _ : state) {
+        typename view_of<T>::type v;
+        uf::deserialize_view(s, v);
+        benchmark::DoNotOptimize(v);
+    }
+    set_counters(state, s.size(), before);
+}
+template <typename T>
+void BM_wl_deserialize_convert(benchmark::State &state) {
+    const uf::any a = uf::any(make_workload<T>(state.range(0))).convert_to(any_elements_type<T>());
+    const uint64_t before = allocations;
+    for (auto _ : state) {
+        T t;
+        uf::deserialize_convert(a.value(), a.type(), t);
+        benchmark::DoNotOptimize(t);
+    }
+    set_counters(state, a.value().size(), before);
+}
+template <typename T>
+void BM_wl_scan(benchmark::State &state) {
+    const uf::any a(make_workload<T>(state.range(0)));
+    const uint64_t before = allocations;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::impl::serialize_scan_by_type(a.type(), a.value()));
+    set_counters(state, a.value().size(), before);
+}
+template <typename T>
+void BM_wl_print(benchmark::State &state) {
+    const uf::any a(make_workload<T>(state.range(0)));
+    const uint64_t before = allocations;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.print());
+    set_counters(state, a.value().size(), before);
+}
+template <typename T>
+void BM_wl_print_json(benchmark::State &state) {
+    const uf::any a(make_workload<T>(state.range(0)));
+    const uint64_t before = allocations;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.print_json());
+    set_counters(state, a.value().size(), before);
+}
+template <typename T>
+void BM_wl_parse_text(benchmark::State &state) {
+    const std::string text = uf::any(make_workload<T>(state.range(0))).print();
+    const uint64_t before = allocations;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::any(uf::from_text, text));
+    set_counters(state, text.size(), before);
+}
+template <typename T>
+void BM_wl_parse_json(benchmark::State &state) {
+    const std::string json = uf::any(make_workload<T>(state.range(0))).print_json();
+    const uint64_t before = allocations;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uf::parse_text_as(uf::serialize_type<T>(), json, true));
+    set_counters(state, json.size(), before);
+}
+/** Overwrite 16 elements of a list with other elements, then flatten.*/
+template <typename T>
+void BM_wl_wview_set(benchmark::State &state) {
+    const uf::any a(make_workload<T>(state.range(0)));
+    const uint32_t n = uint32_t(state.range(0)), step = std::max(n / 16, 1u);
+    const uint64_t before = allocations;
+    for (auto _ : state) {
+        uf::wview w(uf::from_raw, uf::any_view(a));
+        for (uint32_t i = 0; i < n; i += step)
+            w[i].set(w[(i + n / 2 + 1) % n]);
+        benchmark::DoNotOptimize(w.as_any());
+    }
+    set_counters(state, a.value().size(), before);
+}
+
+void workload_sizes(benchmark::internal::Benchmark *b) { b->RangeMultiplier(32)->Range(16, 16 << 10); }
+#define WORKLOAD(f, T) BENCHMARK_TEMPLATE(f, T)->Apply(workload_sizes)
+#define WORKLOADS(f) WORKLOAD(f, wl_lI); WORKLOAD(f, wl_ls); WORKLOAD(f, wl_lt3sid); WORKLOAD(f, wl_msls); WORKLOAD(f, wl_msmsI)
+WORKLOADS(BM_wl_serialize);
+WORKLOADS(BM_wl_deserialize);
+WORKLOADS(BM_wl_deserialize_view);
+WORKLOADS(BM_wl_deserialize_convert);
+WORKLOADS(BM_wl_scan);
+WORKLOADS(BM_wl_print);
+WORKLOADS(BM_wl_print_json);
+WORKLOADS(BM_wl_parse_text);
+WORKLOADS(BM_wl_parse_json);
+WORKLOAD(BM_wl_wview_set, wl_lI);
+WORKLOAD(BM_wl_wview_set, wl_ls);
+WORKLOAD(BM_wl_wview_set, wl_lt3sid);
+//Throughput of independent threads (e.g., to catch contention on shared caches)
+BENCHMARK_TEMPLATE(BM_wl_serialize, wl_lt3sid)->Arg(1024)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_wl_deserialize, wl_lt3sid)->Arg(1024)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_wl_parse_json, wl_msls)->Arg(1024)->ThreadRange(1, 8)->UseRealTime();
+
+//Framed messages: 'range(0)' small messages written by a frame_writer, moved to a
+//frame_reader in a single "read" and each deserialized as views. Steady state shall not allocate.
+void BM_frames(benchmark::State &state) {
+    const auto msg = std::make_tuple(std::string("topic/name"), int32_t(42), 3.14, std::string(40, 'x'));
+    uf::frame_writer w;
+    uf::frame_reader r;
+    size_t bytes = 0;
+    const uint64_t before = allocations;
+    for (auto _ : state) {
+        for (int64_t i = 0; i < state.range(0); i++)
+            w.write(msg);
+        bytes = w.pending();
+        for (std::string_view seg : w.segments()) {
+            auto b = r.buffer(seg.size());
+            std::memcpy(b.data(), seg.data(), seg.size());
+            r.commit(seg.size());
+        }
+        w.consume(w.pending());
+        while (auto f = r.next())
+            benchmark::DoNotOptimize(f->get_view_as<std::tuple<std::string_view, int32_t, double, std::string_view>>());
+    }
+    set_counters(state, bytes, before);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_frames)->Arg(1)->Arg(64);
 
 // Register the function as a benchmark
 // Run the benchmark
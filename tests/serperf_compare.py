@@ -0,0 +1,59 @@
+#!/usr/bin/env -S python3
+
+""" Compares two JSON outputs of serperf (--benchmark_out_format=json) and
+    fails if any benchmark got slower or allocates more than in the baseline.
+    Usage: serperf_compare.py [--tolerance 0.1] baseline.json current.json
+    Times are compared per iteration (real time for benchmarks measured with
+    UseRealTime(), CPU time otherwise), taking the fastest repetition, and must
+    not grow by more than the tolerance. The 'allocs' counter must not grow by
+    more than the tolerance plus one allocation. Benchmarks missing from
+    either file are listed, but do not fail the comparison."""
+
+import argparse
+import json
+import sys
+
+UNITS = {'ns': 1, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+
+def ns(b):
+    key = 'real_time' if '/real_time' in b['name'] else 'cpu_time'
+    return b[key] * UNITS[b.get('time_unit', 'ns')]
+
+def load(path):
+    """ Returns the fastest repetition of each benchmark by name."""
+    with open(path) as f:
+        data = json.load(f)
+    ret = {}
+    for b in data['benchmarks']:
+        if b.get('run_type', 'iteration') != 'iteration':
+            continue
+        name = b.get('run_name', b['name'])
+        if name not in ret or ns(b) < ns(ret[name]):
+            ret[name] = b
+    return ret
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare serperf results against a baseline.')
+    parser.add_argument('--tolerance', type=float, default=0.1, help='allowed relative slowdown (default: 0.1)')
+    parser.add_argument('baseline')
+    parser.add_argument('current')
+    args = parser.parse_args()
+    base, cur = load(args.baseline), load(args.current)
+    failed = []
+    for name in sorted(base.keys() & cur.keys()):
+        b, c = base[name], cur[name]
+        if ns(c) > ns(b) * (1 + args.tolerance):
+            failed.append(f'{name}: time {ns(b):.1f}ns -> {ns(c):.1f}ns ({ns(c) / ns(b) - 1:+.0%})')
+        if 'allocs' in b and 'allocs' in c and c['allocs'] > b['allocs'] * (1 + args.tolerance) + 1:
+            failed.append(f'{name}: allocs {b["allocs"]:.1f} -> {c["allocs"]:.1f}')
+    for name in sorted(base.keys() - cur.keys()):
+        print(f'missing from current: {name}')
+    for name in sorted(cur.keys() - base.keys()):
+        print(f'not in baseline: {name}')
+    for f in failed:
+        print('REGRESSION', f)
+    print(f'{len(base.keys() & cur.keys())} benchmarks compared, {len(failed)} regressions.')
+    return 1 if failed else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
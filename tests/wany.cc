@@ -5,6 +5,8 @@
 #include <list>
 #include <algorithm>
 #include <random>
+#include <thread>
+#include <mutex>
 
 using namespace std::string_view_literals;
 
@@ -735,6 +737,78 @@ TEST_CASE_TEMPLATE("wv insert/delete optional", wview, uf::wview, uf::gwview, uf
     random_delete(wo, "optional");
 }
 
+TEST_CASE_TEMPLATE("wv insert_many_after", wview, uf::wview, uf::gwview, uf::twview) {
+    wview l{std::vector<int>{1,2,3}};
+    CHECK_NOTHROW(l.insert_many_after(-1, {wview{10}, wview{11}}));
+    CHECK(l.as_any().print() == "<li>[10,11,1,2,3]");
+    CHECK_NOTHROW(l.insert_many_after(2, {wview{20}, wview{21}, wview{22}}));
+    CHECK(l.as_any().print() == "<li>[10,11,1,20,21,22,2,3]");
+    CHECK_NOTHROW(l.insert_many_after(7, {wview{30}}));
+    CHECK_NOTHROW(l.insert_many_after(0, {}));
+    CHECK(l.as_any().print() == "<li>[10,11,1,20,21,22,2,3,30]");
+    CHECK(l.size() == 9);
+    CHECK(l[6].template get_as<int>() == 2); //children parsed before are shifted
+    CHECK_THROWS_AS(l.insert_many_after(0, {wview{40}, wview{"bad"}}), uf::type_mismatch_error);
+    CHECK_THROWS_AS(l.insert_many_after(9, {wview{40}}), std::out_of_range);
+    CHECK(l.as_any().print() == "<li>[10,11,1,20,21,22,2,3,30]"); //nothing inserted
+    CHECK_NOTHROW(l.check());
+
+    //map inside an any: the any's length is adjusted
+    wview a{std::pair(uf::any(std::map<std::string, int>{{"a", 1}}), 5)};
+    wview m = a[0][0];
+    CHECK_NOTHROW(m.insert_many_after(0, {wview{std::pair(std::string("b"), 2)}, wview{std::pair(std::string("c"), 3)}}));
+    CHECK(a.as_any().print() == "<t2ai>(<msi>{\"a\":1,\"b\":2,\"c\":3},5)");
+    CHECK_THROWS_AS(m.insert_many_after(0, {wview{1}}), uf::type_mismatch_error);
+    CHECK_NOTHROW(a.check());
+
+    //tuples and optionals insert one by one
+    wview t{std::tuple(1, 2)};
+    CHECK_NOTHROW(t.insert_many_after(0, {wview{"x"}, wview{2.5}}));
+    CHECK(t.as_any().print() == "<t4isdi>(1,\"x\",2.5,2)");
+    wview o{std::optional<int>{}};
+    CHECK_NOTHROW(o.insert_many_after(-1, {wview{7}}));
+    CHECK(o.as_any().print() == "<oi>7");
+    CHECK_THROWS_AS(wview{1}.insert_many_after(-1, {wview{7}}), uf::type_mismatch_error);
+}
+
+TEST_CASE_TEMPLATE("wv erase_many", wview, uf::wview, uf::gwview, uf::twview) {
+    wview l{std::vector<int>{0,1,2,3,4,5,6,7,8,9}};
+    wview l3 = l[3], l5 = l[5], l8 = l[8];
+    CHECK_NOTHROW(l.erase_many(2, 4)); //children parsed before in and after the range
+    CHECK(l.as_any().print() == "<li>[0,1,6,7,8,9]");
+    CHECK(l3.as_any().print() == "<i>3"); //erased ones are detached, but intact
+    CHECK_NOTHROW(l5.set(55));
+    CHECK(l.as_any().print() == "<li>[0,1,6,7,8,9]");
+    CHECK(l[4].template get_as<int>() == 8); //children parsed before are shifted
+    CHECK_NOTHROW(l8.set(88));
+    CHECK(l.as_any().print() == "<li>[0,1,6,7,88,9]");
+    CHECK_NOTHROW(l.erase_many(0, 2)); //front
+    CHECK_NOTHROW(l.erase_many(2, 2)); //back
+    CHECK_NOTHROW(l.erase_many(1, 0));
+    CHECK(l.as_any().print() == "<li>[6,7]");
+    CHECK_THROWS_AS(l.erase_many(1, 2), std::out_of_range);
+    CHECK_NOTHROW(l.erase_many(0, 2)); //to empty
+    CHECK(l.as_any().print() == "<li>[]");
+    CHECK(l.size() == 0);
+    CHECK_NOTHROW(l.check());
+
+    //map inside an any with an index: the any's length and the index are adjusted
+    wview a{std::pair(uf::any(std::map<std::string, int>{{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}}), 5)};
+    wview m = a[0][0];
+    CHECK(m.create_index(0)=="");
+    CHECK_NOTHROW(m.erase_many(1, 2));
+    CHECK(a.as_any().print() == "<t2ai>(<msi>{\"a\":1,\"d\":4},5)");
+    CHECK(!m.linear_search(wview{"b"}, 0).first);
+    CHECK(m.linear_search(wview{"d"}, 0).first.as_any().as_view().print()=="<t2si>(\"d\",4)");
+    CHECK_NOTHROW(a.check());
+
+    //tuples erase one by one
+    wview t{std::tuple(1, "x", 2.5, 2)};
+    CHECK_NOTHROW(t.erase_many(1, 2));
+    CHECK(t.as_any().print() == "<t2ii>(1,2)");
+    CHECK_THROWS_AS(t.erase_many(0, 1), uf::type_mismatch_error);
+}
+
 TEST_CASE_TEMPLATE("wv insert/delete tuple", wview, uf::wview, uf::gwview, uf::twview) {
     std::array<int, 4> a = { 1,2,3,4 };
     wview w(a), wf = w[0];
@@ -922,6 +996,90 @@ TEST_CASE_TEMPLATE("wv swap_content_with", wview, uf::wview, uf::gwview, uf::twv
     CHECK_THROWS_AS(w[3][2].swap_content_with(w), uf::api_error);
 }
 
+TEST_CASE_TEMPLATE("wv snapshot", wview, uf::wview, uf::gwview, uf::twview)
+{
+    wview w{std::tuple(std::string("alef"), std::vector<int>{1,2,3})};
+    const std::string_view before = *w.get_consecutive_value();
+    wview s = w.snapshot();
+    CHECK(s.get_consecutive_value()->data() == before.data()); //no bytes copied
+    CHECK(!s.indexof());
+    CHECK_NOTHROW(w[1][0].set(wview{42}));
+    CHECK_NOTHROW(w[0].set(wview{"bet"}));
+    CHECK_NOTHROW(w[1].insert_after(-1, wview{7}));
+    CHECK(w.as_any().print() == "<t2sli>(\"bet\",[7,42,2,3])");
+    CHECK(s.as_any().print() == "<t2sli>(\"alef\",[1,2,3])");
+    CHECK(*s.get_consecutive_value() == before); //the original bytes are intact
+    CHECK_NOTHROW(s[1][2].set(wview{5})); //snapshots are themselves modifiable
+    CHECK(s.as_any().print() == "<t2sli>(\"alef\",[1,2,5])");
+    CHECK(w.as_any().print() == "<t2sli>(\"bet\",[7,42,2,3])");
+    CHECK(!wview{}.snapshot());
+    CHECK_NOTHROW(w.check());
+    CHECK_NOTHROW(s.check());
+}
+
+TEST_CASE_TEMPLATE("wv compact", wview, uf::wview, uf::gwview, uf::twview)
+{
+    wview w{std::tuple(std::string("alef"), std::vector<int>{1,2,3}, 4.5)};
+    for (int i = 0; i < 10; i++)
+        CHECK_NOTHROW(w[1].insert_after(0, wview{i}));
+    CHECK_NOTHROW(w[1][3].set(wview{42}));
+    CHECK_NOTHROW(w[0].set(wview{"bet"}));
+    wview elem = w[1][2];
+    const std::string printed = w.as_any().print();
+    CHECK(printed == "<t3slid>(\"bet\",[1,9,8,42,6,5,4,3,2,1,0,2,3],4.5)");
+    CHECK(!w.get_consecutive_value());
+    CHECK(w.compact(1000000)==false);
+    CHECK(w.compact());
+    CHECK(w.get_consecutive_value());
+    CHECK(w.as_any().print() == printed);
+    CHECK_NOTHROW(w.check());
+    //sub-views remain valid and linked
+    CHECK(elem.template get_as<int>() == 8);
+    CHECK_NOTHROW(elem.set(wview{-8}));
+    CHECK(w.as_any().print() == "<t3slid>(\"bet\",[1,9,-8,42,6,5,4,3,2,1,0,2,3],4.5)");
+    CHECK_NOTHROW(w[1].erase(0));
+    CHECK_NOTHROW(w[2].set(wview{std::string("x")}));
+    CHECK(w.as_any().print() == "<t3slis>(\"bet\",[9,-8,42,6,5,4,3,2,1,0,2,3],\"x\")");
+    CHECK_NOTHROW(w.check());
+    //compacting a sub-view
+    CHECK_NOTHROW(w[1].compact());
+    CHECK(w[1].get_consecutive_value());
+    CHECK(w.as_any().print() == "<t3slis>(\"bet\",[9,-8,42,6,5,4,3,2,1,0,2,3],\"x\")");
+    CHECK_NOTHROW(w.check());
+    CHECK(!wview{}.compact());
+}
+
+TEST_CASE("wv snapshot threads")
+{
+    uf::wview w{std::vector<int>(16, 0)}, published = w.snapshot();
+    std::mutex m;
+    std::atomic_bool done = false;
+    std::atomic_int bad = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+        readers.emplace_back([&] {
+            while (!done) {
+                uf::wview b;
+                { std::lock_guard _(m); b = published; }
+                uf::wview r = b.snapshot();
+                const int first = r[0].get_as<int>();
+                for (uint32_t i = 1; i < r.size(); i++)
+                    if (r[i].get_as<int>() != first) bad++;
+            }
+        });
+    for (int round = 1; round <= 200; round++) {
+        for (uint32_t i = 0; i < w.size(); i++)
+            w[i].set(uf::wview{round});
+        uf::wview s = w.snapshot();
+        std::lock_guard _(m);
+        published = std::move(s);
+    }
+    done = true;
+    for (auto &t : readers) t.join();
+    CHECK(bad == 0);
+    CHECK(published.as_any().print() == w.as_any().print());
+}
+
 TEST_CASE("indexof") {
     uf::wview w{std::vector<std::string>{"alef", "bet", "gimel"}};
     CHECK(w[1].indexof() == 1);
@@ -1081,6 +1239,83 @@ TEST_CASE("linear_search JSON") {
     CHECK(uf::wview(msa).linear_search(uf::wview("c"), 1).first[1][0].as_any().as_view().print() == "<d>42.42");
 }
 
+TEST_CASE_TEMPLATE("linear_search index", wview, uf::wview, uf::gwview, uf::twview) {
+    std::vector<std::tuple<int, double, bool>> lid = {{1,42.1,true}, {17,42.17,true}, {5,42.5,false}, {17,42.172,false}};
+    wview vlid{lid};
+    CHECK(!vlid.has_index());
+    CHECK(wview{1}.create_index(1).length());
+    CHECK(vlid.create_index(4).length()); //more members than the tuple has
+    CHECK(vlid.create_index(1)=="");
+    CHECK(vlid.has_index());
+    CHECK_NOTHROW(vlid.check());
+    auto find = [&vlid](auto v, int n) {
+        auto [w, err] = vlid.linear_search(wview{v}, n);
+        CHECK(err=="");
+        return w ? w.as_any().as_view().print() : std::string("none");
+    };
+    //duplicate keys: the first one is found, as without the index
+    CHECK(find(17, 1)=="<t3idb>(17,42.17,true)");
+    CHECK(find(17, 0)=="<t3idb>(17,42.17,true)");
+    CHECK(find(5, 1)=="<t3idb>(5,42.5,false)");
+    CHECK(find(3, 1)=="none");
+    //n==2 is not covered by the index, falls back to linear search
+    CHECK(find(std::pair(17,42.172), 2)=="<t3idb>(17,42.172,false)");
+    CHECK(vlid.linear_search(wview{1.}, 1).second.length()); //type mismatch still reported
+
+    //erase the first 17: the second one is found
+    CHECK_NOTHROW(vlid.erase(1));
+    CHECK(find(17, 1)=="<t3idb>(17,42.172,false)");
+    //insert a new element to the front and a duplicate of 5 to the end
+    CHECK_NOTHROW(vlid.insert_after(-1, wview{std::tuple(3, 1.5, true)}));
+    CHECK_NOTHROW(vlid.insert_after(3, wview{std::tuple(5, 2.5, true)}));
+    CHECK(find(3, 1)=="<t3idb>(3,1.5,true)");
+    CHECK(find(5, 1)=="<t3idb>(5,42.5,false)");
+    //change the key of an element via a descendant
+    CHECK_NOTHROW(vlid[2][0].set(wview{6}));
+    CHECK(find(5, 1)=="<t3idb>(5,2.5,true)");
+    CHECK(find(6, 1)=="<t3idb>(6,42.5,false)");
+    //swap two elements
+    CHECK_NOTHROW(vlid[0].swap_content_with(vlid[4]));
+    CHECK(find(3, 1)=="<t3idb>(3,1.5,true)");
+    CHECK(vlid.linear_search(wview{3}, 1).first==vlid[4]);
+    //swap with an element outside
+    wview other{std::tuple(7, 7.5, false)};
+    CHECK_NOTHROW(vlid[1].swap_content_with(other));
+    CHECK(find(7, 1)=="<t3idb>(7,7.5,false)");
+    CHECK(find(1, 1)=="none");
+    CHECK(other.as_any().as_view().print()=="<t3idb>(1,42.1,true)");
+    CHECK_NOTHROW(vlid.check());
+    CHECK(vlid.as_any().as_view().print()=="<lt3idb>[(5,2.5,true),(7,7.5,false),(6,42.5,false),(17,42.172,false),(3,1.5,true)]");
+
+    //setting the whole list rebuilds the index lazily
+    CHECK_NOTHROW(vlid.set(wview{lid}));
+    CHECK(vlid.has_index());
+    CHECK(find(1, 1)=="<t3idb>(1,42.1,true)");
+    CHECK_NOTHROW(vlid.insert_many_after(0, {wview{std::tuple(8, 0.5, true)}, wview{std::tuple(9, 0.5, true)}}));
+    CHECK(find(9, 1)=="<t3idb>(9,0.5,true)");
+    CHECK_NOTHROW(vlid.erase(1));
+    CHECK_NOTHROW(vlid.erase(1));
+    CHECK(find(17, 1)=="<t3idb>(17,42.17,true)");
+    vlid.drop_index();
+    CHECK(!vlid.has_index());
+    CHECK(find(17, 1)=="<t3idb>(17,42.17,true)");
+
+    //maps, also as a member of a tuple
+    std::map<std::string, int> msi = {{"a", 1}, {"b", 2}, {"c", 3}};
+    wview tmsi{std::pair(msi, 42)};
+    wview m = tmsi[0];
+    CHECK(m.create_index(0)=="");
+    CHECK(m.linear_search(wview{"b"}, 1).first.as_any().as_view().print()=="<t2si>(\"b\",2)");
+    CHECK_NOTHROW(m.linear_search(wview{"b"}, 1).first[1].set(wview{22})); //value change, key stays
+    CHECK_NOTHROW(m.linear_search(wview{"c"}, 1).first[0].set(wview{"d"}));
+    CHECK(!m.linear_search(wview{"c"}, 1).first);
+    CHECK(m.linear_search(wview{"d"}, 1).first.as_any().as_view().print()=="<t2si>(\"d\",3)");
+    CHECK_NOTHROW(m.insert_after(0, wview{std::pair(std::string("x"), 9)}));
+    CHECK(m.linear_search(wview{"x"}, 0).first.as_any().as_view().print()=="<t2si>(\"x\",9)");
+    CHECK_NOTHROW(tmsi.check());
+    CHECK(tmsi.as_any().as_view().print()=="<t2msii>({\"a\":1,\"x\":9,\"b\":22,\"d\":3},42)");
+}
+
 TEST_CASE("from any") {
     uf::any a(uf::from_text, "{\"a\":2,\"b\":4}");
     uf::wview va(uf::from_raw, a); //'a' is now officially invalid as va can destroy its value
@@ -1239,4 +1474,69 @@ TEST_CASE("Multi-level any 2") {
     REQUIRE_NOTHROW(vla[2][0].erase(0));
     REQUIRE_NOTHROW(vla.check(LOC));
     CHECK(vla.as_any().as_view().print() == "<la>[<i>1,<i>2,<la>[<i>42,<i>4242]]");
-}
\ No newline at end of file
+}
+TEST_CASE("arena") {
+    //oversize allocations with the global and thread-local allocators
+    const std::string big(3 * uf::impl::page_size / 2, 'b');
+    CHECK(uf::gwview(uf::any(big)).as_any().as_view().get_as<std::string>() == big);
+    CHECK(uf::twview(uf::any(big)).as_any().as_view().get_as<std::string>() == big);
+
+    CHECK(uf::arena::current() == nullptr);
+    CHECK_THROWS_AS(uf::awview(uf::any(1)), uf::api_error);
+
+    uf::arena_page_pool pool(4096);
+    size_t used_pages;
+    {
+        uf::arena a(pool);
+        uf::arena::scope sa(a);
+        CHECK(uf::arena::current() == &a);
+        uf::awview w(std::vector<std::string>(100, std::string(100, 'x')));
+        REQUIRE_NOTHROW(w[3].set("yy"));
+        REQUIRE_NOTHROW(w.check(LOC));
+        CHECK(w[3].as_any().as_view().get_as<std::string>() == "yy");
+        CHECK(w.size() == 100);
+        uf::awview wb{uf::any(big)};
+        CHECK(wb.as_any().as_view().get_as<std::string>() == big);
+        {
+            uf::arena b;
+            uf::arena::scope sb(b);
+            CHECK(uf::arena::current() == &b);
+            uf::awview x(uf::any(42));
+            CHECK(x.as_any().as_view().get_as<int>() == 42);
+            CHECK(b.pages() == 1);
+        }
+        CHECK(uf::arena::current() == &a);
+        used_pages = a.pages();
+        CHECK(used_pages >= 1);
+        CHECK(pool.free_pages() == 0);
+    }
+    CHECK(uf::arena::current() == nullptr);
+    CHECK(pool.free_pages() == used_pages);
+    {
+        //views are bound to the arena they were created in
+        uf::arena a, b;
+        uf::awview w = uf::make_awview(a, std::vector<std::string>(10, "x"));
+        CHECK(uf::arena::current() == nullptr);
+        REQUIRE_NOTHROW(w[1].set(big)); //no scope needed
+        REQUIRE_NOTHROW(w.insert_after(1, uf::make_awview(a, std::string("y"))));
+        CHECK(w.size() == 11);
+        const size_t pages = a.pages();
+        uf::arena::scope sb(b);
+        REQUIRE_NOTHROW(w[3].set(std::string(100, 'z')));
+        REQUIRE_NOTHROW(w.erase(0));
+        CHECK(b.pages() == 0);
+        CHECK(a.pages() >= pages);
+        CHECK(uf::arena::current() == &b);
+        REQUIRE_NOTHROW(w.check(LOC));
+        CHECK(w[0].as_any().as_view().get_as<std::string>() == big);
+        CHECK(w[2].as_any().as_view().get_as<std::string>() == std::string(100, 'z'));
+    }
+    {
+        uf::arena a(pool);
+        uf::arena::scope sa(a);
+        uf::awview w(uf::any("abc"));
+        CHECK(pool.free_pages() == used_pages - 1); //recycled
+        a.reset();
+        CHECK(pool.free_pages() == used_pages);
+    }
+}
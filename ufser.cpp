@@ -3,6 +3,22 @@
  * Copyright 2024 Ericsson AB
  */
 #include "ufser.h"
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifndef _WIN32
+#include <filesystem>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 uint32_t uf::impl::default_value(const char *&type, const char *const tend, char **to) {
     if (type > tend) throw internal_typestring_error{type};
@@ -868,6 +884,215 @@ template std::unique_ptr<uf::value_error>
 uf::impl::cant_convert<true, true>(deserialize_convert_params &p, StringViewAccumulator *target);
 //cant_convert<false,true> is invalid
 
+namespace uf::impl
+{
+namespace {
+/** Returns the serialized length of a type if it is fixed, or -1 if it depends on the value.*/
+ptrdiff_t fixed_type_len(const char *type, const char *tend) noexcept {
+    ptrdiff_t ret = 0;
+    while (type < tend)
+        switch (*type++) {
+        case 'b': case 'c': ret += 1; break;
+        case 'i': ret += 4; break;
+        case 'I': case 'd': ret += 8; break;
+        case 't': while (type < tend && '0' <= *type && *type <= '9') type++; break;
+        default: return -1;
+        }
+    return ret;
+}
+inline uint32_t get32(const char *p) noexcept { uint32_t v; memcpy(&v, p, 4); return be32toh(v); }
+inline uint64_t get64(const char *p) noexcept { uint64_t v; memcpy(&v, p, 8); return be64toh(v); }
+inline double getd(const char *p) noexcept { return get_wire_double(p); }
+/** Skips 'size' elements, each consisting of 'n' length-prefixed byte strings (like 's' or 'a').
+ * Returns the number of elements not skipped, which is non-zero only if the value is too short.
+ * In that case 'p' points to the first element not skipped.*/
+uint32_t skip_length_prefixed(const char *&p, const char *end, uint32_t size, int n) noexcept {
+    for (; size; --size) {
+        const char *q = p;
+        for (int i = 0; i < n; i++) {
+            if (end - q < 4) return size;
+            const uint32_t len = get32(q);
+            q += 4;
+            if (uint32_t(end - q) < len) return size;
+            q += len;
+        }
+        p = q;
+    }
+    return 0;
+}
+inline void put32(std::string &to, uint32_t v) { v = htobe32(v); to.append(reinterpret_cast<const char *>(&v), 4); }
+inline void put64(std::string &to, uint64_t v) { v = htobe64(v); to.append(reinterpret_cast<const char *>(&v), 8); }
+inline void putd(std::string &to, double v) { char buf[8], *p = buf; put_wire_double(v, p); to.append(buf, 8); }
+} //ns
+
+conversion_program::conversion_program(std::string_view source, std::string_view target, serpolicy policy)
+    : _type(source)
+{
+    _identical = source == target;
+    const char *s = _type.data(), *const se = s + _type.size();
+    const char *t = target.data(), *const te = t + target.size();
+    if (s == se || t == te) { _valid = _identical; return; } //void
+    while (s < se && t < te)
+        if (!compile(s, se, t, te, policy)) {
+            _code.clear();
+            return;
+        }
+    _valid = s == se && t == te;
+    if (!_valid) _code.clear();
+}
+
+void conversion_program::emit_identical(const char *s, size_t len) {
+    if (const ptrdiff_t flen = fixed_type_len(s, s + len); flen >= 0) {
+        if (_code.size() && _code.back().code == op::copy) _code.back().arg1 += flen;
+        else _code.push_back({op::copy, uint32_t(flen)});
+    } else if (len == 1 && *s == 's')
+        _code.push_back({op::str});
+    else if (*s == 'l' && fixed_type_len(s + 1, s + len) > 0)
+        _code.push_back({op::fixed_list, uint32_t(fixed_type_len(s + 1, s + len))});
+    else
+        _code.push_back({op::scan, uint32_t(s - _type.data()), uint32_t(len)});
+}
+
+bool conversion_program::compile(const char *&s, const char *se, const char *&t, const char *te, serpolicy policy) {
+    const auto [slen, sproblem] = parse_type(s, se, false);
+    const auto [tlen, tproblem] = parse_type(t, te, false);
+    if (!!sproblem || !!tproblem) return false;
+    if (slen == tlen && memcmp(s, t, slen) == 0) {
+        emit_identical(s, slen);
+        s += slen;
+        t += tlen;
+        return true;
+    }
+    if (*s == *t)
+        switch (*s) {
+        case 'l':
+        case 'o':
+        case 'm': {
+            const char c = *s;
+            const size_t at = _code.size();
+            _code.push_back({c == 'o' ? op::opt : op::list});
+            s++, t++;
+            if (!compile(s, se, t, te, policy)) return false;
+            if (c == 'm' && !compile(s, se, t, te, policy)) return false;
+            _code[at].arg1 = uint32_t(_code.size());
+            _code.push_back({op::end});
+            return true;
+        }
+        case 't': {
+            char *s_end, *t_end;
+            const unsigned long sn = strtoul(s + 1, &s_end, 10), tn = strtoul(t + 1, &t_end, 10);
+            if (sn != tn) return false;
+            s = s_end, t = t_end;
+            for (unsigned long u = 0; u < sn; u++)
+                if (!compile(s, se, t, te, policy)) return false;
+            return true;
+        }
+        default:
+            return false; //different x, a, etc. go the generic way
+        }
+    if (*t == 'x' && *s != 'x' && *s != 'X' && *s != 'e' && *s != 'a' && (policy & allow_converting_expected)) {
+        _code.push_back({op::add_x});
+        return compile(s, se, ++t, te, policy);
+    }
+    if (*s == 'x' && *t != 'X' && *t != 'e' && *t != 'a' && (policy & allow_converting_expected)) {
+        _code.push_back({op::drop_x});
+        return compile(++s, se, t, te, policy);
+    }
+    //primitive conversions - mirror the deserialize_convert_from_helper() variants
+    static constexpr struct { char from, to; op code; serpolicy needs; } table[] = {
+        {'b', 'c', op::b2c, allow_converting_bool}, {'b', 'i', op::b2i, allow_converting_bool}, {'b', 'I', op::b2I, allow_converting_bool},
+        {'c', 'b', op::c2b, allow_converting_bool}, {'c', 'i', op::c2i, allow_converting_ints}, {'c', 'I', op::c2I, allow_converting_ints},
+        {'i', 'b', op::i2b, allow_converting_bool}, {'i', 'c', op::i2c, allow_converting_ints_narrowing},
+        {'i', 'I', op::i2I, allow_converting_ints}, {'i', 'd', op::i2d, allow_converting_double},
+        {'I', 'b', op::I2b, allow_converting_bool}, {'I', 'c', op::I2c, allow_converting_ints_narrowing},
+        {'I', 'i', op::I2i, allow_converting_ints_narrowing}, {'I', 'd', op::I2d, allow_converting_double},
+        {'d', 'i', op::d2i, allow_converting_double}, {'d', 'I', op::d2I, allow_converting_double},
+    };
+    for (auto &e : table)
+        if (e.from == *s && e.to == *t) {
+            if ((policy & e.needs) != e.needs) return false;
+            _code.push_back({e.code});
+            s++, t++;
+            return true;
+        }
+    return false;
+}
+
+bool conversion_program::run(std::string_view value, std::string &to) const {
+    if (!_valid) return false;
+    const char *p = value.data(), *const end = p + value.size();
+    return run(0, _code.size(), p, end, to) && p == end;
+}
+
+bool conversion_program::run(size_t from, size_t to, const char *&p, const char *end, std::string &out) const {
+    for (size_t pc = from; pc < to; pc++) {
+        const instr &i = _code[pc];
+        switch (i.code) {
+        case op::copy:
+            if (size_t(end - p) < i.arg1) return false;
+            out.append(p, i.arg1);
+            p += i.arg1;
+            break;
+        case op::str:
+        case op::fixed_list: {
+            if (end - p < 4) return false;
+            const uint64_t len = uint64_t(get32(p)) * (i.code == op::str ? 1 : i.arg1);
+            if (uint64_t(end - p - 4) < len) return false;
+            out.append(p, 4 + len);
+            p += 4 + len;
+            break;
+        }
+        case op::scan: {
+            std::string_view type(_type.data() + i.arg1, i.arg2);
+            const char *const start = p;
+            if (serialize_scan_by_type_from(type, p, end, false)) return false;
+            out.append(start, p - start);
+            break;
+        }
+        case op::list: {
+            if (end - p < 4) return false;
+            uint32_t num = get32(p);
+            out.append(p, 4);
+            p += 4;
+            while (num--)
+                if (!run(pc + 1, i.arg1, p, end, out)) return false;
+            pc = i.arg1;
+            break;
+        }
+        case op::opt:
+            if (p >= end) return false;
+            out.push_back(*p);
+            if (*p++)
+                if (!run(pc + 1, i.arg1, p, end, out)) return false;
+            pc = i.arg1;
+            break;
+        case op::end:
+            assert(0);
+            return false;
+        case op::add_x: out.push_back(1); break;
+        case op::drop_x: if (p >= end || *p == 0) return false; p++; break;
+        case op::b2c:
+        case op::c2b: if (p >= end) return false; out.push_back(char(bool(*p++))); break;
+        case op::b2i: if (p >= end) return false; put32(out, uint32_t(bool(*p++))); break;
+        case op::b2I: if (p >= end) return false; put64(out, uint64_t(bool(*p++))); break;
+        case op::c2i: if (p >= end) return false; put32(out, uint32_t((unsigned char)*p++)); break;
+        case op::c2I: if (p >= end) return false; put64(out, uint64_t(int64_t(*p++))); break;
+        case op::i2b: if (end - p < 4) return false; out.push_back(char(bool(get32(p)))); p += 4; break;
+        case op::i2c: if (end - p < 4) return false; out.push_back(char(get32(p))); p += 4; break;
+        case op::i2I: if (end - p < 4) return false; put64(out, uint64_t(int64_t(int32_t(get32(p))))); p += 4; break;
+        case op::i2d: if (end - p < 4) return false; putd(out, double(int32_t(get32(p)))); p += 4; break;
+        case op::I2b: if (end - p < 8) return false; out.push_back(char(bool(get64(p)))); p += 8; break;
+        case op::I2c: if (end - p < 8) return false; out.push_back(char(get64(p))); p += 8; break;
+        case op::I2i: if (end - p < 8) return false; put32(out, uint32_t(int32_t(int64_t(get64(p))))); p += 8; break;
+        case op::I2d: if (end - p < 8) return false; putd(out, double(int64_t(get64(p)))); p += 8; break;
+        case op::d2i: if (end - p < 8) return false; put32(out, uint32_t(int32_t(getd(p)))); p += 8; break;
+        case op::d2I: if (end - p < 8) return false; put64(out, uint64_t(int64_t(getd(p)))); p += 8; break;
+        }
+    }
+    return true;
+}
+} //ns uf::impl
+
 
 namespace uf::impl
 {
@@ -974,15 +1199,22 @@ uf::impl::serialize_scan_by_type_from(std::string_view &type, const char*&p, con
             if (p == end) goto value_mismatch;
             uint32_t tsize;
             if (deserialize_from<false>(p, end, tsize)) goto value_mismatch;
-            std::string inner_type;
-            inner_type.reserve(tsize);
-            while (tsize) {
-                if (p == end && more_val) more_val(p, end);
-                if (p == end) goto value_mismatch;
-                const uint32_t len = std::min<uint32_t>(tsize, end - p);
-                inner_type.append(p, len);
-                p += len;
-                tsize -= len;
+            std::string inner_storage; //used only if the inner type is split between chunks
+            std::string_view inner_type;
+            if (uint32_t(end - p) >= tsize) {
+                inner_type = {p, tsize};
+                p += tsize;
+            } else {
+                inner_storage.reserve(tsize);
+                while (tsize) {
+                    if (p == end && more_val) more_val(p, end);
+                    if (p == end) goto value_mismatch;
+                    const uint32_t len = std::min<uint32_t>(tsize, end - p);
+                    inner_storage.append(p, len);
+                    p += len;
+                    tsize -= len;
+                }
+                inner_type = inner_storage;
             }
             if (p == end && more_val) more_val(p, end);
             if (p == end) goto value_mismatch;
@@ -993,6 +1225,12 @@ uf::impl::serialize_scan_by_type_from(std::string_view &type, const char*&p, con
             const char *const old_p = p;
             const bool all_in_this_chunk = end-p>=vsize;
             type.remove_prefix(1);
+            //A single primitive needs no recursion, just a length check.
+            if (all_in_this_chunk && inner_type.length()==1 && vsize &&
+                fixed_type_len(inner_type.data(), inner_type.data()+1)==vsize) {
+                p += vsize;
+                break;
+            }
             if (all_in_this_chunk) {
                 const char *inner_end = p+vsize;
                 if (auto err = serialize_scan_by_type_from(inner_ty, p, inner_end, {}, {}, true)) {
@@ -1087,6 +1325,15 @@ uf::impl::serialize_scan_by_type_from(std::string_view &type, const char*&p, con
         if (problem!=ser::ok)
             return std::make_unique<typestring_error>(ser_error_str(problem), type, 0);
         const bool one_chunk = member_type.length()<=original_type.length();
+        //Fast paths for common member types, if the value has enough bytes. If not,
+        //we fall back to the element-by-element scan below to report the error.
+        if (const ptrdiff_t flen = fixed_type_len(member_type.data(), member_type.data()+member_type.length()); flen > 0) {
+            if (uint64_t(size) * uint64_t(flen) <= uint64_t(end - p)) {
+                p += size_t(size) * size_t(flen);
+                break;
+            }
+        } else if (!more_val && member_type.length()==1 && (member_type.front()=='s' || (member_type.front()=='a' && !check_recursively)))
+            size = skip_length_prefixed(p, end, size, member_type.front()=='s' ? 1 : 2);
         while (size--) {
             //Make tmp point to the same memory as 'original_type' if the latter contained the whole member type.
             std::string_view tmp(one_chunk ? original_type.substr(0, member_type.length()) : member_type);
@@ -1114,6 +1361,12 @@ uf::impl::serialize_scan_by_type_from(std::string_view &type, const char*&p, con
         const bool one_chunk = ktype.length()+mtype.length()<=original_type.length();
         if (mproblem!=ser::ok) 
             return std::make_unique<typestring_error>(ser_error_str(mproblem), type, 0);
+        if (const ptrdiff_t klen = fixed_type_len(ktype.data(), ktype.data()+ktype.length()),
+                            mlen = fixed_type_len(mtype.data(), mtype.data()+mtype.length()); klen > 0 && mlen > 0)
+            if (uint64_t(size) * uint64_t(klen + mlen) <= uint64_t(end - p)) {
+                p += size_t(size) * size_t(klen + mlen);
+                break;
+            }
         while (size--) {
             //Make tmp point to the same memory as 'original_type' if the latter contained the whole member type.
             std::string_view ktmp(one_chunk ? original_type.substr(0, ktype.length()) : ktype);
@@ -1173,6 +1426,132 @@ value_mismatch:
 
 
 
+namespace {
+/** Walks a serialized value and reverses the byte order of integers and length fields
+ * in a copy of it ('out' corresponds to 'begin').*/
+struct byte_order_converter {
+    const char *const begin, *const end;
+    char *const out;
+    const bool from_le;
+    const char *p;
+    /** Reverse 'n' bytes at 'p' in the output, return the value read from the input.*/
+    bool swap(size_t n, uint64_t *val = nullptr) noexcept {
+        if (size_t(end - p) < n) return false;
+        if (val) *val = n == 4 ? (from_le ? uf::impl::get_wire32<true>(p) : uf::impl::get_wire32<false>(p))
+                               : (from_le ? uf::impl::get_wire64<true>(p) : uf::impl::get_wire64<false>(p));
+        std::reverse(out + (p - begin), out + (p - begin) + n);
+        p += n;
+        return true;
+    }
+    bool skip(uint64_t n) noexcept {
+        if (uint64_t(end - p) < n) return false;
+        p += n;
+        return true;
+    }
+    bool skip_string() noexcept { uint64_t len; return swap(4, &len) && skip(len); }
+    /** Convert one complete type from the front of 'type' (which has been validated).*/
+    bool run(std::string_view &type) {
+        const char c = type.front();
+        type.remove_prefix(1);
+        switch (c) {
+        case 'c': case 'b': return skip(1);
+        case 'd': return skip(8);
+        case 'i': return swap(4);
+        case 'I': return swap(8);
+        case 's': return skip_string();
+        case 'a': return skip_string() && skip_string();
+        case 'e': {
+            std::string_view inner = uf::serialize_type<decltype(std::declval<uf::error_value>().tuple_for_serialization())>();
+            return run(inner);
+        }
+        case 'l':
+        case 'm': {
+            uint64_t size;
+            if (!swap(4, &size)) return false;
+            const std::string_view elem = type;
+            type.remove_prefix(uf::impl::parse_type(type.data(), type.data() + type.size(), false).first);
+            if (c == 'm')
+                type.remove_prefix(uf::impl::parse_type(type.data(), type.data() + type.size(), false).first);
+            const std::string_view one = elem.substr(0, elem.size() - type.size());
+            const ptrdiff_t flen = uf::impl::fixed_type_len(one.data(), one.data() + one.size());
+            if (flen > 0 && one.find_first_of("iI") == one.npos)
+                return skip(size * flen); //fixed size with nothing to swap
+            if (one == "i" || one == "I") { //reading in one and writing in the other byte order swaps
+                if (uint64_t(end - p) < size * flen) return false;
+                char *o = out + (p - begin);
+                if (flen == 4) for (uint64_t u = 0; u < size; u++, p += 4) uf::impl::put_wire32<false>(uf::impl::get_wire32<true>(p), o);
+                else           for (uint64_t u = 0; u < size; u++, p += 8) uf::impl::put_wire64<false>(uf::impl::get_wire64<true>(p), o);
+                return true;
+            }
+            while (size--) {
+                std::string_view t = one;
+                while (t.size()) if (!run(t)) return false;
+            }
+            return true;
+        }
+        case 't': {
+            uint32_t size = 0;
+            while (type.size() && '0' <= type.front() && type.front() <= '9') {
+                size = size * 10 + type.front() - '0';
+                type.remove_prefix(1);
+            }
+            while (size--) if (!run(type)) return false;
+            return true;
+        }
+        case 'o':
+        case 'x':
+        case 'X': {
+            if (p == end) return false;
+            const bool has_value = *p++;
+            if (has_value) return c == 'X' || run(type);
+            if (c != 'o') {
+                std::string_view e = "e";
+                if (!run(e)) return false;
+            }
+            if (c != 'X')
+                type.remove_prefix(uf::impl::parse_type(type.data(), type.data() + type.size(), false).first);
+            return true;
+        }
+        }
+        return false; //not reached, type is validated
+    }
+};
+} //ns
+
+std::string uf::convert_byte_order(std::string_view type, std::string_view value, bool from_little_endian) {
+    if (auto [len, problem] = impl::parse_type(type.data(), type.data() + type.size(), true); !!problem)
+        throw uf::typestring_error(uf::concat(impl::ser_error_str(problem), " <%1>"), type, len);
+    else if (len < type.size())
+        throw uf::typestring_error(uf::concat(impl::ser_error_str(impl::ser::tlong), " <%1>"), type, len);
+    std::string ret(value);
+    byte_order_converter c{value.data(), value.data() + value.size(), ret.data(), from_little_endian, value.data()};
+    std::string_view t = type;
+    if (t.size() && !c.run(t))
+        throw uf::value_mismatch_error(uf::concat(impl::ser_error_str(impl::ser::val), " (byte order) <%1>."), type, 0);
+    if (c.p != c.end)
+        throw uf::value_mismatch_error(uf::concat(impl::ser_error_str(impl::ser::vlong), " (byte order) <%1>."), type, type.size());
+    return ret;
+}
+
+namespace {
+/** The sink any_view::print_to_sink() streams into. Only text appended to 'to'
+ * is flushed, so nested prints into other buffers are unaffected.*/
+struct print_sink {
+    std::string *to;
+    const std::function<void(std::string_view)> *sink;
+    size_t chunk;
+};
+thread_local print_sink *current_print_sink = nullptr;
+
+/** Called at element boundaries: passes the accumulated text to the sink if large enough.*/
+inline void maybe_flush(std::string &to) {
+    if (current_print_sink && &to == current_print_sink->to && to.size() >= current_print_sink->chunk) {
+        (*current_print_sink->sink)(to);
+        to.clear();
+    }
+}
+} //ns
+
 std::optional<std::unique_ptr<uf::value_error>>
 uf::impl::serialize_print_by_type_to(std::string &to, bool json_like, unsigned max_len, std::string_view &type,
                                      const char *&p, const char *end, std::string_view chars, char escape_char,
@@ -1205,7 +1584,7 @@ uf::impl::serialize_print_by_type_to(std::string &to, bool json_like, unsigned m
     {
         int32_t i;
         if (deserialize_from<false>(p, end, i)) goto value_mismatch;
-        to.append(std::to_string(i));
+        print_integer_to(to, i);
         type.remove_prefix(1);
         break;
     }
@@ -1213,7 +1592,7 @@ uf::impl::serialize_print_by_type_to(std::string &to, bool json_like, unsigned m
     {
         int64_t i;
         if (deserialize_from<false>(p, end, i)) goto value_mismatch;
-        to.append(std::to_string(i));
+        print_integer_to(to, i);
         type.remove_prefix(1);
         break;
     }
@@ -1221,7 +1600,7 @@ uf::impl::serialize_print_by_type_to(std::string &to, bool json_like, unsigned m
     {
         double d;
         if (deserialize_from<false>(p, end, d)) goto value_mismatch;
-        to.append(uf::print_floating_point(d, json_like));
+        print_floating_point_to(to, d, json_like);
         if (json_like && to.back()=='.') to.pop_back(); //Print integers as integer for JSON
         type.remove_prefix(1);
         break;
@@ -1327,6 +1706,7 @@ uf::impl::serialize_print_by_type_to(std::string &to, bool json_like, unsigned m
                     return ret;
                 }
                 to.push_back(',');
+                maybe_flush(to);
             }
             if (auto ret = serialize_print_by_type_to(to, json_like, max_len, type, p, end, chars, escape_char, expected_handler))
                 return ret;
@@ -1366,6 +1746,7 @@ uf::impl::serialize_print_by_type_to(std::string &to, bool json_like, unsigned m
             }
             if (size)
                 to.push_back(',');
+            maybe_flush(to);
         }
         to.push_back('}');
         break;
@@ -1388,6 +1769,7 @@ uf::impl::serialize_print_by_type_to(std::string &to, bool json_like, unsigned m
                 return ret;
             if (size)
                 to.push_back(',');
+            maybe_flush(to);
         }
         to.push_back(json_like ? ']' : ')');
         break;
@@ -1719,6 +2101,238 @@ std::pair<std::string, bool> uf::impl::parse_value(std::string &to, std::string_
 }
 
 
+namespace {
+/** Parses a value of any type with parse_value() and converts it to the first type in 'type'.*/
+std::optional<std::string> parse_value_converted(std::string &to, std::string_view &value, std::string_view &type, uf::impl::ParseMode mode)
+{
+    const size_t tlen = uf::impl::parse_type(type, true).first; //type is already validated
+    const std::string_view target = type.substr(0, tlen);
+    type.remove_prefix(tlen);
+    const size_t orig_len = to.size();
+    auto [t, invalid] = uf::impl::parse_value(to, value, mode == uf::impl::ParseMode::Normal ? uf::impl::ParseMode::Liberal : mode);
+    if (invalid) return std::move(t);
+    if (t == target) return {};
+    try {
+        const std::string_view raw = std::string_view(to).substr(orig_len);
+        if (auto converted = uf::convert(t, target, uf::allow_converting_all, raw)) {
+            to.resize(orig_len);
+            to.append(*converted);
+        }
+    } catch (const uf::value_error &e) {
+        return e.what();
+    }
+    return {};
+}
+
+template <typename T>
+void append_serialized(std::string &to, T v)
+{
+    to.append(sizeof(T), char(0));
+    char *p = to.data() + to.size() - sizeof(T);
+    uf::impl::serialize_to(v, p);
+}
+} //ns
+
+std::optional<std::string> uf::impl::parse_value_as(std::string &to, std::string_view &value, std::string_view &type, ParseMode mode)
+{
+    skip_whitespace(value);
+    if (type.empty() || value.empty())
+        return parse_value_converted(to, value, type, mode);
+    switch (type.front()) {
+    case 'i':
+    case 'I':
+    {
+        //Plain decimal integers. Anything else (hex, floats, out of range, non-numbers) goes the generic way.
+        int64_t i;
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), i);
+        if (ec != std::errc() || (ptr < value.data() + value.size() && (*ptr=='.' || *ptr=='e' || *ptr=='E' || *ptr=='x' || *ptr=='X')))
+            break;
+        if (type.front() == 'i') {
+            if (i < std::numeric_limits<int32_t>::min() || i > std::numeric_limits<int32_t>::max())
+                break;
+            append_serialized(to, int32_t(i));
+        } else
+            append_serialized(to, i);
+        value.remove_prefix(ptr - value.data());
+        type.remove_prefix(1);
+        return {};
+    }
+    case 'd':
+    {
+        if (value.front() == '+') break; //from_chars does not accept it
+        double d;
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), d);
+        if (ec != std::errc() || (ptr < value.data() + value.size() && (*ptr=='x' || *ptr=='X')))
+            break;
+        append_serialized(to, d);
+        value.remove_prefix(ptr - value.data());
+        type.remove_prefix(1);
+        return {};
+    }
+    case 's':
+    {
+        if (value.front() != '\"') break;
+        const size_t pos = value.find('\"', 1);
+        if (pos == std::string_view::npos) return "Missing terminating quotation mark.";
+        const size_t orig_len = to.size();
+        to.append(4, char(0));
+        parse_escaped_string_to(to, value.substr(1, pos-1));
+        char *p = to.data() + orig_len;
+        serialize_to(uint32_t(to.size() - orig_len - 4), p);
+        value.remove_prefix(pos+1);
+        type.remove_prefix(1);
+        return {};
+    }
+    case 'l':
+    {
+        if (value.front() != '[') break;
+        const auto [elen, problem] = parse_type(type.substr(1), false);
+        if (!!problem) return uf::concat(ser_error_str(problem), '.');
+        const std::string_view etype = type.substr(1, elen);
+        value.remove_prefix(1);
+        skip_whitespace(value);
+        const size_t orig_len = to.size();
+        uint32_t size = 0;
+        to.append(4, char(0));
+        while (value.length() && value.front()!=']') {
+            std::string_view t = etype;
+            if (auto err = parse_value_as(to, value, t, mode)) return err;
+            size++;
+            skip_whitespace(value);
+            if (value.length()==0) return "Missing closing ']'.";
+            if (value.front()==']') break;
+            if (value.front()!=';' && value.front()!=',') return "List items must be separated by ';' or ','.";
+            value.remove_prefix(1);
+            skip_whitespace(value);
+        }
+        if (value.length()==0) return "Missing closing ']'.";
+        value.remove_prefix(1); //the ]
+        char *p = to.data() + orig_len;
+        serialize_to(size, p);
+        type.remove_prefix(1 + elen);
+        return {};
+    }
+    case 'm':
+    {
+        if (value.front() != '{') break;
+        const auto [klen, problem] = parse_type(type.substr(1), false);
+        if (!!problem) return uf::concat(ser_error_str(problem), '.');
+        const auto [mlen, problem2] = parse_type(type.substr(1 + klen), false);
+        if (!!problem2) return uf::concat(ser_error_str(problem2), '.');
+        const std::string_view ktype = type.substr(1, klen), mtype = type.substr(1 + klen, mlen);
+        value.remove_prefix(1);
+        skip_whitespace(value);
+        const size_t orig_len = to.size();
+        uint32_t size = 0;
+        to.append(4, char(0));
+        while (value.length() && value.front()!='}') {
+            std::string_view t = ktype;
+            if (auto err = parse_value_as(to, value, t, mode)) return err;
+            skip_whitespace(value);
+            if (value.length() == 0) return "Missing mapped value and closing '}'.";
+            if (value.front() != ':') {
+                if (IsJSON(mode)) return "Keys and values must be separated by ':'.";
+                if (value.front() != '=') return "Keys and values must be separated by ':' or '='.";
+            }
+            value.remove_prefix(1);
+            t = mtype;
+            if (auto err = parse_value_as(to, value, t, mode)) return err;
+            size++;
+            skip_whitespace(value);
+            if (value.length()==0) return "Missing closing '}'.";
+            if (value.front()=='}') break;
+            if (value.front()!=';' && value.front()!=',') return "Map items must be separated by ';' or ','.";
+            value.remove_prefix(1);
+            skip_whitespace(value);
+        }
+        if (value.length()==0) return "Missing closing '}'.";
+        value.remove_prefix(1); //the }
+        char *p = to.data() + orig_len;
+        serialize_to(size, p);
+        type.remove_prefix(1 + klen + mlen);
+        return {};
+    }
+    case 't':
+    {
+        const char close = value.front() == '[' ? ']' : value.front() == '(' && !IsJSON(mode) ? ')' : 0;
+        if (!close) break;
+        std::string_view t = type.substr(1);
+        uint32_t num = 0;
+        while (t.length() && '0'<=t.front() && t.front()<='9') {
+            num = num*10 + t.front() - '0';
+            t.remove_prefix(1);
+        }
+        const size_t orig_len = to.size();
+        const std::string_view orig_value = value;
+        value.remove_prefix(1);
+        for (uint32_t u = 0; u < num; u++) {
+            skip_whitespace(value);
+            if (value.length()==0 || (value.front()==close && t.front()!='o')) {
+                //Fewer elements than needed, let the conversion report it.
+                value = orig_value;
+                to.resize(orig_len);
+                return parse_value_converted(to, value, type, mode);
+            }
+            if (auto err = parse_value_as(to, value, t, mode)) return err;
+            skip_whitespace(value);
+            if (value.length()==0) return uf::concat("Missing closing '", close, "'.");
+            if (u+1 < num) {
+                if (value.front()!=';' && value.front()!=',') {
+                    value = orig_value;
+                    to.resize(orig_len);
+                    return parse_value_converted(to, value, type, mode);
+                }
+                value.remove_prefix(1);
+            }
+        }
+        if (value.front()!=close) {
+            value = orig_value;
+            to.resize(orig_len);
+            return parse_value_converted(to, value, type, mode);
+        }
+        value.remove_prefix(1);
+        type = t;
+        return {};
+    }
+    case 'o':
+    {
+        //An empty optional is 'null' or nothing, the latter outside JSON only
+        const bool none = value.starts_with("null") ||
+            (!IsJSON(mode) && (value.front()==',' || value.front()==';' || value.front()==']' || value.front()=='}' || value.front()==')'));
+        std::string_view t = type.substr(1);
+        if (none) {
+            if (value.starts_with("null")) value.remove_prefix(4);
+            to.push_back(0);
+            t.remove_prefix(parse_type(t, false).first);
+        } else {
+            to.push_back(1);
+            if (auto err = parse_value_as(to, value, t, mode)) return err;
+        }
+        type = t;
+        return {};
+    }
+    case 'a':
+    {
+        //Parse as text and wrap into an any (unless it already is one, e.g., '<i>5').
+        const size_t orig_len = to.size();
+        auto [t, invalid] = parse_value(to, value, mode);
+        if (invalid) return std::move(t);
+        if (t != "a") {
+            const uint32_t vlen = to.size() - orig_len;
+            to.insert(orig_len, 4+4+t.length(), char(0));
+            char *p = to.data() + orig_len;
+            serialize_to(t, p);
+            serialize_to(vlen, p);
+        }
+        type.remove_prefix(1);
+        return {};
+    }
+    default:
+        break;
+    }
+    return parse_value_converted(to, value, type, mode);
+}
+
 std::variant<uf::impl::parse_any_content_result, std::unique_ptr<uf::value_error>>
 uf::impl::parse_any_content(std::string_view _type, std::string_view _value,
                             uint32_t max_no) {
@@ -1934,6 +2548,14 @@ std::vector<std::pair<uf::any_view, uf::any_view>> uf::any_view::get_map_content
     return comprehend(p, [](auto &pair) {return std::pair{any_view{ pair.type, pair.value }, any_view{}}; });
 }
 
+uf::any_view uf::any_view::copy_to(std::pmr::memory_resource *mr) const {
+    if (is_void()) return {};
+    char *p = static_cast<char *>(mr->allocate(_type.size() + _value.size(), 1));
+    memcpy(p, _type.data(), _type.size());
+    if (_value.size()) memcpy(p + _type.size(), _value.data(), _value.size());
+    return any_view(from_type_value_unchecked, std::string_view(p, _type.size()), std::string_view(p + _type.size(), _value.size()));
+}
+
 uint32_t uf::any_view::get_content_size() const noexcept {
     if (_type.empty()) return 0;
     switch (_type.front()) {
@@ -1963,6 +2585,1143 @@ uint32_t uf::any_view::get_content_size() const noexcept {
     }
 }
 
+void uf::any_index::build() {
+    auto v = impl::parse_any_content(_view.type(), _view.value());
+    if (std::holds_alternative<std::unique_ptr<value_error>>(v)) {
+        if (auto &err = std::get<std::unique_ptr<value_error>>(v))
+            err->throw_me();
+        return;
+    }
+    auto &p = std::get<uf::impl::parse_any_content_result>(v).elements;
+    _elements = comprehend(p, [](auto &e) {return any_view(from_type_value_unchecked, e.type, e.value); });
+    _children.resize(size());
+    if (!is_map()) return;
+    //Keys of a map all have the same type, so comparing their bytes is a total order.
+    //If they are serialized in that order (e.g., a std::map with unsigned keys) we search
+    //them in place, else we sort a permutation.
+    auto key_less = [this](uint32_t a, uint32_t b) { return _elements[2*a].value() < _elements[2*b].value(); };
+    bool sorted = true;
+    for (uint32_t i = 1; i < size() && sorted; i++)
+        sorted = !key_less(i, i-1);
+    if (sorted) return;
+    _sorted.resize(size());
+    for (uint32_t i = 0; i < size(); i++)
+        _sorted[i] = i;
+    std::stable_sort(_sorted.begin(), _sorted.end(), key_less);
+}
+
+uf::any_index &uf::any_index::child(size_t k) {
+    if (k >= size()) throw std::out_of_range("uf::any_index::child");
+    if (!_children[k])
+        _children[k] = std::make_unique<any_index>(mapped(k));
+    return *_children[k];
+}
+
+std::optional<uf::any_view> uf::any_index::find(any_view key) const noexcept {
+    if (!is_map() || _elements.empty() || key.type() != _elements.front().type()) return {};
+    auto key_of = [this](uint32_t i) { return _elements[2*(_sorted.empty() ? i : _sorted[i])].value(); };
+    uint32_t lo = 0, hi = uint32_t(size());
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (key_of(mid) < key.value()) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == size() || key_of(lo) != key.value()) return {};
+    return _elements[2*(_sorted.empty() ? lo : _sorted[lo])+1];
+}
+
+uf::stream_decoder::stream_decoder(std::string_view type, callback on_element, bool check_recursively, size_t max_element_size) :
+    _type(type), _on_element(std::move(on_element)), _check(check_recursively), _max_element(max_element_size),
+    _split(type.size() && (type.front() == 'l' || type.front() == 'm')) {
+    if (auto [len, problem] = impl::parse_type(type.data(), type.data() + type.size(), true); !!problem)
+        throw uf::typestring_error(uf::concat(impl::ser_error_str(problem), " <%1>"), type, len);
+    else if (len < type.size())
+        throw uf::typestring_error(uf::concat(impl::ser_error_str(impl::ser::tlong), " <%1>"), type, len);
+    if (!_split)
+        _scan_type = _elem_type = _type;
+    else if (_type.front() == 'l')
+        _scan_type = _elem_type = _type.substr(1);
+    else {
+        _scan_type = _type.substr(1);
+        _elem_type = uf::concat("t2", _scan_type);
+    }
+}
+
+namespace {
+/** Returns a lower bound of the length of a partially received value of 'type', as declared by
+ * the length prefix at its start for strings, anys and lists of fixed-size elements.
+ * Zero if the type has no such prefix or it has not arrived yet.*/
+size_t declared_len(std::string_view type, const char *p, const char *end) noexcept {
+    if (type.empty() || end - p < 4) return 0;
+    const size_t len = uf::impl::get_wire32<false>(p);
+    switch (type.front()) {
+    case 's': return 4 + len;
+    case 'a': return size_t(end - p) < 8 + len ? 8 + len : 8 + len + uf::impl::get_wire32<false>(p + 4 + len);
+    case 'l': {
+        const auto [tlen, problem] = uf::impl::parse_type(type.data() + 1, type.data() + type.size(), false);
+        if (!!problem) return 0;
+        const ptrdiff_t flen = uf::impl::fixed_type_len(type.data() + 1, type.data() + 1 + tlen);
+        return flen > 0 ? 4 + len * flen : 0;
+    }
+    default: return 0;
+    }
+}
+} //ns
+
+size_t uf::stream_decoder::process(const char *&p, const char *end, bool final) {
+    size_t n = 0;
+    while (!_done) {
+        if (_split && !_have_count) {
+            if (end - p < 4 || impl::deserialize_from<false>(p, end, _count)) break;
+            _remaining = _count;
+            _have_count = true;
+            continue;
+        }
+        if (_split && !_remaining) {
+            _done = true;
+            break;
+        }
+        if (!final && size_t(end - p) < _retry_at) break;
+        std::string_view t = _scan_type;
+        const char *q = p, *e = end;
+        std::unique_ptr<value_error> err = impl::serialize_scan_by_type_from(t, q, e, _check);
+        if (!err && _split && _type.front() == 'm')
+            err = impl::serialize_scan_by_type_from(t, q, e, _check);
+        if (err) {
+            //A typestring error cannot be cured by more bytes. Other errors may just
+            //mean that the element is incomplete - unless there will be no more bytes.
+            if (final || dynamic_cast<const typestring_error *>(err.get())) {
+                err->prepend_type0(_type, t);
+                err->throw_me();
+            }
+            const size_t have = end - p;
+            if (have > _max_element || declared_len(_scan_type, p, end) > _max_element)
+                throw uf::value_mismatch_error(uf::concat("Element longer than the limit of ", _max_element, " bytes (stream) <%1>."), _type, 0);
+            _retry_at = have < 65536 ? have + 1 : std::min(have + have / 2, _max_element + 1);
+            break;
+        }
+        const any_view v(from_type_value_unchecked, _elem_type, std::string_view(p, q - p));
+        p = q;
+        _retry_at = 0;
+        if (!_split) _done = true;
+        else --_remaining;
+        ++n;
+        _on_element(v);
+    }
+    if (_done && p != end)
+        throw uf::value_mismatch_error(uf::concat(impl::ser_error_str(impl::ser::vlong), " (stream) <%1>."), _type, _type.size());
+    return n;
+}
+
+size_t uf::stream_decoder::feed(std::string_view chunk) {
+    //If we have nothing buffered, process straight from the chunk and keep only the remainder.
+    const bool direct = _buf.empty();
+    if (!direct) _buf.append(chunk);
+    const std::string_view in = direct ? chunk : std::string_view(_buf);
+    const char *p = in.data();
+    auto keep_rest = [&] {
+        if (direct) _buf.assign(p, in.data() + in.size());
+        else _buf.erase(0, p - in.data());
+    };
+    size_t n;
+    try {
+        n = process(p, in.data() + in.size(), false);
+    } catch (...) {
+        keep_rest();
+        throw;
+    }
+    keep_rest();
+    return n;
+}
+
+size_t uf::stream_decoder::finish() {
+    const char *p = _buf.data();
+    const size_t n = process(p, p + _buf.size(), true);
+    _buf.erase(0, p - _buf.data());
+    if (!_done)
+        throw uf::value_mismatch_error(uf::concat(impl::ser_error_str(impl::ser::val), " (stream) <%1>."), _type, 0);
+    return n;
+}
+
+#ifndef _WIN32
+namespace {
+constexpr std::string_view record_log_magic = "uFrLog01";
+constexpr std::string_view record_log_footer_magic = "uFrLogFt";
+constexpr uint32_t record_log_typedef = 0xffffffff;
+constexpr size_t record_log_buffer = 1 << 20;
+
+std::string record_log_segment_name(std::string_view path, unsigned segment) {
+    char num[16];
+    snprintf(num, sizeof(num), ".%06u", segment);
+    return uf::concat(path, num);
+}
+
+/** Returns the number of the last segment of a log, or -1 if there is none.*/
+int record_log_last_segment(const std::string &path) {
+    const std::filesystem::path p(path);
+    const std::filesystem::path dir = p.has_parent_path() ? p.parent_path() : std::filesystem::path(".");
+    const std::string prefix = p.filename().string() + '.';
+    int last = -1;
+    std::error_code ec;
+    for (const auto &e : std::filesystem::directory_iterator(dir, ec)) {
+        const std::string name = e.path().filename().string();
+        if (name.size() != prefix.size() + 6 || !name.starts_with(prefix)) continue;
+        unsigned n;
+        const char *const b = name.data() + prefix.size(), *const end = name.data() + name.size();
+        if (auto [ptr, err] = std::from_chars(b, end, n); err == std::errc{} && ptr == end)
+            last = std::max(last, int(n));
+    }
+    return last;
+}
+
+[[noreturn]] void throw_errno(std::string_view what, std::string_view file) {
+    throw std::system_error(errno, std::generic_category(), uf::concat(what, ' ', file));
+}
+} //ns
+
+uf::record_log_writer::record_log_writer(std::string path, size_t segment_size) :
+    _path(std::move(path)), _segment_size(segment_size) {
+    _segment = unsigned(record_log_last_segment(_path) + 1);
+    open_segment();
+}
+
+uf::record_log_writer::~record_log_writer() {
+    try { close(); } catch (...) {}
+}
+
+void uf::record_log_writer::open_segment() {
+    const std::string file = record_log_segment_name(_path, _segment);
+    _fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (_fd < 0) throw_errno("Cannot create log segment", file);
+    _written = 0;
+    _buf.assign(record_log_magic);
+    _type_ids.clear();
+    _types.clear();
+    _offsets.clear();
+}
+
+void uf::record_log_writer::close_segment() {
+    const uint64_t footer = _written + _buf.size();
+    const auto f = std::pair<const std::vector<std::string> &, const std::vector<uint64_t> &>(_types, _offsets);
+    _buf.append(uf::serialize(f));
+    char off[8], *p = off;
+    impl::put_wire64<false>(footer, p);
+    _buf.append(off, 8).append(record_log_footer_magic);
+    flush();
+    if (::close(std::exchange(_fd, -1)))
+        throw_errno("Cannot close log segment", record_log_segment_name(_path, _segment));
+}
+
+void uf::record_log_writer::append(std::string_view type, std::string_view value) {
+    if (_fd < 0) throw api_error("Appending to a closed record log.");
+    if (value.size() > std::numeric_limits<uint32_t>::max() || type.size() > std::numeric_limits<uint32_t>::max())
+        throw api_error(uf::concat("Record too large for the record log (", value.size(), " bytes)."));
+    auto i = _type_ids.find(type);
+    const size_t len = 4 + 4 + value.size() + (i == _type_ids.end() ? 4 + 4 + type.size() : 0);
+    if (_offsets.size() && _written + _buf.size() + len > _segment_size) {
+        close_segment();
+        _segment++;
+        open_segment();
+        i = _type_ids.end();
+    }
+    char num[4], *p;
+    if (i == _type_ids.end()) {
+        i = _type_ids.emplace(type, uint32_t(_types.size())).first;
+        _types.emplace_back(type);
+        p = num; impl::put_wire32<false>(record_log_typedef, p);
+        _buf.append(num, 4);
+        p = num; impl::put_wire32<false>(uint32_t(type.size()), p);
+        _buf.append(num, 4).append(type);
+    }
+    _offsets.push_back(_written + _buf.size());
+    p = num; impl::put_wire32<false>(i->second, p);
+    _buf.append(num, 4);
+    p = num; impl::put_wire32<false>(uint32_t(value.size()), p);
+    _buf.append(num, 4).append(value);
+    if (_buf.size() >= record_log_buffer) flush();
+}
+
+void uf::record_log_writer::flush(bool sync) {
+    if (_fd < 0) return;
+    const char *p = _buf.data(), *const end = p + _buf.size();
+    while (p < end) {
+        const ssize_t n = ::write(_fd, p, end - p);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            _buf.erase(0, p - _buf.data());
+            throw_errno("Cannot write log segment", record_log_segment_name(_path, _segment));
+        }
+        p += n;
+        _written += n;
+    }
+    _buf.clear();
+    if (sync && ::fdatasync(_fd))
+        throw_errno("Cannot sync log segment", record_log_segment_name(_path, _segment));
+}
+
+void uf::record_log_writer::close() {
+    if (_fd >= 0) close_segment();
+}
+
+uf::record_log_reader::record_log_reader(std::string_view path) {
+    const int last = record_log_last_segment(std::string(path));
+    _segments.reserve(last + 1);
+    for (int n = 0; n <= last; n++) {
+        segment &s = _segments.emplace_back();
+        s.file = record_log_segment_name(path, n);
+        const int fd = ::open(s.file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == ENOENT) { _segments.pop_back(); continue; } //a gap in the numbering
+            throw_errno("Cannot open log segment", s.file);
+        }
+        struct stat st;
+        if (fstat(fd, &st)) {
+            ::close(fd);
+            throw_errno("Cannot stat log segment", s.file);
+        }
+        s.len = size_t(st.st_size);
+        if (s.len) {
+            void *m = mmap(nullptr, s.len, PROT_READ, MAP_SHARED, fd, 0);
+            if (m == MAP_FAILED) {
+                ::close(fd);
+                s.len = 0;
+                throw_errno("Cannot map log segment", s.file);
+            }
+            s.data = static_cast<const char *>(m);
+        }
+        ::close(fd);
+        index(s);
+        _first.push_back((_first.empty() ? 0 : _first.back()) + s.offsets.size());
+    }
+}
+
+uf::record_log_reader::segment::~segment() {
+    if (data) munmap(const_cast<char *>(data), len);
+}
+
+void uf::record_log_reader::index(segment &s) {
+    const auto error = [&s](std::string_view what) {
+        return value_mismatch_error(uf::concat("Malformed record log segment ", s.file, ": ", what, '.'));
+    };
+    if (s.len < record_log_magic.size()) return; //a segment just created
+    if (std::string_view(s.data, record_log_magic.size()) != record_log_magic)
+        throw error("bad magic");
+    //Try the footer first
+    constexpr size_t trailer = 8 + record_log_footer_magic.size();
+    if (s.len >= record_log_magic.size() + trailer
+            && std::string_view(s.data + s.len - record_log_footer_magic.size(), record_log_footer_magic.size()) == record_log_footer_magic) {
+        const uint64_t footer = impl::get_wire64<false>(s.data + s.len - trailer);
+        if (footer < record_log_magic.size() || footer > s.len - trailer)
+            throw error("bad footer offset");
+        deserialize_view(std::string_view(s.data + footer, s.len - trailer - footer),
+                         std::pair<std::vector<std::string_view> &, std::vector<uint64_t> &>(s.types, s.offsets));
+        for (uint64_t off : s.offsets) {
+            if (off > footer || footer - off < 8) throw error("bad record offset");
+            const uint32_t type = impl::get_wire32<false>(s.data + off);
+            if (type >= s.types.size()) throw error("bad type id");
+            if (footer - off - 8 < impl::get_wire32<false>(s.data + off + 4)) throw error("bad record length");
+        }
+        return;
+    }
+    //No footer: scan the entries. An incomplete last entry is a write in progress
+    //or a crash during one: we ignore it.
+    for (size_t off = record_log_magic.size(); s.len - off >= 8; ) {
+        const uint32_t type = impl::get_wire32<false>(s.data + off);
+        const uint32_t len = impl::get_wire32<false>(s.data + off + 4);
+        if (s.len - off - 8 < len) break;
+        if (type == record_log_typedef)
+            s.types.emplace_back(s.data + off + 8, len);
+        else if (type < s.types.size())
+            s.offsets.push_back(off);
+        else if (type == s.types.size())
+            break; //a partially written footer starts with the number of types
+        else
+            throw error("bad type id");
+        off += 8 + len;
+    }
+}
+
+uf::any_view uf::record_log_reader::record(const segment &s, uint64_t off) noexcept {
+    return any_view(from_type_value_unchecked, s.types[impl::get_wire32<false>(s.data + off)],
+                    std::string_view(s.data + off + 8, impl::get_wire32<false>(s.data + off + 4)));
+}
+
+std::pair<const uf::record_log_reader::segment *, uint64_t> uf::record_log_reader::locate(size_t i) const noexcept {
+    const size_t n = std::upper_bound(_first.begin(), _first.end(), i) - _first.begin();
+    const segment &s = _segments[n];
+    return {&s, s.offsets[i - (n ? _first[n - 1] : 0)]};
+}
+
+uf::any_view uf::record_log_reader::operator[](size_t i) const noexcept {
+    auto [s, off] = locate(i);
+    return record(*s, off);
+}
+
+uf::any_view uf::record_log_reader::at(size_t i) const {
+    if (i >= size()) throw std::out_of_range(uf::concat("Record ", i, " requested from a log of ", size(), '.'));
+    const any_view a = (*this)[i];
+    return any_view(from_type_value, a.type(), a.value());
+}
+#endif //_WIN32
+
+uf::impl::parallel_check_plan uf::impl::plan_parallel_check(std::string_view type, std::string_view value, size_t chunk) {
+    parallel_check_plan ret;
+    if (type.empty() || (type.front() != 'l' && type.front() != 'm') || value.size() < 4) return ret;
+    ret.elem_type = type.substr(1);
+    const size_t klen = uf::parse_type(ret.elem_type);
+    const size_t vlen = type.front() == 'm' && klen ? uf::parse_type(ret.elem_type.substr(klen)) : 0;
+    if (!klen || klen + vlen != ret.elem_type.size() || (type.front() == 'm' && !vlen))
+        return ret; //bad typestring
+    const char *p = value.data() + 4, *end = value.data() + value.size(); //end must not be const
+    const uint32_t n = get_wire32<false>(value.data());
+    ret.bounds.reserve(std::min(size_t(n), value.size()) / chunk + 2);
+    for (uint32_t i = 0; i < n; i++) {
+        if (i % chunk == 0) ret.bounds.push_back(p);
+        for (std::string_view t = ret.elem_type; t.size(); )
+            if (serialize_scan_by_type_from(t, p, end, false)) {
+                ret.bounds.clear();
+                return ret;
+            }
+    }
+    if (p != end) {
+        ret.bounds.clear();
+        return ret;
+    }
+    ret.bounds.push_back(end);
+    //Without anys inside the elements, the scan above was a full check.
+    ret.checked = !n || ret.elem_type.find_first_of("aexX") == std::string_view::npos;
+    return ret;
+}
+
+bool uf::impl::check_elements(std::string_view elem_type, const char *p, const char *end) noexcept {
+    try {
+        while (p < end) {
+            for (std::string_view t = elem_type; t.size(); )
+                if (serialize_scan_by_type_from(t, p, end, true)) return false;
+        }
+        return p == end;
+    } catch (...) {
+        return false;
+    }
+}
+
+std::span<char> uf::frame_reader::buffer(size_t min) {
+    if (_start) {
+        std::memmove(_buf.data(), _buf.data() + _start, _end - _start);
+        _end -= _start;
+        _start = 0;
+    }
+    size_t need = _end + min;
+    if (_end >= 4) //make room for the whole frame in progress
+        need = std::max(need, 4 + frame_length());
+    if (_buf.size() < need)
+        _buf.resize(std::max(need, _buf.size() * 2));
+    return {_buf.data() + _end, _buf.size() - _end};
+}
+
+size_t uf::frame_reader::frame_length() const {
+    const size_t len = impl::get_wire32<false>(_buf.data() + _start);
+    if (len > _max_frame)
+        throw value_mismatch_error(uf::concat("Frame of ", len, " bytes exceeds the limit of ", _max_frame, " bytes."));
+    return len;
+}
+
+std::optional<uf::any_view> uf::frame_reader::next() {
+    if (_end - _start < 4) return std::nullopt;
+    const size_t len = frame_length();
+    if (_end - _start < 4 + len) return std::nullopt;
+    const std::string_view raw(_buf.data() + _start + 4, len);
+    any_view ret(from_raw, raw, _check);
+    if (ret.type().size() + ret.value().size() + 8 != len)
+        throw value_mismatch_error(uf::concat("Frame of ", len, " bytes contains a value of ", ret.type().size() + ret.value().size() + 8, " bytes."));
+    _start += 4 + len;
+    if (_start == _end) _start = _end = 0;
+    return ret;
+}
+
+char *uf::frame_writer::allocate(size_t n) {
+    if (_b_end || _a_end + n > _buf.size()) {
+        if (_b_end + n <= _a_start) { //(continue to) fill the front
+            char *p = _buf.data() + _b_end;
+            _b_end += n;
+            return p;
+        }
+        //Linearize into a larger buffer
+        std::vector<char> buf(std::max(_buf.size() * 2, pending() + n));
+        char *p = std::copy(_buf.data() + _a_start, _buf.data() + _a_end, buf.data());
+        std::copy(_buf.data(), _buf.data() + _b_end, p);
+        _a_end = pending();
+        _a_start = _b_end = 0;
+        _buf.swap(buf);
+    }
+    char *p = _buf.data() + _a_end;
+    _a_end += n;
+    return p;
+}
+
+char *uf::frame_writer::frame(std::string_view type, size_t len) {
+    const size_t frame_len = 8 + type.size() + len;
+    if (frame_len > std::numeric_limits<uint32_t>::max())
+        throw api_error(uf::concat("Frame too large (", frame_len, " bytes)."));
+    char *p = allocate(4 + frame_len);
+    impl::put_wire32<false>(uint32_t(frame_len), p);
+    impl::serialize_to(type, p);
+    impl::put_wire32<false>(uint32_t(len), p);
+    return p;
+}
+
+void uf::frame_writer::write_any(std::string_view type, std::string_view value) {
+    char *p = frame(type, value.size());
+    std::memcpy(p, value.data(), value.size());
+}
+
+void uf::frame_writer::consume(size_t n) noexcept {
+    assert(n <= pending());
+    const size_t a = std::min(n, _a_end - _a_start);
+    _a_start += a;
+    if (_a_start == _a_end) {
+        //Region A is done, B (if any) becomes A
+        _a_start = n - a;
+        _a_end = _b_end;
+        _b_end = 0;
+    }
+}
+
+#ifdef UF_STATS
+namespace {
+/** A counter of a thread. Only its thread writes it, but others read it, hence
+ * the atomics (used with relaxed loads and stores, not read-modify-write).*/
+struct stat_node {
+    const uf::stat_key key;
+    std::atomic<uint64_t> calls{0}, bytes{0};
+    stat_node *next = nullptr;  ///<The previous node added to the thread's table
+};
+
+/** The parts of a stat_key, as a lookup key without allocation.*/
+struct stat_key_view {
+    uf::stat_event event;
+    uf::serpolicy reason;
+    std::string_view type, target;
+    bool operator==(const stat_key_view &) const = default;
+};
+struct stat_key_view_hash {
+    size_t operator()(const stat_key_view &k) const noexcept {
+        const std::hash<std::string_view> h;
+        return h(k.type) ^ (h(k.target) * 31) ^ (size_t(k.event) << 8 | size_t(k.reason)) * 0x9e3779b97f4a7c15;
+    }
+};
+
+struct stat_table;
+/** All thread tables and the sum of the counters of exited threads.*/
+struct stat_registry {
+    std::mutex lock;
+    std::vector<stat_table *> tables;
+    std::map<uf::stat_key, uf::stat_value> retired;
+};
+/** Never destroyed, as threads may exit after static destruction.*/
+stat_registry &stat_reg() { static stat_registry *r = new stat_registry; return *r; }
+
+/** The counters of a thread. The owner thread adds nodes to the front of a
+ * list and publishes them via 'head', so readers can walk it without locking.
+ * The index and the cache are used only by the owner thread. Typestrings are
+ * mostly static (of C++ types) or interned, so we first look up the node in a
+ * small cache by the address of the typestrings, then compare their content.*/
+struct stat_table {
+    std::atomic<stat_node *> head{nullptr};
+    std::unordered_map<stat_key_view, stat_node *, stat_key_view_hash> index;
+    std::array<stat_node *, 256> cache{};
+    stat_table() {
+        std::lock_guard _(stat_reg().lock);
+        stat_reg().tables.push_back(this);
+    }
+    ~stat_table() {
+        std::lock_guard _(stat_reg().lock);
+        std::erase(stat_reg().tables, this);
+        for (stat_node *n = head.load(), *next; n; n = next) {
+            next = n->next;
+            uf::stat_value &v = stat_reg().retired[n->key];
+            v.calls += n->calls.load(std::memory_order_relaxed);
+            v.bytes += n->bytes.load(std::memory_order_relaxed);
+            delete n;
+        }
+    }
+    stat_node &find(const stat_key_view &k) {
+        const size_t slot = ((uintptr_t(k.type.data()) >> 3) ^ (uintptr_t(k.target.data()) >> 5)
+                             ^ (size_t(k.event) * 37) ^ k.type.size()) % cache.size();
+        if (stat_node *n = cache[slot]; n && n->key.event == k.event && n->key.reason == k.reason
+                                        && n->key.type == k.type && n->key.target == k.target)
+            return *n;
+        stat_node *n;
+        if (auto i = index.find(k); i != index.end()) n = i->second;
+        else {
+            n = new stat_node{uf::stat_key{k.event, k.reason, std::string(k.type), std::string(k.target)}};
+            n->next = head.load(std::memory_order_relaxed);
+            index.emplace(stat_key_view{k.event, k.reason, n->key.type, n->key.target}, n);
+            head.store(n, std::memory_order_release);
+        }
+        return *(cache[slot] = n);
+    }
+};
+thread_local stat_table stat_table_of_thread;
+} //ns
+
+void uf::impl::stat_add(stat_event e, std::string_view type, std::string_view target, uint64_t bytes, serpolicy reason) noexcept {
+    try {
+        stat_node &n = stat_table_of_thread.find({e, reason, type, target});
+        n.calls.store(n.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (bytes) n.bytes.store(n.bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    } catch (...) {} //Out of memory: do not count
+}
+
+std::map<uf::stat_key, uf::stat_value> uf::stats_snapshot() {
+    std::lock_guard _(stat_reg().lock);
+    std::map<stat_key, stat_value> ret = stat_reg().retired;
+    for (const stat_table *t : stat_reg().tables)
+        for (const stat_node *n = t->head.load(std::memory_order_acquire); n; n = n->next) {
+            stat_value &v = ret[n->key];
+            v.calls += n->calls.load(std::memory_order_relaxed);
+            v.bytes += n->bytes.load(std::memory_order_relaxed);
+        }
+    std::erase_if(ret, [](const auto &kv) { return kv.second.calls == 0; });
+    return ret;
+}
+
+void uf::stats_reset() {
+    std::lock_guard _(stat_reg().lock);
+    stat_reg().retired.clear();
+    for (const stat_table *t : stat_reg().tables)
+        for (stat_node *n = t->head.load(std::memory_order_acquire); n; n = n->next) {
+            n->calls.store(0, std::memory_order_relaxed);
+            n->bytes.store(0, std::memory_order_relaxed);
+        }
+}
+#else
+std::map<uf::stat_key, uf::stat_value> uf::stats_snapshot() { return {}; }
+void uf::stats_reset() {}
+#endif //UF_STATS
+
+namespace {
+struct typestring_hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>()(s); }
+};
+} //ns
+
+std::string_view uf::intern_typestring(std::string_view type) {
+    //Elements of an unordered_set are never moved, so we can hand out views to them.
+    static std::shared_mutex lock;
+    static std::unordered_set<std::string, typestring_hash, std::equal_to<>> table;
+    {
+        std::shared_lock _(lock);
+        if (auto i = table.find(type); i != table.end()) return *i;
+    }
+    std::unique_lock _(lock);
+    return *table.emplace(type).first;
+}
+
+void uf::type_dict_encoder::encode(std::string &to, const any_view &a) {
+    if (a.value().size() > std::numeric_limits<uint32_t>::max() || a.type().size() > std::numeric_limits<uint32_t>::max())
+        throw api_error(uf::concat("Value too large for type_dict_encoder (", a.value().size(), " bytes)."));
+    auto i = _ids.find(a.type());
+    const bool define = i == _ids.end();
+    const size_t old_size = to.size();
+    to.resize(old_size + (define ? 8 + a.type().size() : 0) + 8 + a.value().size());
+    char *p = to.data() + old_size;
+    if (define) {
+        if (_ids.size() >= std::numeric_limits<uint32_t>::max()) {
+            to.resize(old_size);
+            throw api_error("Too many types for type_dict_encoder.");
+        }
+        i = _ids.emplace(intern_typestring(a.type()), uint32_t(_ids.size())).first;
+        impl::put_wire32<false>(0xffffffff, p);
+        impl::serialize_to(a.type(), p);
+    }
+    impl::put_wire32<false>(i->second, p);
+    impl::serialize_to(a.value(), p);
+}
+
+std::optional<uf::any_view> uf::type_dict_decoder::decode(std::string_view &data) {
+    while (data.size() >= 8) {
+        const uint32_t id = impl::get_wire32<false>(data.data());
+        const uint32_t len = impl::get_wire32<false>(data.data() + 4);
+        if (data.size() - 8 < len) break;
+        const std::string_view body = data.substr(8, len);
+        if (id == 0xffffffff) {
+            _types.emplace_back(body);
+            data.remove_prefix(8 + len);
+            continue;
+        }
+        if (id >= _types.size())
+            throw value_mismatch_error(uf::concat("Undefined type id ", id, " in type_dict_decoder."));
+        data.remove_prefix(8 + len);
+        if (_check) return any_view(from_type_value, _types[id], body);
+        return any_view(from_type_value_unchecked, _types[id], body);
+    }
+    return std::nullopt;
+}
+
+namespace {
+/** Gives each compressed content of a compressed_any a distinct identity.*/
+std::atomic<uint64_t> compressed_any_ids{1};
+/** The decompressed value last accessed by this thread. The bytes are shared with
+ * the views handed out, we reuse them only when no view holds them any more.*/
+struct decompressed_cache {
+    uint64_t id = 0;
+    std::shared_ptr<std::string> data;
+};
+thread_local decompressed_cache decompressed;
+} //ns
+
+uf::compressed_any::compressed_any(const any_view &a, size_t threshold, int level) : _type(a.type()) {
+    const std::string_view v = a.value();
+    if (v.size() > std::numeric_limits<uint32_t>::max())
+        throw api_error(uf::concat("Value too large for compressed_any (", v.size(), " bytes)."));
+    _len = uint32_t(v.size());
+#ifdef HAVE_ZLIB
+    if (v.size() && v.size() >= threshold) {
+        uLongf clen = compressBound(uLong(v.size()));
+        _data.resize(clen);
+        if (compress2(reinterpret_cast<Bytef *>(_data.data()), &clen, reinterpret_cast<const Bytef *>(v.data()),
+                      uLong(v.size()), level < 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9)) == Z_OK
+            && clen < v.size()) {
+            _data.resize(clen);
+            _data.shrink_to_fit();
+            _codec = codec_zlib;
+            _id = compressed_any_ids.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+#else
+    (void)threshold;
+    (void)level;
+#endif
+    _data.assign(v);
+}
+
+uf::compressed_any::view_type uf::compressed_any::view() const {
+    if (_codec == codec_stored)
+        return {any_view(from_type_value_unchecked, _type, _data), nullptr};
+    if (_id && decompressed.id == _id)
+        return {any_view(from_type_value_unchecked, _type, *decompressed.data), decompressed.data};
+    if (_codec != codec_zlib)
+        throw api_error(uf::concat("Unknown compressed_any codec ", int(_codec), '.'));
+#ifdef HAVE_ZLIB
+    decompressed.id = 0;
+    if (!decompressed.data || decompressed.data.use_count() > 1)
+        decompressed.data = std::make_shared<std::string>();
+    else
+        std::atomic_thread_fence(std::memory_order_acquire); //pairs with the release of the last view elsewhere
+    std::string &buf = *decompressed.data;
+    buf.resize(_len);
+    uLongf len = _len;
+    if (uncompress(reinterpret_cast<Bytef *>(buf.data()), &len,
+                   reinterpret_cast<const Bytef *>(_data.data()), uLong(_data.size())) != Z_OK
+        || len != _len)
+        throw value_mismatch_error("Corrupt compressed_any payload.", _type);
+    const any_view ret(from_type_value, _type, buf);
+    decompressed.id = _id;
+    return {ret, decompressed.data};
+#else
+    throw api_error("compressed_any: zlib support is not built in.");
+#endif
+}
+
+void uf::compressed_any::after_deserialization_simple() {
+    if (_codec == codec_stored) {
+        if (_len != _data.size())
+            throw value_mismatch_error(uf::concat("Stored compressed_any length mismatch (", _len, " vs. ", _data.size(), ")."), _type);
+        (void)any_view(from_type_value, _type, _data); //check once, view() does not
+    } else {
+        //Reject lengths the payload cannot expand to before view() would allocate them
+        if (_codec == codec_zlib && _len > _data.size() * max_zlib_ratio)
+            throw value_mismatch_error(uf::concat("Compressed_any length ", _len, " is impossible for a payload of ",
+                                                  _data.size(), " bytes."), _type);
+        _id = compressed_any_ids.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+namespace {
+/** Walks serialized values for uf::compare() and uf::hash().*/
+namespace content {
+using uf::impl::deserialize_from;
+
+[[noreturn]] void bad_value() { throw uf::value_mismatch_error(uf::concat(uf::impl::ser_error_str(uf::impl::ser::val), '.')); }
+
+/** The kinds of values in the order they compare, 0 is void.*/
+int kind_of(std::string_view t) {
+    if (t.empty()) return 0;
+    switch (t.front()) {
+    case 'i': case 'I': case 'd': return 1;
+    case 'b': return 2;
+    case 'c': return 3;
+    case 's': return 4;
+    case 'l': return 5;
+    case 'm': return 6;
+    case 't': return 7;
+    case 'o': return 8;
+    case 'a': return 9;
+    case 'x': case 'X': return 10;
+    case 'e': return 11;
+    default: throw uf::typestring_error(uf::concat(uf::impl::ser_error_str(uf::impl::ser::chr), " <%1>."), t, 0);
+    }
+}
+
+/** Removes one type from the front of 't' and returns it.*/
+std::string_view take_type(std::string_view &t) {
+    const size_t len = uf::parse_type(t);
+    if (!len) throw uf::typestring_error(uf::concat(uf::impl::ser_error_str(uf::impl::ser::chr), " <%1>."), t, 0);
+    const std::string_view ret = t.substr(0, len);
+    t.remove_prefix(len);
+    return ret;
+}
+
+/** Removes the 't' and the element count from the front of a tuple type.*/
+uint32_t take_tuple_size(std::string_view &t) {
+    uint32_t n = 0;
+    const auto [ptr, ec] = std::from_chars(t.data() + 1, t.data() + t.size(), n);
+    if (ec != std::errc{} || n < 2) throw uf::typestring_error(uf::concat(uf::impl::ser_error_str(uf::impl::ser::num), " <%1>."), t, 0);
+    t.remove_prefix(ptr - t.data());
+    return n;
+}
+
+template <typename T>
+T read(const char *&p, const char *end) {
+    T v;
+    if (deserialize_from<true>(p, end, v)) bad_value();
+    return v;
+}
+
+struct number {
+    bool is_int;
+    int64_t i;
+    double d;
+};
+
+number read_number(char t, const char *&p, const char *end) {
+    switch (t) {
+    case 'i': return {true, read<int32_t>(p, end), 0};
+    case 'I': return {true, read<int64_t>(p, end), 0};
+    default:  return {false, 0, read<double>(p, end)};
+    }
+}
+
+/** We test the bits, as the library may be compiled with -ffast-math.*/
+bool is_nan(double d) noexcept { return (std::bit_cast<uint64_t>(d) << 1) > (uint64_t(0x7ff) << 53); }
+
+std::weak_ordering compare_int_double(int64_t i, double d) noexcept {
+    if (is_nan(d) || d >= 0x1p63) return std::weak_ordering::less;
+    if (d < -0x1p63) return std::weak_ordering::greater;
+    const double t = std::trunc(d);
+    if (const int64_t ti = int64_t(t); i != ti) return i <=> ti;
+    return t < d ? std::weak_ordering::less : t > d ? std::weak_ordering::greater : std::weak_ordering::equivalent;
+}
+
+std::weak_ordering compare_numbers(const number &a, const number &b) noexcept {
+    if (a.is_int && b.is_int) return a.i <=> b.i;
+    if (a.is_int) return compare_int_double(a.i, b.d);
+    if (b.is_int) return 0 <=> compare_int_double(b.i, a.d);
+    if (is_nan(a.d) || is_nan(b.d)) return is_nan(a.d) <=> is_nan(b.d);
+    return a.d < b.d ? std::weak_ordering::less : a.d > b.d ? std::weak_ordering::greater : std::weak_ordering::equivalent;
+}
+
+std::weak_ordering compare_bytes(std::string_view a, std::string_view b) noexcept {
+    if (const int r = std::memcmp(a.data(), b.data(), std::min(a.size(), b.size()))) return r <=> 0;
+    return a.size() <=> b.size();
+}
+
+std::weak_ordering compare(std::string_view &ta, const char *&pa, const char *ea,
+                           std::string_view &tb, const char *&pb, const char *eb);
+
+std::weak_ordering compare_any(std::string_view ta, std::string_view va, std::string_view tb, std::string_view vb) {
+    const char *pa = va.data(), *pb = vb.data();
+    return compare(ta, pa, va.data() + va.size(), tb, pb, vb.data() + vb.size());
+}
+
+std::weak_ordering compare_error(const char *&pa, const char *ea, const char *&pb, const char *eb) {
+    std::string_view ta = "ssa", tb = "ssa";
+    for (int i = 0; i < 3; i++)
+        if (auto r = compare(ta, pa, ea, tb, pb, eb); r != 0) return r;
+    return std::weak_ordering::equivalent;
+}
+
+/** The elements of a map sorted by key: pointers to the key and the value.*/
+std::vector<std::pair<const char *, const char *>> sorted_map(std::string_view kt, std::string_view vt, uint32_t n, const char *&p, const char *end) {
+    std::vector<std::pair<const char *, const char *>> ret;
+    ret.reserve(std::min(size_t(n), size_t(end - p)));
+    for (uint32_t i = 0; i < n; i++) {
+        auto &e = ret.emplace_back(p, nullptr);
+        std::string_view t = kt;
+        if (uf::impl::serialize_scan_by_type_from(t, p, end, false)) bad_value();
+        e.second = p;
+        t = vt;
+        if (uf::impl::serialize_scan_by_type_from(t, p, end, false)) bad_value();
+    }
+    const auto less = [kt, end](const std::pair<const char *, const char *> &a, const std::pair<const char *, const char *> &b) {
+        std::string_view t1 = kt, t2 = kt;
+        const char *p1 = a.first, *p2 = b.first;
+        return compare(t1, p1, end, t2, p2, end) < 0;
+    };
+    if (!std::is_sorted(ret.begin(), ret.end(), less))
+        std::stable_sort(ret.begin(), ret.end(), less);
+    return ret;
+}
+
+/** Compares one value from each side. On a difference we may return without consuming
+ * the types and values fully.*/
+std::weak_ordering compare(std::string_view &ta, const char *&pa, const char *ea,
+                           std::string_view &tb, const char *&pb, const char *eb) {
+    const int ka = kind_of(ta), kb = kind_of(tb);
+    if (ka != kb) return ka <=> kb;
+    if (!ka) return std::weak_ordering::equivalent;
+    const char ca = ta.front(), cb = tb.front();
+    switch (ka) {
+    case 1:
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        return compare_numbers(read_number(ca, pa, ea), read_number(cb, pb, eb));
+    case 2: case 3:
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        return read<uint8_t>(pa, ea) <=> read<uint8_t>(pb, eb);
+    case 4:
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        return compare_bytes(read<std::string_view>(pa, ea), read<std::string_view>(pb, eb));
+    case 5: {
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        const std::string_view eta = take_type(ta), etb = take_type(tb);
+        const uint32_t na = read<uint32_t>(pa, ea), nb = read<uint32_t>(pb, eb);
+        if (eta == "c" && etb == "c") {
+            if (size_t(ea - pa) < na || size_t(eb - pb) < nb) bad_value();
+            const std::weak_ordering r = compare_bytes({pa, na}, {pb, nb});
+            pa += na; pb += nb;
+            return r;
+        }
+        if (eta.size() == 1 && etb.size() == 1 && kind_of(eta) == 1 && kind_of(etb) == 1) {
+            for (uint32_t i = 0; i < std::min(na, nb); i++)
+                if (auto r = compare_numbers(read_number(eta[0], pa, ea), read_number(etb[0], pb, eb)); r != 0) return r;
+            return na <=> nb;
+        }
+        for (uint32_t i = 0; i < std::min(na, nb); i++) {
+            std::string_view t1 = eta, t2 = etb;
+            if (auto r = compare(t1, pa, ea, t2, pb, eb); r != 0) return r;
+        }
+        return na <=> nb;
+    }
+    case 6: {
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        const std::string_view kta = take_type(ta), vta = take_type(ta), ktb = take_type(tb), vtb = take_type(tb);
+        const uint32_t na = read<uint32_t>(pa, ea), nb = read<uint32_t>(pb, eb);
+        const auto ma = sorted_map(kta, vta, na, pa, ea), mb = sorted_map(ktb, vtb, nb, pb, eb);
+        for (uint32_t i = 0; i < std::min(na, nb); i++) {
+            std::string_view t1 = kta, t2 = ktb;
+            const char *p1 = ma[i].first, *p2 = mb[i].first;
+            if (auto r = compare(t1, p1, ea, t2, p2, eb); r != 0) return r;
+            t1 = vta, t2 = vtb;
+            p1 = ma[i].second, p2 = mb[i].second;
+            if (auto r = compare(t1, p1, ea, t2, p2, eb); r != 0) return r;
+        }
+        return na <=> nb;
+    }
+    case 7: {
+        const uint32_t na = take_tuple_size(ta), nb = take_tuple_size(tb);
+        for (uint32_t i = 0; i < std::min(na, nb); i++)
+            if (auto r = compare(ta, pa, ea, tb, pb, eb); r != 0) return r;
+        if (na != nb) return na <=> nb;
+        return std::weak_ordering::equivalent;
+    }
+    case 8: {
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        const bool ha = read<uint8_t>(pa, ea), hb = read<uint8_t>(pb, eb);
+        if (ha != hb) return ha <=> hb;
+        if (ha) return compare(ta, pa, ea, tb, pb, eb);
+        take_type(ta);
+        take_type(tb);
+        return std::weak_ordering::equivalent;
+    }
+    case 9: {
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        const auto a = read<std::pair<std::string_view, std::string_view>>(pa, ea);
+        const auto b = read<std::pair<std::string_view, std::string_view>>(pb, eb);
+        return compare_any(a.first, a.second, b.first, b.second);
+    }
+    case 10: {
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        std::string_view va = ca == 'x' ? take_type(ta) : std::string_view{};
+        std::string_view vb = cb == 'x' ? take_type(tb) : std::string_view{};
+        const bool ha = read<uint8_t>(pa, ea), hb = read<uint8_t>(pb, eb);
+        if (ha != hb) return ha <=> hb;
+        if (!ha) return compare_error(pa, ea, pb, eb);
+        return compare(va, pa, ea, vb, pb, eb);
+    }
+    default:
+        ta.remove_prefix(1); tb.remove_prefix(1);
+        return compare_error(pa, ea, pb, eb);
+    }
+}
+
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL, P2 = 0xC2B2AE3D27D4EB4FULL, P3 = 0x165667B19E3779F9ULL;
+
+uint64_t mix(uint64_t h, uint64_t v) noexcept {
+    h = (h ^ v) * P1;
+    return h ^ (h >> 29);
+}
+
+/** Hashes a sequence of 64-bit words in four independent lanes (like xxHash64),
+ * so that consecutive rounds do not depend on each other.*/
+class lane_hash {
+    uint64_t lanes[4] = {P1 + P2, P2, 0, 0 - P1};
+    uint64_t n = 0;
+    static uint64_t round(uint64_t l, uint64_t w) noexcept { return std::rotl(l + w * P2, 31) * P1; }
+public:
+    void add(uint64_t w) noexcept { uint64_t &l = lanes[n++ & 3]; l = round(l, w); }
+    void add_bytes(const char *p, size_t len) noexcept {
+        for (; len >= 32; p += 32, len -= 32) {
+            uint64_t w[4];
+            std::memcpy(w, p, 32);
+            for (int k = 0; k < 4; k++) lanes[k] = round(lanes[k], w[k]);
+        }
+        for (; len >= 8; p += 8, len -= 8) {
+            uint64_t w;
+            std::memcpy(&w, p, 8);
+            add(w);
+        }
+        if (len) {
+            uint64_t w = 0;
+            std::memcpy(&w, p, len);
+            add(w ^ (uint64_t(len) << 56));
+        }
+    }
+    uint64_t finish(uint64_t count) const noexcept {
+        uint64_t h = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+        h = mix(h, count);
+        h ^= h >> 33; h *= P2; h ^= h >> 29; h *= P3; h ^= h >> 32;
+        return h;
+    }
+};
+
+uint64_t hash_double(double d) noexcept {
+    if (is_nan(d)) return P3;
+    const uint64_t bits = std::bit_cast<uint64_t>(d);
+    return bits << 1 ? bits : 0; //-0.0 as 0.0
+}
+
+uint64_t hash_number(const number &n) noexcept { return hash_double(n.is_int ? double(n.i) : n.d); }
+
+uint64_t hash(std::string_view &t, const char *&p, const char *end);
+
+uint64_t hash_any(std::string_view t, std::string_view v) {
+    const char *p = v.data();
+    return hash(t, p, v.data() + v.size());
+}
+
+uint64_t hash_error(const char *&p, const char *end) {
+    std::string_view t = "ssa";
+    uint64_t h = 11;
+    for (int i = 0; i < 3; i++) h = mix(h, hash(t, p, end));
+    return h;
+}
+
+/** Hashes one value, consuming its type and value.*/
+uint64_t hash(std::string_view &t, const char *&p, const char *end) {
+    const int k = kind_of(t);
+    if (!k) return 0;
+    const char c = t.front();
+    switch (k) {
+    case 1: t.remove_prefix(1); return mix(1, hash_number(read_number(c, p, end)));
+    case 2: case 3: t.remove_prefix(1); return mix(k, read<uint8_t>(p, end));
+    case 4: {
+        t.remove_prefix(1);
+        const std::string_view s = read<std::string_view>(p, end);
+        lane_hash h;
+        h.add_bytes(s.data(), s.size());
+        return mix(4, h.finish(s.size()));
+    }
+    case 5: {
+        t.remove_prefix(1);
+        const std::string_view et = take_type(t);
+        const uint32_t n = read<uint32_t>(p, end);
+        if (et == "i" || et == "I" || et == "d") {
+            const size_t w = et == "i" ? 4 : 8;
+            if (size_t(end - p) / w < n) bad_value();
+            lane_hash h;
+            if (et == "i")
+                for (uint32_t i = 0; i < n; i++, p += 4) h.add(hash_double(double(int32_t(uf::impl::get_wire32<false>(p)))));
+            else if (et == "I")
+                for (uint32_t i = 0; i < n; i++, p += 8) h.add(hash_double(double(int64_t(uf::impl::get_wire64<false>(p)))));
+            else
+                for (uint32_t i = 0; i < n; i++, p += 8) h.add(hash_double(std::bit_cast<double>(uf::impl::get_wire64<true>(p))));
+            return mix(5, h.finish(n));
+        }
+        if (et == "c") {
+            if (size_t(end - p) < n) bad_value();
+            lane_hash h;
+            h.add_bytes(p, n);
+            p += n;
+            return mix(5, h.finish(n));
+        }
+        uint64_t h = 5;
+        for (uint32_t i = 0; i < n; i++) {
+            std::string_view et2 = et;
+            h = mix(h, hash(et2, p, end));
+        }
+        return mix(h, n);
+    }
+    case 6: {
+        t.remove_prefix(1);
+        const std::string_view kt = take_type(t), vt = take_type(t);
+        const uint32_t n = read<uint32_t>(p, end);
+        uint64_t sum = 0; //independent of the order of elements
+        for (uint32_t i = 0; i < n; i++) {
+            std::string_view t1 = kt, t2 = vt;
+            const uint64_t hk = hash(t1, p, end);
+            sum += mix(hk, hash(t2, p, end));
+        }
+        return mix(mix(6, sum), n);
+    }
+    case 7: {
+        const uint32_t n = take_tuple_size(t);
+        uint64_t h = 7;
+        for (uint32_t i = 0; i < n; i++) h = mix(h, hash(t, p, end));
+        return mix(h, n);
+    }
+    case 8:
+        t.remove_prefix(1);
+        if (read<uint8_t>(p, end)) return mix(8, hash(t, p, end));
+        take_type(t);
+        return 8;
+    case 9: {
+        t.remove_prefix(1);
+        const auto a = read<std::pair<std::string_view, std::string_view>>(p, end);
+        return mix(9, hash_any(a.first, a.second));
+    }
+    case 10: {
+        t.remove_prefix(1);
+        std::string_view vt = c == 'x' ? take_type(t) : std::string_view{};
+        if (!read<uint8_t>(p, end)) return mix(10, hash_error(p, end));
+        return mix(11, hash(vt, p, end));
+    }
+    default:
+        t.remove_prefix(1);
+        return hash_error(p, end);
+    }
+}
+} //ns content
+} //ns
+
+std::weak_ordering uf::compare(const any_view &a, const any_view &b) {
+    return content::compare_any(a.type(), a.value(), b.type(), b.value());
+}
+
+size_t uf::hash(const any_view &a) {
+    return size_t(content::hash_any(a.type(), a.value()));
+}
+
+size_t uf::impl::hash_noexcept(const any_view &a) noexcept {
+    try {
+        return uf::hash(a);
+    } catch (...) {
+        return std::hash<std::string_view>()(a.type()) ^ (std::hash<std::string_view>()(a.value()) << 1);
+    }
+}
+
 std::optional<std::unique_ptr<uf::value_error>> 
 uf::any_view::print_to(std::string &to, std::string_view &ty, unsigned max_len,
                        std::string_view chars, char escape_char, bool json_like) const {
@@ -1986,12 +3745,35 @@ uf::any_view::print_to(std::string &to, std::string_view &ty, unsigned max_len,
     return {};
 }
 
+void uf::any_view::print_to_sink(const std::function<void(std::string_view)> &sink, size_t chunk_size,
+                                 std::string_view chars, char escape_char, bool json_like) const {
+    std::string buf;
+    buf.reserve(std::min<size_t>(chunk_size, 1<<20) + 64);
+    print_sink me{&buf, &sink, std::max<size_t>(chunk_size, 1)};
+    struct restore {
+        print_sink *prev = current_print_sink;
+        ~restore() { current_print_sink = prev; }
+    } r;
+    current_print_sink = &me;
+    std::string_view ty;
+    if (auto err = print_to(buf, ty, 0, chars, escape_char, json_like))
+        if (*err) {
+            current_print_sink = r.prev;
+            (*err)->prepend_type0(type(), ty).throw_me();
+        }
+    current_print_sink = r.prev;
+    if (buf.size())
+        sink(buf);
+}
+
 uf::from_text_t uf::from_text;
 uf::from_raw_t uf::from_raw;
 uf::from_typestring_t uf::from_typestring;
 uf::from_type_value_t uf::from_type_value;
 uf::from_type_value_unchecked_t uf::from_type_value_unchecked;
 uf::use_tags_t uf::use_tags;
+uf::little_endian_t uf::little_endian;
+uf::reuse_capacity_t uf::reuse_capacity;
 
 void uf::expected_with_error::regenerate_what(std::string_view format) {
     value_error::regenerate_what(format);
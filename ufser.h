@@ -13,13 +13,27 @@
 #include <optional>
 #include <variant>
 #include <map>
+#include <deque>
 #include <cstring>
 #include <cassert>
 #include <string>
 #include <vector>
 #include <variant>
 #include <numeric>
+#include <algorithm>
+#include <exception>
+#include <typeinfo>
 #include <sstream>
+#include <iterator>
+#include <utility>
+#include <bit>
+#include <compare>
+#include <charconv>
+#include <memory_resource>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <coroutine>
 
 #ifdef HAVE_BOOST_PFR
 #include <boost/pfr.hpp>
@@ -37,6 +51,10 @@
 #define htobe64 htonll
 #define be32toh ntohl
 #define be64toh ntohll
+#define htole32(x) (x)
+#define htole64(x) (x)
+#define le32toh(x) (x)
+#define le64toh(x) (x)
 #undef min
 #undef max
 #endif
@@ -71,6 +89,8 @@
 * signed and unsigned are silently converted to each other. In case of conversion
 * 32-bit to 64 (and back), we assume signed.
 * All lengths and enums are serialized as 32 bit integers.
+* Integers (and lengths) are big-endian, doubles are IEEE-754 binary64 in little-endian byte order.
+* There is an opt-in little-endian wire variant for integers, see uf::little_endian_t.
 * Note that "lc" is serialized byte-wise exactly as an "s". Nevertheless, we keep
 * string a separate type, since python for example has a very different notion
 * of a list of chars than a string.
@@ -754,6 +774,11 @@
 *       The `view` variants allow `T` to be a view type and contain any_view or string_view members
 *       that dont own the data. Deserializing as a view is cheaper, as no memory needs allocation
 *       but the original data must outlive the deserialized variable.
+* - `T deserialize_as<T>(string_view s, std::pmr::memory_resource *mr, bool allow_longer=false)`
+*       The same for allocator-aware types (std::pmr containers and strings), which, with all
+*       their elements, take their memory from `mr`. uf::any members still allocate from the
+*       heap: uf::any always owns its content in a std::string. Use any_view members (with
+*       deserialize_view_as()) or any_view::copy_to(mr) to keep such values in the arena.
 * - `T deserialize_convert_as<T>(string_view s, string_view from_type,
 *                                          serpolicy policy=all, bool allow_longer=false)`
 * - `T deserialize_convert_as<T>(string_view s, string_view from_type,
@@ -845,6 +870,68 @@ auto concat(TT const&... tt) { std::ostringstream o; (o << ... << tt); return o.
 /** Base class for all ufser errors and exceptions. */
 struct error : public std::logic_error { using logic_error::logic_error; };
 
+enum serpolicy : unsigned char;
+
+/** The kinds of events counted by the statistics layer, see stats_snapshot().*/
+enum class stat_event : unsigned char
+{
+    get,                ///<any_view::get(), get_view() or try_get() with matching types. Key: type and target type; bytes: value length.
+    convert,            ///<The same with a conversion. Key: type and target type; bytes: value length.
+    converts_to,        ///<A converts_to() probe that succeeded. Key: type and target type.
+    converts_to_failed, ///<A converts_to() probe that failed. Key: type and target type.
+    policy_refused,     ///<A conversion failed on a flag missing from the serpolicy. Key: the (sub)types where it failed and the missing flag.
+    scan,               ///<A validation scan of a value (e.g., when creating an any_view). Key: type; bytes: value length.
+    error,              ///<A value_error thrown via throw_me(). Key: the types in the error.
+    any_alloc,          ///<A heap allocation by uf::any for its content. Key: type; bytes: the length stored.
+};
+
+/** The key of a statistics counter.*/
+struct stat_key
+{
+    stat_event event;
+    serpolicy reason;                   ///<The missing flag for policy_refused, else zero.
+    std::string type;                   ///<The (source) typestring
+    std::string target;                 ///<The target typestring, empty if not applicable
+    auto operator<=>(const stat_key &) const = default;
+};
+
+/** The value of a statistics counter.*/
+struct stat_value
+{
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+};
+
+/** True if the library was compiled with statistics (UF_STATS defined, see configure --enable-stats).
+ * Without it the counting hooks are empty inline functions and compile to nothing.
+ * The library and its users must be compiled with the same setting.*/
+#ifdef UF_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+/** Returns the sum of the counters of all threads (including ones already exited).
+ * Counters are kept per thread and are updated without locks or atomic read-modify-writes,
+ * this call takes a lock only to find the threads. Returns an empty map if stats_enabled is false.*/
+[[nodiscard]] std::map<stat_key, stat_value> stats_snapshot();
+/** Zeroes all counters. This is only exact if no other thread counts meanwhile.
+ * A thread increments its counters by a plain load and store (not a read-modify-write),
+ * so if it is in the middle of an increment, it overwrites the zero with the old count
+ * plus one: that counter keeps (most of) its value from before the reset. Reset when
+ * the process is quiescent or compare two snapshots instead, if you need exact numbers.*/
+void stats_reset();
+
+namespace impl {
+#ifdef UF_STATS
+void stat_add(stat_event e, std::string_view type, std::string_view target, uint64_t bytes, serpolicy reason) noexcept;
+#else
+inline void stat_add(stat_event, std::string_view, std::string_view, uint64_t, serpolicy) noexcept {}
+#endif
+inline void stat_add(stat_event e, std::string_view type, std::string_view target = {}, uint64_t bytes = 0) noexcept
+{ stat_add(e, type, target, bytes, serpolicy(0)); }
+} //ns impl
+
 /** Serialization or type mismatch exceptions.
  * It can take 2 types with positions. Descendats may use one or both,
  * - value_mismatch_error uses one or none.
@@ -973,7 +1060,7 @@ struct type_mismatch_error : public value_error {
     [[nodiscard]] type_mismatch_error(type_mismatch_error&&) noexcept = default;
     type_mismatch_error& operator=(const type_mismatch_error&) = default;
     type_mismatch_error& operator=(type_mismatch_error&&) noexcept = default;
-    [[noreturn]] void throw_me() const override { throw *this; };
+    [[noreturn]] void throw_me() const override { impl::stat_add(stat_event::error, types[0].type, types[1].type); throw *this; };
 };
 
 /** When a typestring is invalid.*/
@@ -984,7 +1071,7 @@ struct typestring_error : public value_error {
     [[nodiscard]] typestring_error(typestring_error&&) noexcept = default;
     typestring_error& operator=(const typestring_error&) = default;
     typestring_error& operator=(typestring_error&&) noexcept = default;
-    [[noreturn]] void throw_me() const override { throw *this; };
+    [[noreturn]] void throw_me() const override { impl::stat_add(stat_event::error, types[0].type, types[1].type); throw *this; };
 };
 
 /** When a value does not match its type string.
@@ -997,13 +1084,13 @@ struct value_mismatch_error : public value_error {
     [[nodiscard]] value_mismatch_error(value_mismatch_error&&) noexcept = default;
     value_mismatch_error& operator=(const value_mismatch_error&) = default;
     value_mismatch_error& operator=(value_mismatch_error&&) noexcept = default;
-    [[noreturn]] void throw_me() const override { throw *this; };
+    [[noreturn]] void throw_me() const override { impl::stat_add(stat_event::error, types[0].type, types[1].type); throw *this; };
 };
 
 /** When a varaible cannot be serialized (python or it contains invalid expected:s). */
 struct not_serializable_error : public value_error {
     [[nodiscard]] not_serializable_error(std::string_view _msg) : value_error(_msg, {}, {}) {}
-    [[noreturn]] void throw_me() const override { throw *this; };
+    [[noreturn]] void throw_me() const override { impl::stat_add(stat_event::error, types[0].type, types[1].type); throw *this; };
 };
 
 struct error_value;
@@ -1030,10 +1117,103 @@ struct api_error : public error {
     api_error& operator=(api_error&&) noexcept = default;
 };
 
+/** The outcome of a non-throwing extraction, see any_view::try_get().
+ * It holds only a code and the position of the problem in the (deepest) source
+ * and target typestrings, no message or typestrings are formatted for it.
+ * Use it when failures are expected, e.g., when probing several candidate types.*/
+struct get_status {
+    enum class code : uint8_t {
+        ok,             ///<Success.
+        type_mismatch,  ///<The types cannot be converted (with this policy).
+        value_mismatch, ///<The serialized value does not match its typestring.
+        typestring,     ///<Invalid typestring.
+        expected_error  ///<An expected holds an error, which the target type has no place for.
+    };
+    code status = code::ok;
+    uint16_t source_pos = 0;  ///<Where the problem is in the source typestring, if known.
+    uint16_t target_pos = 0;  ///<Where the problem is in the target typestring, if known.
+
+    /** True on success. */
+    explicit operator bool() const noexcept { return status == code::ok; }
+    /** A static description of the code. */
+    [[nodiscard]] std::string_view message() const noexcept {
+        switch (status) {
+        case code::ok: return "ok";
+        case code::type_mismatch: return "type mismatch";
+        case code::value_mismatch: return "value mismatch";
+        case code::typestring: return "invalid typestring";
+        case code::expected_error: return "cannot place expected error";
+        }
+        return {};
+    }
+    /** Classifies an error object. */
+    [[nodiscard]] static get_status from(const value_error &e) noexcept {
+        get_status ret{code::type_mismatch,
+                       e.types[0].pos.size() ? e.types[0].pos.front() : uint16_t(0),
+                       e.types[1].pos.size() ? e.types[1].pos.front() : uint16_t(0)};
+        if (dynamic_cast<const typestring_error *>(&e)) ret.status = code::typestring;
+        else if (dynamic_cast<const value_mismatch_error *>(&e)) ret.status = code::value_mismatch;
+        else if (dynamic_cast<const expected_with_error *>(&e)) ret.status = code::expected_error;
+        return ret;
+    }
+};
+
 /** @}  tools */
 
+/** Tag selecting the little-endian wire variant.
+ * Pass it as in uf::serialize(t, uf::use_tags, uf::little_endian) and use the same tag
+ * when deserializing. In this variant integers and length fields are stored in little-endian
+ * (i.e., native on x86-64 and aarch64) byte order, so lists of primitives are plain memcpy.
+ * Only the outer value is affected: the content of 'any' values inside it stays in the standard
+ * (big-endian) encoding, so they can be used as any. Such values are not valid in the standard
+ * encoding, use uf::convert_byte_order() to translate between the two.
+ * Doubles are always IEEE-754 binary64 in little-endian byte order, in both variants.
+ * The little-endian variant is supported by the plain (non-converting) serialize and
+ * deserialize functions only.*/
+struct little_endian_t {};
+extern little_endian_t little_endian;
+
+/** Tag selecting capacity-preserving deserialization into existing objects.
+ * Pass it as in uf::deserialize(s, v, false, uf::use_tags, uf::reuse_capacity) when
+ * deserializing the same kind of data into the same long-lived object repeatedly.
+ * Containers are then not cleared: resizable ones (vector, deque, list) are resized and
+ * the existing elements are overwritten in place, keeping the capacity of strings and
+ * vectors inside them; node based ones (map, set, unordered_map, etc.) reuse their nodes
+ * via extract(). So memory is only allocated when a message is bigger than the previous
+ * one. (Elements beyond the new size are still freed when a vector shrinks.)
+ * Strings always keep their capacity. It does not change the wire format, so it can be
+ * combined with other tags.*/
+struct reuse_capacity_t {};
+extern reuse_capacity_t reuse_capacity;
+
+/** Translate a serialized value between the standard (big-endian) and the little-endian
+ * wire variant (see uf::little_endian_t). The result has the same length as 'value'.
+ * Content of 'any' values is copied unchanged, as it is in the standard encoding in both.
+ * @param [in] type The typestring of the value.
+ * @param [in] value The serialized value.
+ * @param [in] from_little_endian If true, 'value' is in the little-endian variant and we
+ *             convert to the standard one, if false the other way around.
+ * @exception uf::typestring_error The type is invalid.
+ * @exception uf::value_mismatch_error The value does not match the type or is too long.*/
+[[nodiscard]] std::string convert_byte_order(std::string_view type, std::string_view value, bool from_little_endian);
+
 namespace impl {
 
+/** True if 'tags' select the little-endian wire variant.*/
+template <typename ...tags> constexpr bool is_little_endian_v = (std::is_same_v<tags, little_endian_t> || ...);
+/** True if 'tags' select capacity-preserving deserialization.*/
+template <typename ...tags> constexpr bool is_reuse_capacity_v = (std::is_same_v<tags, reuse_capacity_t> || ...);
+
+/** Store a 4 or 8 byte integer in wire byte order (big-endian, or little-endian when 'le') and advance 'p'.*/
+template <bool le> inline void put_wire32(uint32_t v, char *&p) noexcept { v = le ? htole32(v) : htobe32(v); memcpy(p, &v, 4); p += 4; }
+template <bool le> inline void put_wire64(uint64_t v, char *&p) noexcept { v = le ? htole64(v) : htobe64(v); memcpy(p, &v, 8); p += 8; }
+/** Load a 4 or 8 byte integer in wire byte order from 'p'. The caller must check for overrun.*/
+template <bool le> inline uint32_t get_wire32(const char *p) noexcept { uint32_t v; memcpy(&v, p, 4); return le ? le32toh(v) : be32toh(v); }
+template <bool le> inline uint64_t get_wire64(const char *p) noexcept { uint64_t v; memcpy(&v, p, 8); return le ? le64toh(v) : be64toh(v); }
+/** Store/load a double as IEEE-754 binary64 in little-endian byte order.*/
+inline void put_wire_double(double d, char *&p) noexcept { uint64_t v; memcpy(&v, &d, 8); v = htole64(v); memcpy(p, &v, 8); p += 8; }
+inline double get_wire_double(const char *p) noexcept { uint64_t v; memcpy(&v, p, 8); v = le64toh(v); double d; memcpy(&d, &v, 8); return d; }
+
 /** Helper to concatenate strings effectively.
  * Use StringViewAccumulator a; a << "x" << "y" + "z".
  * Copy and move compatible. It captures string refs fed into it as views, string&& is stored.*/
@@ -1311,20 +1491,37 @@ constexpr bool operator == (const char(&s1)[I1], static_string<I0> const &s0) no
 }
 
 
+/** Appends the decimal representation of an integer without creating a temporary string.*/
+inline void print_integer_to(std::string &to, std::integral auto i) {
+    char s[24];
+    to.append(s, std::to_chars(s, s + sizeof(s), i).ptr);
+}
+
+/** Appends the textual representation of a floating point number.
+ * The format is that of printf's %g (with 8 digits or full precision), using std::to_chars.
+ * Numbers without a dot or exponent get a trailing dot to indicate a floating point value.*/
+inline void print_floating_point_to(std::string &to, std::floating_point auto d, bool full_precision) {
+    char s[64];
+    const int precision =
+        std::is_same_v<decltype(d), float> ? (full_precision ? 9 : 8) :
+        std::is_same_v<decltype(d), long double> ? (full_precision ? 21 : 8) :
+        (full_precision ? 17 : 8);
+    const std::string_view ret(s, std::to_chars(s, s + sizeof(s), d, std::chars_format::general, precision).ptr - s);
+    to.append(ret);
+    if (ret.find('e') != std::string::npos) return; //scientific notation, we are done
+    if (ret.find('.') != std::string::npos) { //has a dot, remove trailing zeros
+        size_t len = ret.size();
+        while (len > 1 && to.back() == '0') {
+            to.pop_back();
+            len--;
+        }
+    } else if (ret.size() && '0'<=ret.back() && ret.back()<='9') //No dot, but number - append one to indicate floating point value.
+        to.push_back('.');
+}
+
 inline std::string print_floating_point(std::floating_point auto d, bool full_precision) {
-    char s[40];
-    const char* const fmt =
-        std::is_same_v<decltype(d), float> ? (full_precision ? "%.9g" : "%.8g") :
-        std::is_same_v<decltype(d), long double> ? (full_precision ? "%.21Lg" : "%.8Lg") :
-        (full_precision ? "%.17g" : "%.8g");
-    snprintf(s, sizeof(s), fmt, d);
-    std::string ret = s;
-    if (ret.find('e') != std::string::npos) return ret; //scientific notation, we are done
-    if (ret.find('.') != std::string::npos) //has a dot, remove trailing zeros
-        while (ret.size() > 1 && ret.back() == '0')
-            ret.pop_back();
-    else if (ret.size() && '0'<=ret.back() && ret.back()<='9') //No dot, but number - append one to indicate floating point value.
-        ret.push_back('.');
+    std::string ret;
+    print_floating_point_to(ret, d, full_precision);
     return ret;
 }
 
@@ -1410,6 +1607,11 @@ constexpr bool allow_auto_serialization = true;
 namespace impl
 {
 
+/** True for std::string and strings with other allocators (such as std::pmr::string), all serialized as 's'.*/
+template <typename T> struct is_basic_string : std::false_type {};
+template <typename A> struct is_basic_string<std::basic_string<char, std::char_traits<char>, A>> : std::true_type {};
+template <typename T> constexpr bool is_basic_string_v = is_basic_string<std::remove_cvref_t<T>>::value;
+
 //** Helper template to check if a type is a basic serializable type or not.*/
 template <typename T>
 struct is_serializable_primitive : std::false_type {};
@@ -1426,7 +1628,7 @@ template<> struct is_serializable_primitive<int64_t> : std::true_type {};
 template<> struct is_serializable_primitive<float> : std::true_type {};
 template<> struct is_serializable_primitive<double> : std::true_type {};
 template<> struct is_serializable_primitive<long double> : std::true_type {};
-template<> struct is_serializable_primitive<std::string> : std::true_type {};
+template<typename A> struct is_serializable_primitive<std::basic_string<char, std::char_traits<char>, A>> : std::true_type {};
 template<> struct is_serializable_primitive<any> : std::true_type {};
 
 template <typename T> struct is_string_deserializer : std::false_type {};
@@ -1573,11 +1775,115 @@ void add_element_to_container(T&container, typename deserializable_value_type<T>
     else container.insert(container.end(), std::move(element));
 }
 
+/** Create a default element to deserialize into and then add to 'container'.
+ * If the container has an allocator the element can use (e.g., std::pmr::vector<std::pmr::string>),
+ * we create the element with it, so that adding it to the container is a cheap move.*/
+template<typename T, typename = std::enable_if_t<is_deserializable_container<T>::value>>
+typename deserializable_value_type<T>::type make_container_element(const T &container)
+{
+    using E = typename deserializable_value_type<T>::type;
+    if constexpr (requires { container.get_allocator(); }) {
+        using A = decltype(container.get_allocator());
+        if constexpr (std::uses_allocator_v<E, A> || requires { typename E::first_type; typename E::second_type; }) //pairs are handled by make_obj_using_allocator
+            return std::make_obj_using_allocator<E>(container.get_allocator());
+        else
+            return E();
+    } else
+        return E();
+}
+
 static_assert(is_deserializable_container<std::map<int, int>>::value);
 static_assert(is_deserializable_container<std::vector<int>>::value);
 static_assert(std::is_same_v<deserializable_value_type<std::map<int, double>>::type, std::pair<int, double>>);
 static_assert(std::is_same_v<deserializable_value_type<std::vector<int>>::type, int>);
 
+/** True for primitives, where the in-memory size equals the serialized size
+ * (and the wire representation is either the native one or a plain byte-swap of it).
+ * Lists of such primitives in contiguous memory can be (de)serialized in bulk.
+ * We omit bool (must be normalized to 0/1), 16-bit ints and float (widened on the wire).*/
+template <typename T>
+constexpr bool is_bulk_primitive_v =
+    std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char> ||
+    std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+    std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> ||
+    std::is_same_v<T, double>;
+
+/** True for types, whose serialized length does not depend on their value and need
+ * no helper function (such as tuple_for_serialization) to serialize: primitives except
+ * strings, enums and pairs, tuples and arrays of these.*/
+template <typename T> struct is_fixed_len : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>> {};
+template <typename T> constexpr bool is_fixed_len_v = is_fixed_len<std::remove_cvref_t<T>>::value;
+template <> struct is_fixed_len<std::monostate> : std::true_type {};
+template <typename A, typename B> struct is_fixed_len<std::pair<A, B>> : std::bool_constant<is_fixed_len_v<A> && is_fixed_len_v<B>> {};
+template <typename ...TT> struct is_fixed_len<std::tuple<TT...>> : std::bool_constant<(is_fixed_len_v<TT> && ...)> {};
+template <typename T, size_t L> struct is_fixed_len<std::array<T, L>> : std::bool_constant<is_fixed_len_v<T>> {};
+template <typename T, size_t L> struct is_fixed_len<T[L]> : std::bool_constant<is_fixed_len_v<T> && !std::is_same_v<std::remove_cv_t<T>, char>> {};
+
+/** Helper template to detect containers with size() and data() and contiguous iterators, whose
+ * elements are bulk primitives (vector, span, etc.). These are serialized via a memcpy or
+ * a byte-swap loop, instead of element-by-element.*/
+template <typename T, typename = void>
+struct is_bulk_serializable_container : std::false_type {};
+template <typename T>
+struct is_bulk_serializable_container<T, std::void_t<
+    decltype(std::declval<const T &>().size()),
+    decltype(std::declval<const T &>().data()),
+    decltype(begin(std::declval<const T &>()))
+>> : std::bool_constant<std::contiguous_iterator<decltype(begin(std::declval<const T &>()))> &&
+                        std::is_pointer_v<decltype(std::declval<const T &>().data())> &&
+                        is_bulk_primitive_v<std::remove_cv_t<std::remove_pointer_t<decltype(std::declval<const T &>().data())>>>> {};
+
+/** Helper template to detect containers we can deserialize into via a resize() + bulk copy.*/
+template <typename T, typename = void>
+struct is_bulk_deserializable_container : std::false_type {};
+template <typename T>
+struct is_bulk_deserializable_container<T, std::void_t<
+    decltype(std::declval<T &>().resize(size_t(0))),
+    decltype(std::declval<T &>().data())
+>> : std::bool_constant<is_bulk_serializable_container<T>::value &&
+                        !std::is_const_v<std::remove_pointer_t<decltype(std::declval<T &>().data())>>> {};
+
+static_assert(is_bulk_serializable_container<std::vector<int64_t>>::value);
+static_assert(is_bulk_deserializable_container<std::vector<double>>::value);
+static_assert(!is_bulk_serializable_container<std::vector<bool>>::value);
+static_assert(!is_bulk_serializable_container<std::vector<float>>::value);
+
+/** True if a bulk primitive has the same byte order in memory and on the wire.*/
+template <typename T, bool le>
+constexpr bool is_bulk_memcpy_v = sizeof(T) == 1 ||
+    (std::endian::native == std::endian::little && (le || std::is_floating_point_v<T>));
+
+/** Serialize 'n' bulk primitives from 'src' to 'p' (in wire byte order, see put_wire32()).
+ * The loop is written so that the compiler can vectorize the byte-swaps.*/
+template <bool le, typename T>
+inline void serialize_bulk_to(const T *src, size_t n, char *&p) noexcept {
+    static_assert(is_bulk_primitive_v<T>);
+    if constexpr (is_bulk_memcpy_v<T, le>) {
+        memcpy(p, src, n * sizeof(T));
+        p += n * sizeof(T);
+    } else if constexpr (std::is_floating_point_v<T>)
+        for (size_t u = 0; u < n; u++) put_wire_double(src[u], p);
+    else if constexpr (sizeof(T) == 4)
+        for (size_t u = 0; u < n; u++) put_wire32<le>(uint32_t(src[u]), p);
+    else
+        for (size_t u = 0; u < n; u++) put_wire64<le>(uint64_t(src[u]), p);
+}
+
+/** Deserialize 'n' bulk primitives from 'p' to 'dst'. The caller must have checked 'p' for overrun.*/
+template <bool le, typename T>
+inline void deserialize_bulk_from(const char *&p, T *dst, size_t n) noexcept {
+    static_assert(is_bulk_primitive_v<T>);
+    if constexpr (is_bulk_memcpy_v<T, le>)
+        memcpy(dst, p, n * sizeof(T));
+    else if constexpr (std::is_floating_point_v<T>)
+        for (size_t u = 0; u < n; u++) dst[u] = get_wire_double(p + u * 8);
+    else if constexpr (sizeof(T) == 4)
+        for (size_t u = 0; u < n; u++) dst[u] = T(get_wire32<le>(p + u * 4));
+    else
+        for (size_t u = 0; u < n; u++) dst[u] = T(get_wire64<le>(p + u * 8));
+    p += n * sizeof(T);
+}
+
 template <typename T>
 constexpr bool is_really_auto_serializable_v =
       std::is_class<std::remove_cvref_t<T>>::value
@@ -2393,7 +2699,7 @@ enum class nt {
 template <typename T, typename ...tags>
 inline constexpr bool is_noexcept_for(nt n) noexcept {
     using plainT = std::remove_cvref_t<T>; //A plain non-const, non-ref, non-volatile type
-    if constexpr (std::is_same_v<std::string, T>) return n!=nt::deser; //string allocates on deser
+    if constexpr (is_basic_string_v<T>) return n!=nt::deser; //string allocates on deser
     else if constexpr (is_serializable_primitive<plainT>::value) return true;
     else if constexpr (is_serializable_view_primitive<plainT>::value) return true;
     else if constexpr (std::is_enum<plainT>::value) return true;
@@ -2475,6 +2781,90 @@ inline constexpr bool is_noexcept_for(nt n) noexcept {
     }
 }
 
+/** Returns the serialized length of types whose serialization has a layout fixed
+ * at compile time, or size_t(-1) for other types. These are primitives (except
+ * strings), enums and pairs, tuples and arrays of such types and structs whose
+ * tuple_for_serialization() (the non-const one if 'deser' is set) or, with
+ * Boost.PFR, whose members consist only of such types. For deserialization
+ * we also exclude structs with after_deserialization*() functions. For serialization
+ * (when the length is taken without calling any user function) we exclude structs
+ * with tuple_for_serialization().
+ * These can be deserialized with a single bounds check, see deserialize_fixed_from().*/
+template <bool deser, typename T, typename ...tags>
+inline constexpr size_t fixed_layout_len() noexcept {
+    using plainT = std::remove_cvref_t<T>;
+    constexpr size_t npos = size_t(-1);
+    if constexpr (is_serializable_primitive<plainT>::value && std::is_arithmetic_v<plainT>)
+        return std::is_floating_point_v<plainT> || sizeof(plainT)==8 ? 8 : sizeof(plainT)==1 ? 1 : 4;
+    else if constexpr (std::is_enum_v<plainT>) return 4;
+    else if constexpr (std::is_same_v<plainT, std::monostate>) return 0;
+    else if constexpr (is_pair<plainT>::value) {
+        constexpr size_t a = fixed_layout_len<deser, typename plainT::first_type, tags...>();
+        constexpr size_t b = fixed_layout_len<deser, typename plainT::second_type, tags...>();
+        return a==npos || b==npos ? npos : a + b;
+    } else if constexpr (is_tuple<plainT>::value) {
+        if constexpr (std::tuple_size<plainT>::value == 0) return 0;
+        else {
+            constexpr size_t a = fixed_layout_len<deser, typename tuple_split<plainT>::first, tags...>();
+            constexpr size_t b = fixed_layout_len<deser, typename tuple_split<plainT>::rest, tags...>();
+            return a==npos || b==npos ? npos : a + b;
+        }
+    } else if constexpr (is_std_array<plainT>::value || is_C_array<plainT>::value) {
+        constexpr size_t a = fixed_layout_len<deser, std::remove_cvref_t<decltype(*std::begin(std::declval<plainT &>()))>, tags...>();
+        constexpr size_t n = [] { if constexpr (is_std_array<plainT>::value) return std::tuple_size_v<plainT>; else return std::extent_v<plainT>; }();
+        return a==npos ? npos : a * n;
+    } else if constexpr (!std::is_class_v<plainT>) return npos;
+    else if constexpr (has_tuple_for_serialization<deser, plainT, tags...>::value) {
+        if constexpr (deser && (has_after_deserialization_v<plainT, tags...> || has_after_deserialization_simple_v<plainT, tags...>
+                                || has_after_deserialization_error_v<plainT, tags...>))
+            return npos;
+        else if constexpr (deser)
+            return fixed_layout_len<deser, decltype(invoke_tuple_for_serialization(decllval<plainT>(), std::declval<tags>()...)), tags...>();
+        else
+            return npos; //serialize_len() shall call tuple_for_serialization() the same way as serialize_to() does
+    }
+#ifdef HAVE_BOOST_PFR
+    else if constexpr (is_really_auto_serializable_v<plainT>)
+        return fixed_layout_len<deser, decltype(boost::pfr::structure_tie(decllval<plainT>())), tags...>();
+#endif
+    else return npos;
+}
+
+/** True if 'T' has a serialized layout fixed at compile time, see fixed_layout_len().*/
+template <bool deser, typename T, typename ...tags>
+inline constexpr bool is_fixed_layout_v = fixed_layout_len<deser, T, tags...>() != size_t(-1);
+
+/** Deserialize a value of a type with is_fixed_layout_v<true, T, tags...> without any bounds
+ * checks or branches. The caller must have checked that fixed_layout_len() bytes are available.*/
+template <typename T, typename ...tags>
+inline void deserialize_fixed_from(const char *&p, T &o, tags... tt) noexcept(is_noexcept_for<T, tags...>(nt::deser)) {
+    using plainT = std::remove_cv_t<T>;
+    constexpr bool le = is_little_endian_v<tags...>;
+    if constexpr (std::is_same_v<plainT, bool>) o = *(p++) != 0;
+    else if constexpr (std::is_floating_point_v<plainT>) { o = plainT(get_wire_double(p)); p += 8; }
+    else if constexpr (std::is_arithmetic_v<plainT> && sizeof(plainT) == 1) o = *(p++);
+    else if constexpr (std::is_arithmetic_v<plainT> && sizeof(plainT) == 8) { o = plainT(get_wire64<le>(p)); p += 8; }
+    else if constexpr (std::is_arithmetic_v<plainT> || std::is_enum_v<plainT>) { o = plainT(get_wire32<le>(p)); p += 4; }
+    else if constexpr (std::is_same_v<plainT, std::monostate>) {}
+    else if constexpr (is_pair<plainT>::value) {
+        deserialize_fixed_from(p, const_cast<std::remove_const_t<typename plainT::first_type>&>(o.first), tt...); //remove const needed for maps
+        deserialize_fixed_from(p, o.second, tt...);
+    } else if constexpr (is_tuple<plainT>::value)
+        std::apply([&](auto &&...m) { (deserialize_fixed_from(p, m, tt...), ...); }, o);
+    else if constexpr (is_std_array<plainT>::value || is_C_array<plainT>::value)
+        for (auto &e : o) deserialize_fixed_from(p, e, tt...);
+    else if constexpr (has_tuple_for_serialization<true, plainT, tags...>::value) {
+        auto &&tmp = invoke_tuple_for_serialization(o, tt...);
+        deserialize_fixed_from(p, tmp, tt...);
+    }
+#ifdef HAVE_BOOST_PFR
+    else {
+        auto &&tmp = boost::pfr::structure_tie(o);
+        deserialize_fixed_from(p, tmp, tt...);
+    }
+#endif
+}
+
 } //ns impl
 
 /** Type trait to verify that a type has a (free or member) tuple_for_serialization()
@@ -2654,7 +3044,7 @@ template <bool des, typename tag_tuple=std::tuple<>> constexpr auto serialize_ty
 template <bool des, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const float*, const tag_tuple* = nullptr) noexcept { return make_string("d"); }
 template <bool des, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const double*, const tag_tuple* = nullptr) noexcept { return make_string("d"); }
 template <bool des, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const long double*, const tag_tuple* = nullptr) noexcept { return make_string("d"); }
-template <bool des, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const std::string*, const tag_tuple* = nullptr) noexcept { return make_string("s"); }
+template <bool des, typename A, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const std::basic_string<char, std::char_traits<char>, A>*, const tag_tuple* = nullptr) noexcept { return make_string("s"); }
 template <bool des, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const std::string_view*, const tag_tuple* = nullptr) noexcept { return make_string("s"); }
 template <bool des, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const char *const *, const tag_tuple* = nullptr) noexcept { return make_string("s"); }
 template <bool des, size_t L, typename tag_tuple=std::tuple<>> constexpr auto serialize_type_static_impl(const char (*)[L], const tag_tuple* = nullptr) noexcept { return make_string("s"); }
@@ -3219,7 +3609,7 @@ template <typename ...tags> constexpr size_t serialize_len(const int64_t&, tags.
 template <typename ...tags> constexpr size_t serialize_len(const float&, tags...) noexcept { return 8; }
 template <typename ...tags> constexpr size_t serialize_len(const double&, tags...) noexcept { return 8; }
 template <typename ...tags> constexpr size_t serialize_len(const long double&, tags...) noexcept { return 8; }
-template <typename ...tags> inline size_t serialize_len(const std::string &s, tags...) noexcept { return 4+s.length(); }
+template <typename A, typename ...tags> inline size_t serialize_len(const std::basic_string<char, std::char_traits<char>, A> &s, tags...) noexcept { return 4+s.length(); }
 template <typename ...tags> inline size_t serialize_len(const std::string_view &s, tags...) noexcept { return 4+s.length(); }
 //If I enable the below overload, I get ambigous resolution for serialize_len(const char [X]).
 //As a workaround I let the serialize_len(const char *) be selected.
@@ -3255,6 +3645,9 @@ template <typename C, typename ...tags> //containers with begin() end() size() c
 constexpr typename std::enable_if<is_serializable_container<C>::value && !has_tuple_for_serialization<false, C, tags...>::value, size_t>::type
 serialize_len(const C &c, tags... tt)  noexcept(is_noexcept_for<C, tags...>(nt::len)) {
     if constexpr (is_void_like<false, C>::value) return 0;
+    else if constexpr (is_bulk_serializable_container<C>::value) return 4 + c.size() * sizeof(*c.data());
+    else if constexpr (is_fixed_layout_v<false, decltype(*std::begin(c)), tags...> && requires { c.size(); })
+        return 4 + c.size() * fixed_layout_len<false, decltype(*std::begin(c)), tags...>();
     else {size_t ret = 4; for (auto const&e : c) ret += serialize_len(e, tt...); return ret;}
 }
 template <typename ...tags> inline size_t serialize_len(const std::vector<bool>& c, tags...) noexcept { return 4 + c.size(); }
@@ -3264,7 +3657,9 @@ serialize_len(const S &s, tags... tt) noexcept(is_noexcept_for<S, tags...>(nt::l
 #ifdef HAVE_BOOST_PFR
 template <typename S, typename ...tags>
 constexpr typename std::enable_if<is_really_auto_serializable_v<S> && !has_tuple_for_serialization<false, S, tags...>::value, size_t>::type
-serialize_len(const S &s, tags... tt) noexcept(is_noexcept_for<S, tags...>(nt::len)) { return serialize_len(boost::pfr::structure_tie(s), tt...); }
+serialize_len(const S &s, tags... tt) noexcept(is_noexcept_for<S, tags...>(nt::len)) {
+    if constexpr (is_fixed_layout_v<false, S, tags...>) { (void)s; ((void)tt, ...); return fixed_layout_len<false, S, tags...>(); }
+    else return serialize_len(boost::pfr::structure_tie(s), tt...); }
 #endif
 template <typename A, typename B, typename ...tags> //pair
 constexpr size_t serialize_len(const std::pair<A, B> &p, tags... tt) noexcept(is_noexcept_for<A, tags...>(nt::len) && is_noexcept_for<B, tags...>(nt::len))
@@ -3291,20 +3686,20 @@ template <typename ...tags> inline void serialize_to(const bool &o, char *&p, ta
 template <typename ...tags> inline void serialize_to(const unsigned char &o, char *&p, tags...) noexcept { *(p++) = o; }
 template <typename ...tags> inline void serialize_to(const signed char &o, char *&p, tags...) noexcept { *(p++) = o; }
 template <typename ...tags> inline void serialize_to(const char &o, char *&p, tags...) noexcept { *(p++) = o; }
-template <typename ...tags> inline void serialize_to(const uint16_t &o, char *&p, tags...) noexcept { *reinterpret_cast<uint32_t*>(p) = htobe32(uint32_t(o)); p += 4; }
-template <typename ...tags> inline void serialize_to(const int16_t &o, char *&p, tags...) noexcept { *reinterpret_cast<int32_t*>(p) = htobe32(int32_t(o)); p += 4; }
-template <typename ...tags> inline void serialize_to(const uint32_t &o, char *&p, tags...) noexcept { *reinterpret_cast<uint32_t*>(p) = htobe32(o); p += 4; }
-template <typename ...tags> inline void serialize_to(const int32_t &o, char *&p, tags...) noexcept { *reinterpret_cast<int32_t*>(p) = htobe32(o); p += 4; }
-template <typename ...tags> inline void serialize_to(const uint64_t &o, char *&p, tags...) noexcept { *reinterpret_cast<uint64_t*>(p) = htobe64(o); p += 8; }
-template <typename ...tags> inline void serialize_to(const int64_t &o, char *&p, tags...) noexcept { *reinterpret_cast<uint64_t*>(p) = htobe64(o); p += 8; }
-template <typename ...tags> inline void serialize_to(const float &o, char *&p, tags...) noexcept { *reinterpret_cast<double*>(p) = o; p += 8; }
-template <typename ...tags> inline void serialize_to(const double &o, char *&p, tags...) noexcept { *reinterpret_cast<double*>(p) = o; p += 8; }
-template <typename ...tags> inline void serialize_to(const long double o, char *&p, tags...) noexcept { *reinterpret_cast<double*>(p) = o; p += 8; }
-template <typename ...tags> inline void serialize_to(const std::string &s, char *&p, tags...) noexcept { serialize_to(uint32_t(s.size()), p); memcpy(p, s.data(), s.size()); p += s.size(); }
-template <typename ...tags> inline void serialize_to(const std::string_view &s, char *&p, tags...) noexcept { serialize_to(uint32_t(s.size()), p); memcpy(p, s.data(), s.size()); p += s.size(); }
+template <typename ...tags> inline void serialize_to(const uint16_t &o, char *&p, tags...) noexcept { put_wire32<is_little_endian_v<tags...>>(uint32_t(o), p); }
+template <typename ...tags> inline void serialize_to(const int16_t &o, char *&p, tags...) noexcept { put_wire32<is_little_endian_v<tags...>>(uint32_t(int32_t(o)), p); }
+template <typename ...tags> inline void serialize_to(const uint32_t &o, char *&p, tags...) noexcept { put_wire32<is_little_endian_v<tags...>>(o, p); }
+template <typename ...tags> inline void serialize_to(const int32_t &o, char *&p, tags...) noexcept { put_wire32<is_little_endian_v<tags...>>(uint32_t(o), p); }
+template <typename ...tags> inline void serialize_to(const uint64_t &o, char *&p, tags...) noexcept { put_wire64<is_little_endian_v<tags...>>(o, p); }
+template <typename ...tags> inline void serialize_to(const int64_t &o, char *&p, tags...) noexcept { put_wire64<is_little_endian_v<tags...>>(uint64_t(o), p); }
+template <typename ...tags> inline void serialize_to(const float &o, char *&p, tags...) noexcept { put_wire_double(o, p); }
+template <typename ...tags> inline void serialize_to(const double &o, char *&p, tags...) noexcept { put_wire_double(o, p); }
+template <typename ...tags> inline void serialize_to(const long double o, char *&p, tags...) noexcept { put_wire_double(double(o), p); }
+template <typename A, typename ...tags> inline void serialize_to(const std::basic_string<char, std::char_traits<char>, A> &s, char *&p, tags... tt) noexcept { serialize_to(uint32_t(s.size()), p, tt...); memcpy(p, s.data(), s.size()); p += s.size(); }
+template <typename ...tags> inline void serialize_to(const std::string_view &s, char *&p, tags... tt) noexcept { serialize_to(uint32_t(s.size()), p, tt...); memcpy(p, s.data(), s.size()); p += s.size(); }
 //See serialize_len() (of same signature) above why this is disabled.
 //template <size_t LEN, typename ...tags> inline void serialize_to(char const (&s)[LEN], char *&p, tags...) noexcept { static_assert(LEN); assert(!s[LEN-1]); serialize_to(uint32_t(LEN-1), p); memcpy(p, s, LEN-1); p += LEN-1; }
-template <typename ...tags> inline void serialize_to(const char * const &s, char *&p, tags...) noexcept { const uint32_t len = strlen(s); serialize_to(len, p); memcpy(p, s, len); p += len; }
+template <typename ...tags> inline void serialize_to(const char * const &s, char *&p, tags... tt) noexcept { const uint32_t len = strlen(s); serialize_to(len, p, tt...); memcpy(p, s, len); p += len; }
 template <typename T, typename ...tags> void serialize_to(const expected<T>&, char *&p, tags...tt) noexcept(is_noexcept_for<T, tags...>(nt::ser));
 template <typename E, typename ...tags> typename std::enable_if<std::is_enum<E>::value>::type serialize_to(const E &e, char *&p, tags...) noexcept;
 template <typename C, typename ...tags> typename std::enable_if<is_serializable_container<C>::value && !is_std_array<C>::value && !has_tuple_for_serialization<false, C, tags...>::value>::type
@@ -3325,14 +3720,16 @@ template <typename T, typename ...tags> inline void serialize_to(const T* const
 template <typename T, typename ...tags> inline void serialize_to(const std::optional<T> &o, char *&p, tags...) noexcept(is_noexcept_for<T, tags...>(nt::ser));
 
 template <typename E, typename ...tags> inline typename std::enable_if<std::is_enum<E>::value>::type
-serialize_to(const E &e, char *&p, tags...) noexcept { serialize_to(uint32_t(e), p); }
+serialize_to(const E &e, char *&p, tags... tt) noexcept { serialize_to(uint32_t(e), p, tt...); }
 template <typename C, typename ...tags> inline typename std::enable_if<is_serializable_container<C>::value && !is_std_array<C>::value && !has_tuple_for_serialization<false, C, tags...>::value>::type
 serialize_to(const C &c, char *&p, tags... tt) noexcept(is_noexcept_for<C, tags...>(nt::ser)) {
     if constexpr (is_void_like<false, C>::value) return;
-    serialize_to(uint32_t(c.size()), p); for (auto const&e : c) serialize_to(e, p, tt...);
+    serialize_to(uint32_t(c.size()), p, tt...);
+    if constexpr (is_bulk_serializable_container<C>::value) serialize_bulk_to<is_little_endian_v<tags...>>(c.data(), c.size(), p);
+    else for (auto const&e : c) serialize_to(e, p, tt...);
 }
-template <typename ...tags> inline void serialize_to(const std::vector<bool> &c, char *&p, tags...) noexcept
-{ serialize_to(uint32_t(c.size()), p); for (bool e : c) serialize_to(e, p); }
+template <typename ...tags> inline void serialize_to(const std::vector<bool> &c, char *&p, tags... tt) noexcept
+{ serialize_to(uint32_t(c.size()), p, tt...); for (bool e : c) serialize_to(e, p); }
 template <typename S, typename ...tags> inline typename std::enable_if<has_tuple_for_serialization<false, S, tags...>::value && is_serializable_v<S, tags...>>::type
 serialize_to(const S &s, char *&p, tags... tt) noexcept(is_noexcept_for<S, tags...>(nt::ser)) { serialize_to(invoke_tuple_for_serialization(s, tt...), p, tt...); }
 #ifdef HAVE_BOOST_PFR
@@ -3363,27 +3760,27 @@ template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_fro
 template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, unsigned char &o, tags...) noexcept { if (p>=end) return true; o = *(p++); return false; }
 template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, signed char &o, tags...) noexcept { if (p>=end) return true; o = *(p++); return false; }
 template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, char &o, tags...) noexcept { if (p>=end) return true; o = *(p++); return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, uint16_t &o, tags...) noexcept { if (p+4>end) return true; o = (uint16_t)be32toh(*reinterpret_cast<const uint32_t*>(p)); p += 4; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, int16_t &o, tags...) noexcept { if (p+4>end) return true; o = (int16_t)be32toh(*reinterpret_cast<const int32_t*>(p)); p += 4; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, uint32_t &o, tags...) noexcept { if (p+4>end) return true; o = be32toh(*reinterpret_cast<const uint32_t*>(p)); p += 4; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, int32_t &o, tags...) noexcept { if (p+4>end) return true; o = be32toh(*reinterpret_cast<const int32_t*>(p)); p += 4; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, uint64_t &o, tags...) noexcept { if (p+8>end) return true; o = be64toh(*reinterpret_cast<const uint64_t*>(p)); p += 8; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, int64_t &o, tags...) noexcept { if (p+8>end) return true; o = be64toh(*reinterpret_cast<const uint64_t*>(p)); p += 8; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, float &o, tags...) noexcept { if (p+8>end) return true; o = (float)*reinterpret_cast<const double*>(p); p += 8; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, double &o, tags...) noexcept { if (p+8>end) return true; o = *reinterpret_cast<const double*>(p); p += 8; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, long double &o, tags...) noexcept { if (p+8>end) return true; o = *reinterpret_cast<const double*>(p); p += 8; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, std::string &s, tags...)
-{ uint32_t size; if (deserialize_from<false>(p, end, size) || p+size>end) return true; s.assign(p, size); p += size; return false; }
-template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, std::string_view &s, tags...) noexcept
-{ static_assert(view); uint32_t size; if (deserialize_from<false>(p, end, size) || p+size>end) return true; s = std::string_view(p, size); p += size; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, uint16_t &o, tags...) noexcept { if (p+4>end) return true; o = (uint16_t)get_wire32<is_little_endian_v<tags...>>(p); p += 4; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, int16_t &o, tags...) noexcept { if (p+4>end) return true; o = (int16_t)get_wire32<is_little_endian_v<tags...>>(p); p += 4; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, uint32_t &o, tags...) noexcept { if (p+4>end) return true; o = get_wire32<is_little_endian_v<tags...>>(p); p += 4; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, int32_t &o, tags...) noexcept { if (p+4>end) return true; o = int32_t(get_wire32<is_little_endian_v<tags...>>(p)); p += 4; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, uint64_t &o, tags...) noexcept { if (p+8>end) return true; o = get_wire64<is_little_endian_v<tags...>>(p); p += 8; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, int64_t &o, tags...) noexcept { if (p+8>end) return true; o = int64_t(get_wire64<is_little_endian_v<tags...>>(p)); p += 8; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, float &o, tags...) noexcept { if (p+8>end) return true; o = (float)get_wire_double(p); p += 8; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, double &o, tags...) noexcept { if (p+8>end) return true; o = get_wire_double(p); p += 8; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, long double &o, tags...) noexcept { if (p+8>end) return true; o = get_wire_double(p); p += 8; return false; }
+template <bool view, typename A, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, std::basic_string<char, std::char_traits<char>, A> &s, tags... tt)
+{ uint32_t size; if (deserialize_from<false>(p, end, size, tt...) || p+size>end) return true; s.assign(p, size); p += size; return false; }
+template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, std::string_view &s, tags... tt) noexcept
+{ static_assert(view); uint32_t size; if (deserialize_from<false>(p, end, size, tt...) || p+size>end) return true; s = std::string_view(p, size); p += size; return false; }
 template <bool view, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, any &s, tags...);
-template <bool view, typename T, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, string_deserializer_view<T> &o, tags...) noexcept(string_deserializer_view<T>::is_noexcept)
-{ static_assert(view); std::string_view s; if (deserialize_from<true>(p, end, s)) return true; o.receiver(s); return false; }
-template <bool view, typename T, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, string_deserializer<T>&o, tags...) noexcept(string_deserializer<T>::is_noexcept)
-{ std::string_view s; if (deserialize_from<true>(p, end, s)) return true; o.receiver(s); return false; }
+template <bool view, typename T, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, string_deserializer_view<T> &o, tags... tt) noexcept(string_deserializer_view<T>::is_noexcept)
+{ static_assert(view); std::string_view s; if (deserialize_from<true>(p, end, s, tt...)) return true; o.receiver(s); return false; }
+template <bool view, typename T, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, string_deserializer<T>&o, tags... tt) noexcept(string_deserializer<T>::is_noexcept)
+{ std::string_view s; if (deserialize_from<true>(p, end, s, tt...)) return true; o.receiver(s); return false; }
 template <bool view, typename T, typename ...tags> [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, expected<T> &o, tags...);
 template <bool view, typename E, typename ...tags> typename std::enable_if<std::is_enum<E>::value, bool>::type deserialize_from(const char *&p, const char *end, E &e, tags...) noexcept;
-template <bool view, typename C, typename ...tags> typename std::enable_if<is_deserializable_container<C>::value && !is_std_array<C>::value && !std::is_same_v<C, std::string> && !has_tuple_for_serialization<true, C, tags...>::value, bool>::type
+template <bool view, typename C, typename ...tags> typename std::enable_if<is_deserializable_container<C>::value && !is_std_array<C>::value && !is_basic_string_v<C> && !has_tuple_for_serialization<true, C, tags...>::value, bool>::type
 deserialize_from(const char *&p, const char *end, C &c, tags...);
 template <bool view, typename S, typename ...tags> typename std::enable_if<has_tuple_for_serialization<true, S, tags...>::value && impl::is_deserializable_f<S, view, false, tags...>(), bool>::type
 deserialize_from(const char *&p, const char *end, S &s, tags...) noexcept(is_noexcept_for<S, tags...>(nt::deser));
@@ -3404,14 +3801,64 @@ template <bool view, typename T, typename ...tags> bool deserialize_from(const c
 template <bool view, typename T, typename ...tags> bool deserialize_from(const char *&p, const char *end, std::optional<T> &o, tags...) noexcept(is_noexcept_for<T, tags...>(nt::deser));
 
 template <bool view, typename E, typename ...tags> inline typename std::enable_if<std::is_enum<E>::value, bool>::type
-deserialize_from(const char *&p, const char *end, E &e, tags...) noexcept { uint32_t val; if (deserialize_from<view>(p, end, val)) return true; e = E(val); return false; }
-template <bool view, typename C, typename ...tags> inline typename std::enable_if<is_deserializable_container<C>::value && !is_std_array<C>::value && !std::is_same_v<C, std::string> && !has_tuple_for_serialization<true, C, tags...>::value, bool>::type
+deserialize_from(const char *&p, const char *end, E &e, tags... tt) noexcept { uint32_t val; if (deserialize_from<view>(p, end, val, tt...)) return true; e = E(val); return false; }
+template <bool view, typename C, typename ...tags> inline typename std::enable_if<is_deserializable_container<C>::value && !is_std_array<C>::value && !is_basic_string_v<C> && !has_tuple_for_serialization<true, C, tags...>::value, bool>::type
 deserialize_from(const char *&p, const char *end, C &c, tags... tt) {
-    c.clear(); ignore_pack(tt...);
+    ignore_pack(tt...);
+    if constexpr (is_reuse_capacity_v<tags...> && !is_void_like<true, C, tags...>::value
+                  && !is_bulk_deserializable_container<C>::value) {
+        using E = typename deserializable_value_type<C>::type;
+        //Each element takes at least a byte (or its fixed length): reject counts the data
+        //cannot hold before creating elements for them.
+        constexpr size_t min_elem_len = is_fixed_layout_v<true, E, tags...> ? std::max<size_t>(1, fixed_layout_len<true, E, tags...>()) : 1;
+        if constexpr (requires { c.resize(size_t(0)); } && !std::is_same_v<C, std::vector<bool>>) {
+            //Overwrite the existing elements in place
+            uint32_t size;  if(deserialize_from<view>(p, end, size, tt...)) return true;
+            if (size_t(end - p) / min_elem_len < size) return true;
+            c.resize(size);
+            for (auto &e : c)
+                if (deserialize_from<view>(p, end, e, tt...)) return true;
+            return false;
+        } else if constexpr (requires { typename C::node_type; c.extract(c.begin()); }) {
+            //Move the nodes aside and take them one by one for the incoming elements
+            uint32_t size;  if(deserialize_from<view>(p, end, size, tt...)) return true;
+            if (size_t(end - p) / min_elem_len < size) return true;
+            C old(std::move(c)); //keeps the allocator, so nodes can move back
+            c.clear();
+            while (size--) {
+                if (old.empty()) {
+                    auto e = make_container_element(c);
+                    if (deserialize_from<view>(p, end, e, tt...)) return true;
+                    add_element_to_container(c, std::move(e));
+                    continue;
+                }
+                auto node = old.extract(old.begin());
+                if constexpr (is_map_container<C>::value) {
+                    if (deserialize_from<view>(p, end, node.key(), tt...)
+                        || deserialize_from<view>(p, end, node.mapped(), tt...)) return true;
+                } else if (deserialize_from<view>(p, end, node.value(), tt...)) return true;
+                c.insert(std::move(node));
+            }
+            return false;
+        }
+    }
+    c.clear();
     if constexpr (!is_void_like<true, C, tags...>::value) {
-        uint32_t size;  if(deserialize_from<view>(p, end, size)) return true;
+        uint32_t size;  if(deserialize_from<view>(p, end, size, tt...)) return true;
+        if constexpr (is_bulk_deserializable_container<C>::value) {
+            if (size_t(end - p) < size_t(size) * sizeof(*c.data())) return true;
+            c.resize(size);
+            deserialize_bulk_from<is_little_endian_v<tags...>>(p, c.data(), size);
+            return false;
+        }
         if constexpr (has_reserve_member<C>::value) c.reserve(size);
-        typename deserializable_value_type<C>::type e;
+        typename deserializable_value_type<C>::type e = make_container_element(c);
+        using E = typename deserializable_value_type<C>::type;
+        if constexpr (is_fixed_layout_v<true, E, tags...>) {
+            if (size_t(end - p) / std::max<size_t>(1, fixed_layout_len<true, E, tags...>()) < size) return true;
+            while (size--) { deserialize_fixed_from(p, e, tt...); add_element_to_container(c, std::move(e)); }
+            return false;
+        }
         while (size--) if(deserialize_from<view>(p, end, e, tt...)) return true; else add_element_to_container(c, std::move(e));
     }
     return false;
@@ -3420,6 +3867,11 @@ template <bool view, typename S, typename ...tags> typename std::enable_if_t<has
 deserialize_from(const char *&p, const char *end, S &s, tags... tt) noexcept(is_noexcept_for<S, tags...>(nt::deser)) {
     static_assert(!has_after_deserialization_v<S, tags...> || !has_after_deserialization_simple_v<S, tags...>,
                   "Only one of after_deserialization_simple(tags...) or after_deserialization(U&&, tags...) should be defined.");
+    if constexpr (is_fixed_layout_v<true, S, tags...>) {
+        if (size_t(end - p) < fixed_layout_len<true, S, tags...>()) return true;
+        deserialize_fixed_from(p, s, tt...);
+        return false;
+    }
     bool need_to_call_after = true;
     try {
         auto &&tmp = invoke_tuple_for_serialization(s, tt...);
@@ -3438,6 +3890,11 @@ deserialize_from(const char *&p, const char *end, S &s, tags... tt) noexcept(is_
 #ifdef HAVE_BOOST_PFR
 template <bool view, typename S, typename ...tags> typename std::enable_if_t<is_really_auto_serializable_v<S> && !has_tuple_for_serialization<true, S, tags...>::value && impl::is_deserializable_f<S, view, false, tags...>(), bool>
 deserialize_from(const char *&p, const char *end, S &s, tags... tt) noexcept(is_noexcept_for<S, tags...>(nt::deser)) {
+    if constexpr (is_fixed_layout_v<true, S, tags...>) {
+        if (size_t(end - p) < fixed_layout_len<true, S, tags...>()) return true;
+        deserialize_fixed_from(p, s, tt...);
+        return false;
+    }
     try {
         auto &&tmp = boost::pfr::structure_tie(s);
         return deserialize_from<view>(p, end, tmp, tt...);
@@ -3449,22 +3906,51 @@ deserialize_from(const char *&p, const char *end, S &s, tags... tt) noexcept(is_
 #endif
 template <bool view, typename A, typename B, typename ...tags> //pair
 [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, std::pair<A, B> &t, tags... tt) noexcept(is_noexcept_for<A, tags...>(nt::deser) && is_noexcept_for<B, tags...>(nt::deser)) {
+    if constexpr (is_fixed_layout_v<true, std::pair<A, B>, tags...>) {
+        if (size_t(end - p) < fixed_layout_len<true, std::pair<A, B>, tags...>()) return true;
+        deserialize_fixed_from(p, t, tt...);
+        return false;
+    }
     return deserialize_from<view>(p, end, const_cast<typename std::add_lvalue_reference<typename std::remove_const<A>::type>::type>(t.first), tt...) //remove const needed for maps
         || deserialize_from<view>(p, end, t.second, tt...); }
 template <bool view, typename T, typename ...TT, typename ...tags> //tuples
 [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, std::tuple<T, TT...> &t, tags... tt) noexcept(is_noexcept_for<std::tuple<T, TT...>, tags...>(nt::deser)) {
+    if constexpr (is_fixed_layout_v<true, std::tuple<T, TT...>, tags...>) {
+        if (size_t(end - p) < fixed_layout_len<true, std::tuple<T, TT...>, tags...>()) return true;
+        deserialize_fixed_from(p, t, tt...);
+        return false;
+    }
     if (deserialize_from<view>(p, end, std::get<0>(t), tt...)) return true;
     auto tail = tuple_tail(t); return deserialize_from<view>(p, end, tail, tt...); }
 template <bool view, typename T, typename ...TT, typename ...tags> //tuples
 [[nodiscard]] inline bool deserialize_from(const char *&p, const char *end, std::tuple<T, TT...> &&t, tags... tt) noexcept(is_noexcept_for<std::tuple<T, TT...>, tags...>(nt::deser)) {
+    if constexpr (is_fixed_layout_v<true, std::tuple<T, TT...>, tags...>) {
+        if (size_t(end - p) < fixed_layout_len<true, std::tuple<T, TT...>, tags...>()) return true;
+        deserialize_fixed_from(p, t, tt...);
+        return false;
+    }
     if (deserialize_from<view>(p, end, std::get<0>(t), tt...)) return true;
     auto tail = tuple_tail(t); return deserialize_from<view>(p, end, tail, tt...); }
 template <bool view, typename T, size_t L, typename ...tags> bool deserialize_from(const char *&p, const char *end, std::array<T, L> &o, tags... tt) noexcept(is_noexcept_for<T, tags...>(nt::deser))
-{ for (T &t:o) if (deserialize_from<view>(p, end, t, tt...)) return true;
-  return false; }
+{
+    if constexpr (is_fixed_layout_v<true, std::array<T, L>, tags...>) {
+        if (size_t(end - p) < fixed_layout_len<true, std::array<T, L>, tags...>()) return true;
+        deserialize_fixed_from(p, o, tt...);
+        return false;
+    }
+    for (T &t:o) if (deserialize_from<view>(p, end, t, tt...)) return true;
+    return false;
+}
 template <bool view, typename T, size_t L, typename ...tags> bool deserialize_from(const char *&p, const char *end, T (&o)[L], tags... tt) noexcept(is_noexcept_for<T, tags...>(nt::deser))
-{ for (T &t:o) if (deserialize_from<view>(p, end, t, tt...)) return true;
-  return false; }
+{
+    if constexpr (is_fixed_layout_v<true, T[L], tags...>) {
+        if (size_t(end - p) < fixed_layout_len<true, T[L], tags...>()) return true;
+        deserialize_fixed_from(p, o, tt...);
+        return false;
+    }
+    for (T &t:o) if (deserialize_from<view>(p, end, t, tt...)) return true;
+    return false;
+}
 template <bool view, typename T, typename ...tags> bool deserialize_from(const char *&p, const char *end, std::unique_ptr<T> &pp, tags... tt)
 { bool h; if (deserialize_from<view>(p, end, h)) return true; if (h) { pp = std::make_unique<T>(); if (deserialize_from<view>(p, end, *pp, tt...)) return true; } else pp.reset(); return false; }
 template <bool view, typename T, typename ...tags> bool deserialize_from(const char *&p, const char *end, std::shared_ptr<T> &pp, tags... tt)
@@ -3492,6 +3978,21 @@ constexpr bool IsJSON(ParseMode m) noexcept { return m == ParseMode::JSON_Strict
  *          We dont throw (uf::error derived exceptions) in this function, but return an error instead.*/
 std::pair<std::string, bool> parse_value(std::string &to, std::string_view &value, ParseMode mode);
 
+/** Creates a serialized raw bytestring of a known type from a textual description.
+ * Unlike parse_value() we write directly into the layout of 'type', so lists
+ * and maps of JSON values are not wrapped into 'any' values first and need no
+ * later conversion. Values of a different type (e.g., an integer for a 'd'
+ * or a heterogeneous list for an 'la') are converted as by uf::convert().
+ * @param [out] to The string we append our raw output to.
+ * @param value The textual description to parse. We consume characters
+ *              from this view as we progress.
+ * @param type The type to produce. We consume one type from it.
+ *             It must be a valid typestring.
+ * @param mode How to handle and convert certain values (Normal is the same as Liberal).
+ * @returns an empty optional on success or an error string.
+ *          We dont throw (uf::error derived exceptions) in this function, but return an error instead.*/
+std::optional<std::string> parse_value_as(std::string &to, std::string_view &value, std::string_view &type, ParseMode mode);
+
 /** Finds the length of a serialized value given its textual type description.
  * @param type The string view containing the type of the serialized value.
  *             As we progress, we consume chars from this string view via
@@ -3566,6 +4067,7 @@ bool print_escaped_to(std::string& to, unsigned max_len, std::string_view s, std
 serialize_scan_by_type(std::string_view type, std::string_view value,
                        bool allow_longer = false, bool check_recursively = false)
 {
+    stat_add(stat_event::scan, type, {}, value.size());
     const char *p = value.data(), *end = p + value.length(); //end must not be const
     std::string_view worktype = type;
     if (std::unique_ptr<value_error> e = serialize_scan_by_type_from(worktype, p, end, {}, {}, check_recursively)) {
@@ -3740,6 +4242,54 @@ template<bool view, typename T, typename ...tags,
     typename = std::enable_if_t<view ? is_deserializable_view<T, tags...>::value : is_deserializable<T, tags...>::value>>
 [[nodiscard]] inline std::unique_ptr<value_error> deserialize_convert_from(bool &can_disappear, deserialize_convert_params &p, T &o, tags... tt);
 
+/** If set, errors of converting deserialization are created without message and
+ * typestrings, only with the position in the deepest source and target types.
+ * Set by callers that only need to know if (and roughly where) a conversion fails,
+ * such as converts_to() and try_get(), so that a failing probe formats nothing.
+ * Such callers hand the error back via recycle_quiet_error() when done, so
+ * after the first failure on a thread, a failing probe makes no heap allocation.*/
+inline thread_local bool quiet_conversion_errors = false;
+
+/** A quiet error of type E handed back by recycle_quiet_error() for reuse.*/
+template <typename E>
+inline thread_local std::unique_ptr<E> spare_quiet_error;
+
+/** Creates an error of type E for quiet mode. Reuses the spare one if any.
+ * 'args' are the constructor arguments of an empty error.*/
+template <typename E, typename ...Args>
+inline std::unique_ptr<value_error> make_quiet_error(Args&&... args) {
+    if (spare_quiet_error<E>) return std::move(spare_quiet_error<E>);
+    return std::make_unique<E>(std::forward<Args>(args)...);
+}
+
+template <typename E>
+inline bool keep_quiet_error(std::unique_ptr<value_error> &e) noexcept {
+    if (typeid(*e) != typeid(E) || spare_quiet_error<E>) return false;
+    spare_quiet_error<E>.reset(static_cast<E*>(e.release()));
+    return true;
+}
+
+/** Keeps a no longer needed quiet error for reuse by make_quiet_error(), or frees it.*/
+inline void recycle_quiet_error(std::unique_ptr<value_error> e) noexcept {
+    if (!e) return;
+    e->msg.clear();
+    e->my_what.clear();
+    for (auto &t : e->types) {
+        t.type.clear();
+        t.pos.clear();
+    }
+    keep_quiet_error<type_mismatch_error>(e) || keep_quiet_error<value_mismatch_error>(e)
+        || keep_quiet_error<typestring_error>(e);
+}
+
+/** Sets quiet_conversion_errors for its lifetime.*/
+struct quiet_conversion_errors_scope {
+    const bool prev = quiet_conversion_errors;
+    quiet_conversion_errors_scope() noexcept { quiet_conversion_errors = true; }
+    ~quiet_conversion_errors_scope() { quiet_conversion_errors = prev; }
+    quiet_conversion_errors_scope(const quiet_conversion_errors_scope &) = delete;
+};
+
 /** Helper to throw a deserialization convert error.
  * Process the stack of deserialize_convert_params, eliminate the ones not needed
  * (see the comment for deserialize_convert_params) and create a single
@@ -3753,6 +4303,12 @@ inline std::unique_ptr<value_error> &&create_error_for_des(std::unique_ptr<value
 {
     if (!p) e = {};
     if (!e) return std::move(e);
+    if (quiet_conversion_errors) {
+        //Only the position in the deepest types, no typestrings.
+        e->types[0].pos = uint16_t(std::min<size_t>(p->type - p->tstart, std::numeric_limits<uint16_t>::max()));
+        e->types[1].pos = uint16_t(std::min<size_t>(p->target_type - p->target_tstart, std::numeric_limits<uint16_t>::max()));
+        return std::move(e);
+    }
     std::string source_type;
     int source_pos = -1;
     const char *deepest_target_type = p->target_type;
@@ -3800,22 +4356,33 @@ inline std::unique_ptr<value_error> &&create_error_for_des(std::unique_ptr<value
 
 
 inline std::unique_ptr<value_error> create_des_type_error(const deserialize_convert_params &p) {
+    if (quiet_conversion_errors)
+        return create_error_for_des(make_quiet_error<uf::type_mismatch_error>(std::string_view{}, std::string_view{}, std::string_view{}), &p);
     return create_error_for_des(std::make_unique<uf::type_mismatch_error>("Type mismatch when converting <%1> to <%2>", std::string_view{}, std::string_view{}), &p);
 }
 
 inline std::unique_ptr<value_error> create_des_type_error(const deserialize_convert_params &p, serpolicy reason) {
+    stat_add(stat_event::policy_refused, {p.tstart, size_t(p.tend - p.tstart)}, {p.target_tstart, size_t(p.target_tend - p.target_tstart)}, 0, reason);
+    if (quiet_conversion_errors)
+        return create_error_for_des(make_quiet_error<uf::type_mismatch_error>(std::string_view{}, std::string_view{}, std::string_view{}), &p);
     return create_error_for_des(std::make_unique<uf::type_mismatch_error>(uf::concat("Type mismatch when converting <%1> to <%2> (missing flag: ", to_string(reason), ')'), std::string_view{}, std::string_view{}), &p);
 }
 
 inline std::unique_ptr<value_error> create_des_value_error(const deserialize_convert_params &p) {
+    if (quiet_conversion_errors)
+        return create_error_for_des(make_quiet_error<uf::value_mismatch_error>(std::string_view{}), &p);
     return create_error_for_des(std::make_unique<uf::value_mismatch_error>(uf::concat(ser_error_str(ser::val), " <%1>.")), &p);
 }
 
 inline std::unique_ptr<value_error> create_des_typestring_source(const deserialize_convert_params &p, std::string_view msg) {
+    if (quiet_conversion_errors)
+        return create_error_for_des(make_quiet_error<uf::typestring_error>(std::string_view{}, std::string_view{}), &p);
     return create_error_for_des(std::make_unique<uf::typestring_error>(uf::concat(msg, " <%1>."), std::string_view{}), &p);
 }
 
 inline std::unique_ptr<value_error> create_des_typestring_target(const deserialize_convert_params &p, std::string_view msg) {
+    if (quiet_conversion_errors)
+        return create_error_for_des(make_quiet_error<uf::typestring_error>(std::string_view{}, std::string_view{}), &p);
     return create_error_for_des(std::make_unique<uf::typestring_error>(uf::concat(msg, " <%2>."), std::string_view{}), &p);
 }
 
@@ -3976,6 +4543,12 @@ struct any_view
     /** Returns true if we contain no value (and no type). */
     [[nodiscard]] bool is_void() const noexcept { return _type.length()==0; }
 
+    /** Copy our type and value to memory allocated from 'mr' and return a view of the copy.
+     * The result is valid until 'mr' releases its memory (e.g., a std::pmr::monotonic_buffer_resource
+     * is released), so it can be used instead of a heap allocated uf::any, when all data of a
+     * request lives in an arena.*/
+    [[nodiscard]] any_view copy_to(std::pmr::memory_resource *mr) const;
+
     /** Returns true if we contain a structured type (list, map, tuple, any). */
     [[nodiscard]] bool is_structured_type() const noexcept { return _type.length() && (_type.front()=='l'||_type.front()=='m'||_type.front()=='t'||_type.front()=='a'); }
 
@@ -4020,6 +4593,16 @@ struct any_view
     template<typename T, typename ...tags>
     void get(T&, serpolicy convpolicy = allow_converting_all, uf::use_tags_t = {}, tags...) const;
 
+    /** Extract the value from us into an arbitrary C++ variable without throwing.
+     * Same as get(), but failures are reported as a compact get_status and no error
+     * message is built. The error object is reused across calls, so after the first
+     * failure on a thread, failed attempts make no heap allocation. Use it to probe
+     * candidate types.
+     * On failure 't' may be partially overwritten.
+     * This function throws only what T's deserialization does (e.g., std::bad_alloc).*/
+    template<typename T, typename ...tags>
+    [[nodiscard]] get_status try_get(T&, serpolicy convpolicy = allow_converting_all, uf::use_tags_t = {}, tags...) const;
+
     /** Extract the value from us into an any. A specialization.
      * Note that here we copy our content into an 'any', whcih is strictly speaking a conversion.
      * I we contain another any, we essentially unwrap. But if some other type is whithin,
@@ -4170,6 +4753,21 @@ struct any_view
         return print(max_len, chars, escape_char, true);
     }
 
+    /** Prints us the same way as print(), but passes the text to 'sink' in pieces.
+     * Pieces are emitted between elements of lists, maps and tuples, when about 'chunk_size'
+     * bytes of text accumulated, so memory use is bounded by the chunk size plus the text
+     * of the largest string or primitive, not by the size of the whole value.
+     * The text is emitted as it is generated, so on an error (thrown as with print())
+     * the sink may have received the beginning of the text.
+     * Exceptions thrown by the sink are propagated.*/
+    void print_to_sink(const std::function<void(std::string_view)> &sink, size_t chunk_size = 65536,
+                       std::string_view chars = {}, char escape_char = '%', bool json_like = false) const;
+    /** Syntactic sugar for print_to_sink(..., ..., ..., ..., json_like = true). */
+    void print_json_to_sink(const std::function<void(std::string_view)> &sink, size_t chunk_size = 65536,
+                            std::string_view chars = {}, char escape_char = '%') const {
+        print_to_sink(sink, chunk_size, chars, escape_char, true);
+    }
+
     /** Checks if our content is exactly the same type that the given typestring.
      * Equivalent, but faster than 'converts_to(allow_converting_none)'.*/
     [[nodiscard]] bool is(std::string_view t) const noexcept { return t==_type; }
@@ -4258,6 +4856,13 @@ protected:
     friend std::pair<std::string, bool> impl::parse_value(std::string &to, std::string_view &value, impl::ParseMode mode);
 };
 
+/** Returns a process-wide copy of a typestring that is never freed.
+ * Interning the same typestring again returns the same view, so interned
+ * typestrings are equal if and only if their data() pointers are equal.
+ * The typestring is not checked. Thread-safe. Do not intern typestrings
+ * from untrusted sources, as the table never shrinks.*/
+[[nodiscard]] std::string_view intern_typestring(std::string_view type);
+
 /** An object that can hold any value and its type.
   * It can be empty, meaning void.
   * It can be created from a typed C++ value.
@@ -4265,14 +4870,17 @@ protected:
   * the type string of `T` and its value.
   * It can also be created from a string description, like: <2si>("str";5)
   * It can also be pretty printed into such a form.
+  * Its content is always on the heap (in a std::string), it does not take an allocator.
+  * For values that should live in a std::pmr::memory_resource, see any_view::copy_to().
   *
   * See any_view for a type providing views to and into any variables.*/
 struct any : any_view
 {
     [[nodiscard]] any() noexcept(noexcept(std::string())) = default;
     [[nodiscard]] any(const any &o) : any_view(), _storage(o._storage) {
-        _type  = std::string_view(_storage.data()+(o._type.data() -o._storage.data()), o._type.length());
-        _value = std::string_view(_storage.data()+(o._value.data()-o._storage.data()), o._value.length());
+        _type  = _relocate(o._type, o._storage);
+        _value = _relocate(o._value, o._storage);
+        _stat_alloc();
     }
     [[nodiscard]] any(any &&o) noexcept : any_view() { operator=(std::move(o)); }
     template<typename ...tags>
@@ -4361,16 +4969,17 @@ struct any : any_view
     any &operator=(const any_view &o) { assign(o); return *this; }
     any &operator=(const any &o) {
         _storage = o._storage;
-        _type = std::string_view(_storage.data()+(o._type.data() -o._storage.data()), o._type.length());
-        _value = std::string_view(_storage.data()+(o._value.data()-o._storage.data()), o._value.length());
+        _type = _relocate(o._type, o._storage);
+        _value = _relocate(o._value, o._storage);
+        _stat_alloc();
         return *this;
     }
     any &operator=(any &&o) noexcept {
-        const size_t off_type = o._type.data() -o._storage.data();
-        const size_t off_value = o._value.data()-o._storage.data();
+        const ptrdiff_t off_type = _offset(o._type, o._storage);
+        const ptrdiff_t off_value = _offset(o._value, o._storage);
         _storage = std::move(o._storage);
-        _type = std::string_view(_storage.data()+ off_type, o._type.length());
-        _value = std::string_view(_storage.data()+off_value, o._value.length());
+        _type = off_type < 0 ? o._type : std::string_view(_storage.data()+ off_type, o._type.length());
+        _value = off_value < 0 ? o._value : std::string_view(_storage.data()+off_value, o._value.length());
         o.clear();
         return *this;
     }
@@ -4379,15 +4988,32 @@ struct any : any_view
     void clear() noexcept { any_view::clear(); _storage = {}; }
 
     void swap(any &o) noexcept { //consider SSO and that _storage may have front and back padding
-        const ptrdiff_t ot1 =   _type.data()-  _storage.data(), ov1 =   _value.data()-  _storage.data();
-        const ptrdiff_t ot2 = o._type.data()-o._storage.data(), ov2 = o._value.data()-o._storage.data();
+        const ptrdiff_t ot1 = _offset(  _type,   _storage), ov1 = _offset(  _value,   _storage);
+        const ptrdiff_t ot2 = _offset(o._type, o._storage), ov2 = _offset(o._value, o._storage);
         _storage.swap(o._storage);
         any_view::swap(o);
-        if (_type.length())  _type =  std::string_view(_storage.data()+ot2, _type.length());
-        if (_value.length()) _value = std::string_view(_storage.data()+ov2, _value.length());
-        if (o._type.length())  o._type =  std::string_view(o._storage.data()+ot1, o._type.length());
-        if (o._value.length()) o._value = std::string_view(o._storage.data()+ov1, o._value.length());
+        if (_type.length() && ot2 >= 0)  _type =  std::string_view(_storage.data()+ot2, _type.length());
+        if (_value.length() && ov2 >= 0) _value = std::string_view(_storage.data()+ov2, _value.length());
+        if (o._type.length() && ot1 >= 0)  o._type =  std::string_view(o._storage.data()+ot1, o._type.length());
+        if (o._value.length() && ov1 >= 0) o._value = std::string_view(o._storage.data()+ov1, o._value.length());
+    }
+
+    /** Replace our typestring with its interned copy (see intern_typestring()),
+     * so that we store only our value. Anys created from C++ values already
+     * use interned typestrings. Useful when many anys of the same type are kept.
+     * @returns us.*/
+    any &intern_type() {
+        if (_type.empty() || _offset(_type, _storage) < 0) return *this;
+        const std::string_view t = intern_typestring(_type);
+        std::string v(_value);
+        _storage = std::move(v);
+        _type = t;
+        _value = _storage;
+        _stat_alloc();
+        return *this;
     }
+    /** True if our typestring is not stored in us, but is interned.*/
+    [[nodiscard]] bool has_interned_type() const noexcept { return _type.size() && _offset(_type, _storage) < 0; }
 
     auto tuple_for_serialization() const noexcept { return any_view::tuple_for_serialization(); } //Could not inherit due to =delete below.
     auto tuple_for_serialization() noexcept = delete; //Disable this (as it would allow view only). Provide special L1 handlers for any.
@@ -4403,21 +5029,27 @@ struct any : any_view
     template<typename T, typename ...tags>
     any &assign(const T& value, uf::use_tags_t={}, tags... tt)
     {
+        if constexpr (std::is_base_of_v<any_view, T>) //e.g., compressed_any::view_type: take the content, do not nest
+            return assign(static_cast<const any_view &>(value));
         static_assert(uf::impl::is_serializable_f<T, true, tags...>(), "Type must be serializable.");
+        static_assert(!impl::is_little_endian_v<tags...>, "The content of an any is always in the standard byte order.");
         if constexpr (uf::impl::is_serializable_f<T, false, tags...>()) {
-            constexpr size_t tlen = impl::serialize_type_static<false, T, tags...>().size();
-            std::string tmp(serialize_type<T, tags...>());
+            //The typestring of a C++ type is interned once, we store only the value.
+            static const std::string_view type = intern_typestring(serialize_type<T, tags...>());
+            std::string tmp;
             if constexpr (impl::has_before_serialization_inside_v<T, tags...>)
                 if (auto r = impl::call_before_serialization(&value, tt...); r.obj)
                     impl::call_after_serialization(&value, r, tt...); //This shall throw
             try {
-                tmp.resize(tlen+impl::serialize_len(value, tt...));
-                char *p = tmp.data()+tlen;
+                tmp.resize(impl::serialize_len(value, tt...));
+                char *p = tmp.data();
                 impl::serialize_to(value, p, tt...);
                 if constexpr (impl::has_after_serialization_inside_v<T, tags...>)
                     impl::call_after_serialization(&value, true, tt...);
                 _storage = std::move(tmp);
-                _set_type_value(tlen);
+                _type = type;
+                _value = _storage;
+                _stat_alloc();
             } catch (...) {
                 if constexpr (impl::has_after_serialization_inside_v<T, tags...>)
                     impl::call_after_serialization(&value, false, tt...);
@@ -4561,15 +5193,34 @@ protected:
     void _set_type_value(size_t tlen) noexcept {
         _type = std::string_view(_storage).substr(0, tlen);
         _value = std::string_view(_storage).substr(tlen);
+        _stat_alloc();
+    }
+    /** Count the allocation of our storage if it does not fit in the string's internal buffer.*/
+    void _stat_alloc() const noexcept {
+        if constexpr (stats_enabled)
+            if (_storage.size() > std::string().capacity())
+                impl::stat_add(stat_event::any_alloc, _type, {}, _storage.size());
+    }
+    /** Returns the offset of 'v' in 'storage' or -1 if it is outside (interned or empty).*/
+    static ptrdiff_t _offset(std::string_view v, const std::string &storage) noexcept {
+        const std::less_equal<const char *> le;
+        if (v.data() && le(storage.data(), v.data()) && le(v.data() + v.size(), storage.data() + storage.size()))
+            return v.data() - storage.data();
+        return -1;
+    }
+    /** Returns 'v' moved from 'from' into our _storage (a copy of 'from') if it is in 'from'.*/
+    std::string_view _relocate(std::string_view v, const std::string &from) const noexcept {
+        const ptrdiff_t off = _offset(v, from);
+        return off < 0 ? v : std::string_view(_storage.data() + off, v.length());
     }
     std::string _storage;  ///<The place where we store the type and value (in no specific order and maybe with extra bytes before, after or in-between.
 };
 
 /** @}  serialization */
 
-template <bool view, typename ...tags> inline bool impl::deserialize_from(const char *&p, const char *end, any &s, tags...) {
+template <bool view, typename ...tags> inline bool impl::deserialize_from(const char *&p, const char *end, any &s, tags... tt) {
     std::pair<std::string_view, std::string_view> type_value;
-    if (deserialize_from<true>(p, end, type_value)) return true;
+    if (deserialize_from<true>(p, end, type_value, tt...)) return true;
     s.assign(from_type_value_unchecked, type_value.first, type_value.second);
     return false;
 }
@@ -4612,17 +5263,62 @@ static_assert(!has_tuple_for_serialization_tag_v<true, any>, "HEJ!!!");
 
 inline std::string to_string(const uf::any_view& a) { return a.print(); }
 
+/** Three-way compares two values by their content, walking their serialized form.
+ * Unlike any_view::operator<, which compares the bytes of the types and values,
+ * this orders values the way their C++ counterparts would be ordered.
+ * - i, I and d are compared by numeric value, so <i>5 is equivalent to <d>5.0.
+ *   NaNs are equivalent to each other and greater than any number; -0.0 is equivalent to 0.0.
+ * - b and c are compared as unsigned bytes, s as a byte string.
+ * - Lists and tuples are compared lexicographically, element by element.
+ * - Maps are compared as if their elements were sorted by key (as in a std::map),
+ *   so the order in which they were serialized does not matter.
+ * - A missing optional comes before any value, an expected with an error before one with a value.
+ * - anys are compared by their content, recursively.
+ * - Values of different kinds (say a string and a list) are ordered by kind: void, number,
+ *   bool, char, string, list, map, tuple, optional, any, expected, error.
+ * @exception uf::value_mismatch_error if a value does not match its type.
+ * @exception uf::typestring_error if a typestring is invalid.*/
+[[nodiscard]] std::weak_ordering compare(const any_view &a, const any_view &b);
+/** True if two values are equivalent by content, see compare().*/
+[[nodiscard]] inline bool equivalent(const any_view &a, const any_view &b) { return compare(a, b) == 0; }
+/** Hashes a value by its content, consistently with compare(): equivalent values have
+ * the same hash. We walk the serialized form; strings and lists of numbers are hashed
+ * 8 bytes at a time in four independent lanes. The hash is not stable across versions
+ * or platforms, do not persist it.
+ * @exception uf::value_mismatch_error if the value does not match its type.
+ * @exception uf::typestring_error if the typestring is invalid.*/
+[[nodiscard]] size_t hash(const any_view &a);
+
+/** Function objects to key hash tables and sorted containers by the content of serialized
+ * values, e.g., std::unordered_map<uf::any, T, uf::any_hash, uf::any_equivalent>.*/
+struct any_hash {
+    using is_transparent = void;
+    [[nodiscard]] size_t operator()(const any_view &a) const { return hash(a); }
+};
+struct any_equivalent {
+    using is_transparent = void;
+    [[nodiscard]] bool operator()(const any_view &a, const any_view &b) const { return equivalent(a, b); }
+};
+struct any_less {
+    using is_transparent = void;
+    [[nodiscard]] bool operator()(const any_view &a, const any_view &b) const { return compare(a, b) < 0; }
+};
+
 
 } //ns uf
 
+namespace uf::impl {
+/** uf::hash() for valid values, a hash of the bytes for invalid ones.*/
+[[nodiscard]] size_t hash_noexcept(const any_view &a) noexcept;
+} //ns uf::impl
+
 namespace std {
+  /** These hash by content (see uf::hash()), which is also consistent with the bytewise operator==.*/
   template <> struct hash<uf::any> {
-    std::size_t operator()(const uf::any &a) const noexcept
-    { return std::hash<std::string_view>()(a.type()) ^ (std::hash<std::string_view>()(a.value())<<1) ; }
+    std::size_t operator()(const uf::any &a) const noexcept { return uf::impl::hash_noexcept(a); }
   };
   template <> struct hash<uf::any_view> {
-    std::size_t operator()(const uf::any_view &a) const noexcept
-    { return std::hash<std::string_view>()(a.type()) ^ (std::hash<std::string_view>()(a.value())<<1) ; }
+    std::size_t operator()(const uf::any_view &a) const noexcept { return uf::impl::hash_noexcept(a); }
   };
 }
 
@@ -4667,14 +5363,17 @@ inline expected_with_error::expected_with_error(std::string_view _msg, std::stri
         types[0].pos.push_back((uint16_t)std::min(size_t(std::numeric_limits<uint16_t>::max()), p.first));
         types[1].pos.push_back((uint16_t)std::min(size_t(std::numeric_limits<uint16_t>::max()), p.second));
     }
+    regenerate_what(); //the base constructor could not expand '%e' or use the positions above
 }
 
-inline void expected_with_error::throw_me() const { throw *this; }
+inline void expected_with_error::throw_me() const { impl::stat_add(stat_event::error, types[0].type, types[1].type); throw *this; }
 
 template<typename T, typename ...tags>
 void any_view::get(T& t, serpolicy convpolicy, uf::use_tags_t, tags... tt) const {
     static_assert(uf::impl::is_deserializable_f<T, false, true, tags...>(), "Type must be possible to deserialize into.");
+    static_assert(!impl::is_little_endian_v<tags...>, "The content of an any is always in the standard byte order.");
     if constexpr (uf::impl::is_deserializable_f<T, false, false, tags...>()) {
+        impl::stat_add(_type == deserialize_type<T, tags...>() ? stat_event::get : stat_event::convert, _type, deserialize_type<T, tags...>(), _value.size());
     //fast path, exactly equal types
         if (_type == deserialize_type<T, tags...>()) {
             const char *p = _value.data(), *const end = p+_value.length();
@@ -4698,10 +5397,51 @@ void any_view::get(T& t, serpolicy convpolicy, uf::use_tags_t, tags... tt) const
     }
 }
 
+template<typename T, typename ...tags>
+get_status any_view::try_get(T& t, serpolicy convpolicy, uf::use_tags_t, tags... tt) const {
+    static_assert(uf::impl::is_deserializable_f<T, false, true, tags...>(), "Type must be possible to deserialize into.");
+    static_assert(!impl::is_little_endian_v<tags...>, "The content of an any is always in the standard byte order.");
+    if constexpr (uf::impl::is_deserializable_f<T, false, false, tags...>()) {
+        impl::stat_add(_type == deserialize_type<T, tags...>() ? stat_event::get : stat_event::convert, _type, deserialize_type<T, tags...>(), _value.size());
+        //fast path, exactly equal types
+        if (_type == deserialize_type<T, tags...>()) {
+            const char *p = _value.data(), *const end = p+_value.length();
+            if (impl::deserialize_from<false>(p, end, t, tt...))
+                return {get_status::code::value_mismatch};
+            return {};
+        }
+        impl::quiet_conversion_errors_scope quiet;
+        std::vector<error_value> errors;
+        std::vector<std::pair<size_t, size_t>> error_pos;
+        impl::deserialize_convert_params p(_value, _type, &t, convpolicy, nullptr,
+                                           &errors, &error_pos, tt...);
+        bool can_disappear;
+        try {
+            if (auto err = impl::deserialize_convert_from<false>(can_disappear, p, t, tt...)) {
+                const get_status ret = get_status::from(*err);
+                impl::recycle_quiet_error(std::move(err));
+                return ret;
+            }
+        } catch (const value_error &e) {
+            return get_status::from(e);
+        }
+        if (p.type < p.tend)
+            return {get_status::code::typestring, uint16_t(std::min<size_t>(p.type - p.tstart, std::numeric_limits<uint16_t>::max()))};
+        if (p.target_type < p.target_tend)
+            return {get_status::code::type_mismatch, uint16_t(std::min<size_t>(p.type - p.tstart, std::numeric_limits<uint16_t>::max())),
+                    uint16_t(std::min<size_t>(p.target_type - p.target_tstart, std::numeric_limits<uint16_t>::max()))};
+        if (errors.size())
+            return {get_status::code::expected_error};
+    }
+    return {};
+}
+
 template<typename T, typename ...tags>
 void any_view::get_view(T& t, serpolicy convpolicy, uf::use_tags_t, tags... tt) const {
     static_assert(uf::impl::is_deserializable_f<T, true, true, tags...>(), "Type must be possible to deserialize into.");
+    static_assert(!impl::is_little_endian_v<tags...>, "The content of an any is always in the standard byte order.");
     if constexpr (uf::impl::is_deserializable_f<T, true, false, tags...>()) {
+        impl::stat_add(_type == deserialize_type<T, tags...>() ? stat_event::get : stat_event::convert, _type, deserialize_type<T, tags...>(), _value.size());
         //fast path, exactly equal types
         if (_type == deserialize_type<T, tags...>()) {
             const char *p = _value.data(), *const end = p + _value.length();
@@ -4725,6 +5465,656 @@ void any_view::get_view(T& t, serpolicy convpolicy, uf::use_tags_t, tags... tt)
     }
 }
 
+namespace impl {
+
+/** A flat program that transcodes a serialized value of a source type to the serialized
+ * value of a target type. It can be compiled only for type pairs that are structurally
+ * the same (same tuple sizes, lists to lists, etc.) and differ only in primitive
+ * conversions (e.g., i->I or c->b) allowed by the policy, plus T->xT and xT->T.
+ * For all other type pairs valid() returns false.
+ * Identical subtrees are copied in one step (those of fixed size, via bounds check only).
+ * If run() fails (because of bad data, or because an xT contains an error),
+ * the caller shall repeat the conversion using the generic deserialize_convert_from()
+ * to get the proper error (or to collect the errors in expected values).*/
+class conversion_program
+{
+public:
+    enum class op : uint8_t {
+        copy,       ///<arg1 bytes copied verbatim
+        str,        ///<a length prefixed string copied verbatim
+        fixed_list, ///<a list of fixed-size elements of arg1 size, copied verbatim
+        scan,       ///<an identical subtree copied verbatim, its type is at type[arg1..arg1+arg2)
+        list,       ///<a list or map, the body is until the matching 'end' at index arg1
+        opt,        ///<an optional, the body is until the matching 'end' at index arg1
+        end,        ///<end of a list or optional body
+        add_x,      ///<T->xT: emit a has_value byte
+        drop_x,     ///<xT->T: consume a has_value byte, fail if it indicates an error
+        b2c, b2i, b2I, c2b, c2i, c2I, i2b, i2c, i2I, i2d, I2b, I2c, I2i, I2d, d2i, d2I
+    };
+    struct instr { op code; uint32_t arg1 = 0, arg2 = 0; };
+    /** Compile a program for 'source' to 'target' under 'policy'. */
+    conversion_program(std::string_view source, std::string_view target, serpolicy policy);
+    /** True, if the type pair could be compiled.*/
+    [[nodiscard]] bool valid() const noexcept { return _valid; }
+    /** True, if the two types are the same. (Then, the program is a single identical copy.)*/
+    [[nodiscard]] bool identical() const noexcept { return _identical; }
+    /** Transcode 'value' appending to 'to'. Returns false on any problem.
+     * Consumes all of value, returns false if it is longer.*/
+    [[nodiscard]] bool run(std::string_view value, std::string &to) const;
+    [[nodiscard]] const std::vector<instr> &code() const noexcept { return _code; }
+private:
+    bool compile(const char *&s, const char *se, const char *&t, const char *te, serpolicy policy);
+    void emit_identical(const char *s, size_t len);
+    bool run(size_t from, size_t to, const char *&p, const char *end, std::string &out) const;
+    std::string _type; ///<The source type, 'scan' instructions refer to this
+    std::vector<instr> _code;
+    bool _valid = false;
+    bool _identical = false;
+};
+
+/** Transparent string hash for heterogeneous lookups.*/
+struct string_hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+};
+
+} //ns impl
+
+/** A pre-compiled conversion from a given source typestring to the C++ type 'T'.
+ * Use it when the same (source type, target type, policy) combination repeats often.
+ * At construction the two typestrings are analysed once and, if possible, compiled to
+ * a flat transcoding program (see impl::conversion_program). Later get() calls just run that
+ * program over the bytes and deserialize the result with the non-converting, fast deserializer.
+ * If the program cannot handle the type pair or the value (e.g., the value is malformed or
+ * contains expected errors), we fall back to any_view::get(), thus the end result, including
+ * exceptions thrown, is always the same as that of any_view::get().
+ * Use cached() to get a shared plan from a bounded, thread-safe cache.*/
+template <typename T, typename ...tags>
+class conversion_plan
+{
+    static_assert(uf::impl::is_deserializable_f<T, false, true, tags...>(), "Type must be possible to deserialize into.");
+    std::string _source_type;
+    serpolicy _policy;
+    impl::conversion_program _program;
+public:
+    /** The maximum number of plans kept by cached() per T. */
+    static constexpr size_t cache_capacity = 256;
+    explicit conversion_plan(std::string_view source_type, serpolicy policy = allow_converting_all) :
+        _source_type(source_type), _policy(policy), _program(source_type, deserialize_type<T, tags...>(), policy) {}
+    [[nodiscard]] std::string_view source_type() const noexcept { return _source_type; }
+    [[nodiscard]] serpolicy policy() const noexcept { return _policy; }
+    /** True if conversion will use the compiled program (if the value is good).*/
+    [[nodiscard]] bool is_compiled() const noexcept { return _program.valid(); }
+
+    /** Deserialize 'a' into 't' with conversion. Has the same effect as a.get(t, policy(), use_tags, tt...).
+     * If the type of 'a' is not our source_type(), we simply call that.*/
+    void get(any_view a, T &t, tags... tt) const {
+        if constexpr (uf::impl::is_deserializable_f<T, false, false, tags...>()) {
+            if (!_program.valid() || _program.identical() || a.type() != _source_type)
+                return a.get(t, _policy, use_tags, tt...);
+            static thread_local std::string tl_buf;
+            std::string buf = std::move(tl_buf); //move out: get() may be re-entered from an after_deserialization()
+            buf.clear();
+            if (_program.run(a.value(), buf)) {
+                const char *p = buf.data(), *const end = p + buf.size();
+                if (!impl::deserialize_from<false>(p, end, t, tt...) && p == end) {
+                    tl_buf = std::move(buf);
+                    return;
+                }
+            }
+            tl_buf = std::move(buf);
+            a.get(t, _policy, use_tags, tt...);
+        }
+    }
+    /** Return a deserialized value. Has the same effect as a.get_as<T>(policy(), use_tags, tt...).*/
+    [[nodiscard]] T get_as(any_view a, tags... tt) const { T t; get(a, t, tt...); return t; }
+
+    /** Return a shared conversion plan for 'source_type' and 'policy' from a cache.
+     * The cache is thread-safe and holds at most cache_capacity entries per T: if full,
+     * an arbitrary entry is dropped.*/
+    [[nodiscard]] static std::shared_ptr<const conversion_plan> cached(std::string_view source_type,
+                                                                     serpolicy policy = allow_converting_all) {
+        static std::shared_mutex lock;
+        static std::unordered_map<std::string, std::shared_ptr<const conversion_plan>, impl::string_hash, std::equal_to<>> cache;
+        static thread_local std::string key;
+        key.assign(1, char(policy)).append(source_type);
+        {
+            std::shared_lock l(lock);
+            if (auto i = cache.find(std::string_view(key)); i != cache.end()) return i->second;
+        }
+        auto plan = std::make_shared<const conversion_plan>(source_type, policy);
+        std::unique_lock l(lock);
+        if (cache.size() >= cache_capacity) cache.erase(cache.begin());
+        return cache.try_emplace(key, std::move(plan)).first->second;
+    }
+};
+
+/** A structural index over a serialized value for random access into its elements.
+ * At construction we walk the top level of the value once (using the same scan as
+ * any_view::get_content()) and record where each element is. After that
+ * - operator[]() and mapped() are O(1) for lists, tuples and maps;
+ * - find() looks up a key in a map using binary search on the serialized bytes of the keys;
+ * - child() returns an index of an element, built at first use and kept.
+ * Elements are returned in the same way as get_content() does: for maps operator[]
+ * returns the key, use mapped() for the value. For maps child() indexes the value.
+ * The index can either refer to an external value (which must outlive it) or
+ * own a uf::any (which is then kept alongside the index at a stable location).
+ * Building of children is not thread-safe, other const members are.*/
+class any_index
+{
+    std::unique_ptr<const any> _owner;
+    any_view _view;
+    std::vector<any_view> _elements;                        ///<For maps, keys and values interleaved
+    std::vector<uint32_t> _sorted;                          ///<For maps with unsorted keys: key order by bytes
+    std::vector<std::unique_ptr<any_index>> _children;      ///<Lazily built, same size as us
+    void build();
+public:
+    /** Index an external value that must outlive us.
+     * @exception uf::value_error the value is malformed (see get_content()).*/
+    explicit any_index(any_view v) : _view(v) { build(); }
+    /** Index a value kept by us.
+     * @exception uf::value_error the value is malformed (see get_content()).*/
+    explicit any_index(any &&a) : _owner(std::make_unique<const any>(std::move(a))), _view(*_owner) { build(); }
+    explicit any_index(const any &a) : _owner(std::make_unique<const any>(a)), _view(*_owner) { build(); }
+    any_index(any_index &&) noexcept = default;
+    any_index &operator=(any_index &&) noexcept = default;
+
+    /** The value we index. */
+    [[nodiscard]] any_view view() const noexcept { return _view; }
+    [[nodiscard]] bool is_map() const noexcept { return _view.type().size() && _view.type().front()=='m'; }
+    /** The number of elements (key-value pairs for maps), same as get_content().size(). */
+    [[nodiscard]] size_t size() const noexcept { return is_map() ? _elements.size()/2 : _elements.size(); }
+    [[nodiscard]] bool empty() const noexcept { return _elements.empty(); }
+    /** The k-th element (the k-th key for maps). No bounds checking. */
+    [[nodiscard]] any_view operator[](size_t k) const noexcept { return is_map() ? _elements[2*k] : _elements[k]; }
+    /** The k-th element (the k-th key for maps).
+     * @exception std::out_of_range if k>=size().*/
+    [[nodiscard]] any_view at(size_t k) const {
+        if (k>=size()) throw std::out_of_range("uf::any_index::at");
+        return (*this)[k];
+    }
+    /** The k-th value for maps, the k-th element for other types.
+     * @exception std::out_of_range if k>=size().*/
+    [[nodiscard]] any_view mapped(size_t k) const {
+        if (!is_map()) return at(k);
+        if (k>=size()) throw std::out_of_range("uf::any_index::mapped");
+        return _elements[2*k+1];
+    }
+    /** Return the index of the k-th element (the k-th value for maps).
+     * It is built at first call.
+     * @exception std::out_of_range if k>=size().
+     * @exception uf::value_error the element is malformed.*/
+    [[nodiscard]] any_index &child(size_t k);
+    /** Look up the value of a key in a map. The type of the key must be the
+     * same as the key type of the map, as we compare the serialized bytes.
+     * On duplicate keys, we return the first in serialized order.
+     * Returns an empty optional if we are not a map or the key is not found.*/
+    [[nodiscard]] std::optional<any_view> find(any_view key) const noexcept;
+    /** Look up the value of a key in a map after serializing it. */
+    template <typename K, typename ...tags> requires (!std::is_base_of_v<any_view, K>)
+    [[nodiscard]] std::optional<any_view> find(const K &key, use_tags_t = {}, tags... tt) const {
+        const any k(key, use_tags, tt...);
+        return find(any_view(k));
+    }
+};
+
+/** Push-style decoder for a serialized value arriving in chunks (e.g., from a socket).
+ * Feed successive chunks of the value via feed(). If the type is a list or a map,
+ * we call the callback for each element (as an any_view) as soon as all its bytes have
+ * arrived and drop the bytes of it. Map elements are reported as a 't2<key><mapped>' pair.
+ * For all other types we call the callback once with the complete value.
+ * Only an incomplete element is kept in a buffer, so memory use is bounded by the
+ * size of the largest element (plus a chunk), not by the size of the whole value.
+ * Elements longer than a limit are rejected as soon as their length prefix (for strings,
+ * anys and lists of fixed-size elements) or the bytes received of them exceed it.
+ * Elements that are complete inside a chunk are reported without copying.
+ * The any_view passed to the callback points into our buffer or the chunk being fed
+ * and is only valid for the duration of the callback.
+ * Since a scan failure of a partial element cannot be told apart from bytes that are
+ * still missing, malformed values (apart from bad typestrings in them) are reported
+ * at finish() at the latest. To avoid rescanning very large elements from every small
+ * chunk, elements above 64KB are only rescanned after they have grown by half.*/
+class stream_decoder
+{
+public:
+    /** The function called for each completed element.*/
+    using callback = std::function<void(any_view)>;
+    /** Create a decoder.
+     * @param [in] type The typestring of the whole value.
+     * @param [in] on_element The function to call with each completed element.
+     * @param [in] check_recursively If set, we also check 'any' values inside elements.
+     * @param [in] max_element_size Elements (or for types other than lists and maps the
+     *             whole value) longer than this are rejected as malformed.
+     * @exception uf::typestring_error if 'type' is invalid.*/
+    stream_decoder(std::string_view type, callback on_element, bool check_recursively = false,
+                   size_t max_element_size = size_t(64) << 20);
+    /** Produce a callback that deserializes each element into a T and calls 'f' with it.
+     * For maps T shall be able to take a pair, such as std::pair<K,V>.*/
+    template <typename T, typename F, typename ...tags>
+    [[nodiscard]] static callback typed(F f, serpolicy policy = allow_converting_all, use_tags_t = {}, tags... tt) {
+        return [f = std::move(f), policy, tt...](any_view e) mutable { f(e.get_as<T>(policy, use_tags, tt...)); };
+    }
+    /** Process the next chunk of the value.
+     * @returns the number of elements reported via the callback during this call.
+     * @exception uf::typestring_error an 'any' inside the value has an invalid type.
+     * @exception uf::value_mismatch_error there are bytes after the end of the value or
+     *            an element is longer than the limit.
+     * Exceptions thrown by the callback are propagated, the element is not reported again.*/
+    size_t feed(std::string_view chunk);
+    /** Signal the end of the input. Reports any element completed (in case
+     * it was waiting for a rescan) and checks that the value is complete.
+     * @returns the number of elements reported via the callback during this call.
+     * @exception uf::value_mismatch_error the value is incomplete or malformed.
+     * @exception uf::typestring_error an 'any' inside the value has an invalid type.*/
+    size_t finish();
+    /** True if the whole value has been received.*/
+    [[nodiscard]] bool done() const noexcept { return _done; }
+    /** The number of elements in the list or map, once its header arrived.*/
+    [[nodiscard]] std::optional<uint32_t> count() const noexcept { return _split && _have_count ? std::optional<uint32_t>(_count) : std::nullopt; }
+    /** The number of bytes of an incomplete element we keep.*/
+    [[nodiscard]] size_t buffered() const noexcept { return _buf.size(); }
+private:
+    const std::string _type;
+    std::string _elem_type;             ///<The type we report elements with
+    std::string _scan_type;             ///<The type(s) to scan for an element (a suffix of _type)
+    callback _on_element;
+    const bool _check;
+    const size_t _max_element;
+    const bool _split;                  ///<True for lists and maps
+    bool _have_count = false;
+    bool _done = false;
+    uint32_t _count = 0;
+    uint32_t _remaining = 0;
+    size_t _retry_at = 0;               ///<Do not rescan an element until it has this many bytes
+    std::string _buf;
+    size_t process(const char *&p, const char *end, bool final);
+};
+
+#ifndef _WIN32
+/** Writes an append-only log of serialized values into a sequence of segment files
+ * named <path>.000000, <path>.000001, etc. Each segment starts with an 8-byte magic
+ * ("uFrLog01"), followed by entries of two kinds.
+ * - A typestring definition: 0xffffffff (4 bytes) and a length-prefixed typestring.
+ *   Definitions get consecutive type ids in the segment starting from zero.
+ * - A record: a type id (4 bytes) and a length-prefixed serialized value.
+ * A typestring is thus stored only once per segment. When a segment is closed we
+ * append a footer: a serialized <t2lslI> of the typestrings and the offsets of the
+ * records, followed by the offset of the footer (8 bytes) and another magic ("uFrLogFt").
+ * All integers are big-endian, as in serialized values.
+ * A segment without a footer (e.g., still being written or after a crash) can also
+ * be read, see record_log_reader. Opening an existing log starts a new segment after
+ * the last one, earlier segments are never modified.
+ * Entries are buffered and written when 1MB has accumulated or on flush().*/
+class record_log_writer
+{
+public:
+    /** Start a new segment of the log.
+     * @param [in] path The path of the log without the segment number.
+     * @param [in] segment_size We start a new segment before a record would make the
+     *             segment longer than this. Larger records get a segment on their own.
+     * @exception std::system_error if the segment file cannot be created.*/
+    explicit record_log_writer(std::string path, size_t segment_size = size_t(64) << 20);
+    record_log_writer(const record_log_writer &) = delete;
+    record_log_writer &operator=(const record_log_writer &) = delete;
+    /** Closes the log, see close(). Errors are ignored.*/
+    ~record_log_writer();
+    /** Append a record with a type and a serialized value. We do not check the value.
+     * @exception std::system_error on write errors.
+     * @exception uf::api_error if the log is closed or 'value' is larger than 4GB.*/
+    void append(std::string_view type, std::string_view value);
+    /** Append a record with the content of an any.*/
+    void append(const any_view &a) { append(a.type(), a.value()); }
+    /** Append a record by serializing a value.*/
+    template <typename T, typename ...tags>
+    void append_as(const T &t, use_tags_t = {}, tags... tt) { append(serialize_type<T, tags...>(), serialize(t, use_tags, tt...)); }
+    /** Write out all buffered entries. If 'sync' is set, we also wait until they are on the disk.
+     * @exception std::system_error on write errors.*/
+    void flush(bool sync = false);
+    /** Write the footer of the current segment and close it. Further appends throw.
+     * @exception std::system_error on write errors.*/
+    void close();
+    /** The number of the segment being written.*/
+    [[nodiscard]] unsigned segment() const noexcept { return _segment; }
+private:
+    const std::string _path;
+    const size_t _segment_size;
+    unsigned _segment = 0;
+    int _fd = -1;
+    uint64_t _written = 0;              ///<Bytes of the segment written to the file
+    std::string _buf;                   ///<Bytes of the segment not yet written
+    std::map<std::string, uint32_t, std::less<>> _type_ids;
+    std::vector<std::string> _types;    ///<The typestrings defined in the segment
+    std::vector<uint64_t> _offsets;     ///<The offsets of the records in the segment
+    void open_segment();
+    void close_segment();
+};
+
+/** Reads a log written by record_log_writer. We map all segment files of the log into
+ * memory and hand out any_views pointing into the mapping, so records are not copied
+ * (and pages are only read from the disk when accessed). Segments with a footer are
+ * indexed using it; others are scanned at open and a truncated last entry is ignored.
+ * The reader takes a snapshot at open, records appended later are not seen.*/
+class record_log_reader
+{
+public:
+    /** Map all segments of a log.
+     * @param [in] path The path of the log without the segment number.
+     * @exception std::system_error if a segment file cannot be mapped.
+     * @exception uf::value_mismatch_error if a segment is malformed.*/
+    explicit record_log_reader(std::string_view path);
+    record_log_reader(const record_log_reader &) = delete;
+    record_log_reader &operator=(const record_log_reader &) = delete;
+    /** The total number of records in the log.*/
+    [[nodiscard]] size_t size() const noexcept { return _first.empty() ? 0 : _first.back(); }
+    /** The number of segment files.*/
+    [[nodiscard]] size_t segments() const noexcept { return _segments.size(); }
+    /** Returns the i:th record without any check. 'i' must be less than size() and
+     * the value is not checked against its type (as with from_type_value_unchecked).*/
+    [[nodiscard]] any_view operator[](size_t i) const noexcept;
+    /** Returns the i:th record, after checking it.
+     * @exception std::out_of_range if 'i' is not less than size().
+     * @exception uf::value_mismatch_error if the record is malformed.*/
+    [[nodiscard]] any_view at(size_t i) const;
+    /** Call 'f' with all records (as any_view) in order. Records are not checked.*/
+    template <typename F>
+    void for_each(F &&f) const {
+        for (const segment &s : _segments)
+            for (uint64_t off : s.offsets)
+                f(record(s, off));
+    }
+private:
+    struct segment {
+        std::string file;
+        const char *data = nullptr;
+        size_t len = 0;
+        std::vector<std::string_view> types;
+        std::vector<uint64_t> offsets;
+        segment() = default;
+        segment(segment &&o) noexcept : file(std::move(o.file)), data(std::exchange(o.data, nullptr)), len(std::exchange(o.len, 0)),
+            types(std::move(o.types)), offsets(std::move(o.offsets)) {}
+        segment &operator=(segment &&) = delete;
+        ~segment();                     ///<Unmaps 'data'
+    };
+    std::vector<segment> _segments;
+    std::vector<size_t> _first;         ///<The total number of records in the segments up to and including each
+    static any_view record(const segment &s, uint64_t off) noexcept;
+    static void index(segment &s);
+    std::pair<const segment *, uint64_t> locate(size_t i) const noexcept;
+};
+#endif //_WIN32
+
+/** Encodes a stream of any values, sending each distinct typestring only once.
+ * Use with type_dict_decoder on the other end when both sides agreed to use it
+ * (per connection or per stream), instead of serializing the anys.
+ * The first time a typestring is seen, we emit a definition: 0xffffffff (4 bytes)
+ * followed by the length-prefixed typestring. It gets the next id, starting from
+ * zero. Each value is then emitted as the id of its type (4 bytes) followed by the
+ * length-prefixed serialized value. All integers are big-endian. This is the same
+ * framing as in the segments of record_log_writer.
+ * Only the top-level typestrings are replaced, values are kept as they are.*/
+class type_dict_encoder
+{
+public:
+    /** Append the encoding of 'a' to 'to'.
+     * @exception uf::api_error if the value is longer than 4GB or if we have too many types.*/
+    void encode(std::string &to, const any_view &a);
+    /** Returns the encoding of 'a'.*/
+    [[nodiscard]] std::string encode(const any_view &a) { std::string ret; encode(ret, a); return ret; }
+    /** Forget all typestrings sent, e.g., when the peer reconnects.*/
+    void reset() noexcept { _ids.clear(); }
+    /** The number of distinct typestrings sent.*/
+    [[nodiscard]] size_t types() const noexcept { return _ids.size(); }
+private:
+    std::unordered_map<std::string_view, uint32_t> _ids; ///<Keys are interned typestrings
+};
+
+/** Decodes a stream encoded by type_dict_encoder into any_views.
+ * The typestrings of the returned any_views are stored in the decoder and remain
+ * valid until it is reset or destroyed. Values of the same type id share the same
+ * typestring pointer. Their values point into the data decoded.*/
+class type_dict_decoder
+{
+public:
+    /** @param [in] check If set, we check that each value matches its type.*/
+    explicit type_dict_decoder(bool check = true) noexcept : _check(check) {}
+    /** Decode the next value from the front of 'data' and remove it from 'data'.
+     * Type definitions are consumed and remembered.
+     * @returns the value, or nullopt if 'data' does not contain a whole value
+     *          (a partially received definition or value is left in 'data').
+     * @exception uf::value_mismatch_error if the data is malformed (an undefined
+     *            type id) or with 'check', when a value does not match its type.
+     * @exception uf::typestring_error with 'check', if a typestring is invalid.*/
+    std::optional<any_view> decode(std::string_view &data);
+    /** Forget all typestrings received, e.g., when the peer reconnects.
+     * any_views returned earlier become invalid.*/
+    void reset() noexcept { _types.clear(); }
+private:
+    const bool _check;
+    std::deque<std::string> _types;
+};
+
+/** A serialized value kept in compressed form, for large values sent over slow links.
+ * Construct it from an any_view (or any serializable value): values whose serialized
+ * size reaches 'threshold' are compressed, smaller ones (or ones that do not shrink)
+ * are stored as they are. The class is itself serializable as a 't4csis' tuple of
+ * <codec, typestring, uncompressed length, payload>, so it can be a member of any
+ * struct, be placed in a uf::any and is checked by serialize_scan_by_type() like any
+ * other tuple (the payload is not looked into). Codecs are 0 for stored and 1 for
+ * zlib (deflate). Compression needs zlib when building the library, without it all
+ * values are stored and decompressing a compressed value throws uf::api_error.
+ * The value is decompressed only when accessed via view() or get_as(). The calling
+ * thread keeps the last decompressed value, so repeated accesses of the same object
+ * from the same thread reuse the decompressed bytes.*/
+class compressed_any
+{
+public:
+    /** The payload is stored as is.*/
+    static constexpr char codec_stored = 0;
+    /** The payload is zlib compressed.*/
+    static constexpr char codec_zlib = 1;
+    /** Values shorter than this are stored uncompressed by default.*/
+    static constexpr size_t default_threshold = 1024;
+    /** The most a zlib payload can expand: deflate cannot exceed about 1032:1, longer claimed
+     * uncompressed lengths are rejected at deserialization (and so never allocated).*/
+    static constexpr size_t max_zlib_ratio = 1032;
+    /** An any_view of the value that keeps the decompressed bytes alive as long as it
+     * (or a copy of it) exists. An any_view sliced from it is valid only as long as this
+     * is, or until the thread decompresses another value.*/
+    class view_type : public any_view
+    {
+        friend class compressed_any;
+        std::shared_ptr<const std::string> _keep;
+        view_type(const any_view &v, std::shared_ptr<const std::string> keep) noexcept : any_view(v), _keep(std::move(keep)) {}
+    };
+    /** An empty (void) value.*/
+    compressed_any() noexcept = default;
+    /** Compress the content of 'a'.
+     * @param [in] a The value to compress.
+     * @param [in] threshold Values serialized to fewer bytes than this are stored uncompressed.
+     * @param [in] level The compression level from 1 (fastest) to 9 (smallest), -1 for the codec default.
+     * @exception uf::api_error if the value is longer than 4GB.*/
+    explicit compressed_any(const any_view &a, size_t threshold = default_threshold, int level = -1);
+    explicit compressed_any(const any &a, size_t threshold = default_threshold, int level = -1) :
+        compressed_any(any_view(a), threshold, level) {}
+    /** Serialize and compress a C++ value.*/
+    template <typename T, typename ...tags> requires (!std::is_base_of_v<any_view, T> && !std::is_same_v<T, any> && !std::is_same_v<T, compressed_any>)
+    explicit compressed_any(const T &t, size_t threshold = default_threshold, int level = -1, use_tags_t = {}, tags... tt) :
+        compressed_any(any(t, use_tags, tt...), threshold, level) {}
+    /** The typestring of the value.*/
+    [[nodiscard]] std::string_view type() const noexcept { return _type; }
+    /** True if the payload is compressed.*/
+    [[nodiscard]] bool compressed() const noexcept { return _codec != codec_stored; }
+    /** The codec used for the payload.*/
+    [[nodiscard]] char codec() const noexcept { return _codec; }
+    /** The length of the serialized value when decompressed.*/
+    [[nodiscard]] size_t size() const noexcept { return _len; }
+    /** The length of the payload as stored (and sent).*/
+    [[nodiscard]] size_t stored_size() const noexcept { return _data.size(); }
+    /** Returns the value. If compressed, it is decompressed (unless the calling thread
+     * holds this value already) and the returned view keeps the decompressed bytes alive.
+     * Views of several compressed_any objects can be used together. For stored values it
+     * points into this object and is valid until this object changes.
+     * @exception uf::value_mismatch_error if the payload cannot be decompressed.
+     * @exception uf::api_error if the codec is unknown or not built in.*/
+    [[nodiscard]] view_type view() const;
+    /** Returns a uf::any owning a (decompressed) copy of the value.*/
+    [[nodiscard]] any to_any() const { return any(view()); }
+    /** Decompress the value (if needed) and deserialize it into a T.*/
+    template <typename T, typename ...tags>
+    [[nodiscard]] T get_as(serpolicy policy = allow_converting_all, use_tags_t = {}, tags... tt) const {
+        return view().get_as<T>(policy, use_tags, tt...);
+    }
+    auto tuple_for_serialization() const noexcept { return std::tie(_codec, _type, _len, _data); }
+    auto tuple_for_serialization() noexcept { _id = 0; return std::tie(_codec, _type, _len, _data); }
+    /** Checks the codec and the lengths and assigns a new identity.*/
+    void after_deserialization_simple();
+private:
+    char _codec = codec_stored;
+    std::string _type;
+    uint32_t _len = 0;                  ///<The uncompressed length
+    std::string _data;                  ///<The payload
+    uint64_t _id = 0;                   ///<Identifies a compressed content for the per-thread cache, 0 if none
+};
+
+/** Splits a byte stream into frames, each a 4-byte big-endian length followed by that
+ * many bytes of a serialized uf::any (as produced by frame_writer or by serializing
+ * an any), and hands them out as any_views.
+ * The caller (or async_next()) reads from the transport directly into our buffer
+ * (see buffer() and commit()), so one read may bring several frames and all of them
+ * can be processed via next() without further copying. The buffer is kept and reused.
+ * An any_view returned by next() points into the buffer and is valid until the next
+ * call to buffer() (or to async_next() if it has to read). Use get_view_as() on it to
+ * deserialize into string_views without copying.*/
+class frame_reader
+{
+public:
+    /** @param [in] max_frame Frames longer than this are rejected as malformed.
+     * @param [in] check If set, we check that frames are valid serialized anys.*/
+    explicit frame_reader(size_t max_frame = size_t(64) << 20, bool check = true) noexcept :
+        _max_frame(max_frame), _check(check) {}
+    /** Returns the free space at the end of the buffer to read into: at least 'min' bytes
+     * and if a frame is partially received, enough for the rest of it.
+     * Moves the unprocessed bytes to the front of the buffer, so it invalidates the
+     * any_views returned earlier.
+     * @exception uf::value_mismatch_error if the frame in progress is longer than the limit.*/
+    [[nodiscard]] std::span<char> buffer(size_t min = 16384);
+    /** Marks the first 'n' bytes of the last buffer() as received.*/
+    void commit(size_t n) noexcept { assert(_end + n <= _buf.size()); _end += n; }
+    /** Returns the next complete frame, or nullopt if more bytes are needed.
+     * @exception uf::value_mismatch_error if the frame is longer than the limit or
+     *            (if we check) it is not a valid serialized any.*/
+    [[nodiscard]] std::optional<any_view> next();
+    /** The number of bytes received but not yet returned as a frame.*/
+    [[nodiscard]] size_t buffered() const noexcept { return _end - _start; }
+    /** Returns the next frame, reading from the transport as needed.
+     * This is a coroutine of your choice of task type. 'read' is called with a span to
+     * fill and must return an awaitable that yields the number of bytes read
+     * (0 at the end of the stream), e.g., an async socket read of asio or io_uring.
+     * @returns the next frame or nullopt at the end of the stream.
+     * @exception uf::value_mismatch_error if the stream ends inside a frame or a frame
+     *            is malformed. Exceptions of 'read' are propagated.*/
+    template <template <typename> class Task, typename Read>
+    Task<std::optional<any_view>> async_next(Read read) {
+        for (;;) {
+            if (std::optional<any_view> f = next()) co_return f;
+            const size_t n = co_await read(buffer());
+            if (n == 0) {
+                if (buffered())
+                    throw value_mismatch_error(uf::concat("Stream ended inside a frame (", buffered(), " bytes)."));
+                co_return std::nullopt;
+            }
+            commit(n);
+        }
+    }
+private:
+    /** The length of the frame at _start, which must have its 4-byte prefix received.
+     * @exception uf::value_mismatch_error if it is longer than the limit.*/
+    size_t frame_length() const;
+    const size_t _max_frame;
+    const bool _check;
+    std::vector<char> _buf;
+    size_t _start = 0;                  ///<The first byte not yet returned as a frame
+    size_t _end = 0;                    ///<The end of the received bytes
+};
+
+/** Collects frames (see frame_reader) to send and hands them out to be written
+ * together, e.g., with a single writev(). Values are serialized directly into a ring
+ * buffer: pending bytes occupy at most two regions of it (the older one at the back
+ * and the newer one at the front after a wrap-around), so they are written in at most
+ * two segments. The buffer grows only when the pending bytes do not fit, hence in
+ * steady state writing frames makes no allocation.*/
+class frame_writer
+{
+public:
+    /** @param [in] capacity The initial size of the ring buffer.*/
+    explicit frame_writer(size_t capacity = 65536) : _buf(capacity) {}
+    /** Append a frame with the serialized form of 't' (as a uf::any).
+     * If serialization throws, nothing is appended.
+     * @exception uf::api_error if the frame would be longer than 4GB.*/
+    template <typename T, typename ...tags>
+    void write(const T &t, use_tags_t = {}, tags... tt) {
+        using type = typename std::remove_cvref_t<T>;
+        static_assert(uf::impl::is_serializable_f<T, true, tags...>(), "Type must be serializable.");
+        if constexpr (std::is_base_of_v<any_view, type>)
+            write_any(t.type(), t.value());
+        else if constexpr (uf::impl::is_serializable_f<T, false, tags...>()) {
+            if constexpr (impl::has_before_serialization_inside_v<type, tags...>)
+                if (auto r = impl::call_before_serialization(&t, tt...); r.obj)
+                    impl::call_after_serialization(&t, r, tt...); //This shall throw
+            const size_t before = pending();
+            try {
+                char *p = frame(serialize_type<T, tags...>(), impl::serialize_len(t, tt...));
+                impl::serialize_to(t, p, tt...);
+                if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                    impl::call_after_serialization(&t, true, tt...);
+            } catch (...) {
+                truncate(before);
+                if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                    impl::call_after_serialization(&t, false, tt...);
+                throw;
+            }
+        }
+    }
+    /** The bytes waiting to be written, in at most two segments.*/
+    [[nodiscard]] std::span<const std::string_view> segments() noexcept {
+        _segs[0] = {_buf.data() + _a_start, _a_end - _a_start};
+        _segs[1] = {_buf.data(), _b_end};
+        return {_segs.data(), _a_end == _a_start ? 0u : _b_end ? 2u : 1u};
+    }
+    /** Drops the first 'n' pending bytes, after they were written.*/
+    void consume(size_t n) noexcept;
+    /** The number of bytes waiting to be written.*/
+    [[nodiscard]] size_t pending() const noexcept { return _a_end - _a_start + _b_end; }
+    /** The size of the ring buffer.*/
+    [[nodiscard]] size_t capacity() const noexcept { return _buf.size(); }
+    /** Writes all pending bytes to the transport.
+     * This is a coroutine of your choice of task type. 'writev' is called with the
+     * segments to write (a span of string_views) and must return an awaitable that
+     * yields the number of bytes written (may be less than the total).
+     * @exception uf::api_error if 'writev' writes nothing.
+     * Exceptions of 'writev' are propagated.*/
+    template <template <typename> class Task, typename Writev>
+    Task<void> async_flush(Writev writev) {
+        while (pending()) {
+            const size_t n = co_await writev(segments());
+            if (n == 0) throw api_error("frame_writer: the transport wrote nothing.");
+            consume(n);
+        }
+    }
+private:
+    std::vector<char> _buf;
+    size_t _a_start = 0, _a_end = 0;    ///<The older region of pending bytes
+    size_t _b_end = 0;                  ///<The newer region [0, _b_end) after a wrap-around, empty if zero
+    std::array<std::string_view, 2> _segs;
+    /** Drop the bytes appended after there were 'n' pending (they are at the end of the newer region).*/
+    void truncate(size_t n) noexcept { (_b_end ? _b_end : _a_end) -= pending() - n; }
+    /** Reserve 'n' contiguous bytes at the end of the pending ones.*/
+    char *allocate(size_t n);
+    /** Reserve a frame for a value of 'type' and 'len' bytes. Returns where the value goes.*/
+    char *frame(std::string_view type, size_t len);
+    void write_any(std::string_view type, std::string_view value);
+};
+
 /** @} */
 
 /** @addtogroup serialization
@@ -4844,20 +6234,25 @@ impl::deserialize_from(const char *&p, const char *end, uf::expected<T> &o, tags
             return impl::deserialize_from<view>(p, end, *o, tt...);
     } else {
         error_value e;
-        if (impl::deserialize_from<false>(p, end, e)) return true;
+        if (impl::deserialize_from<false>(p, end, e, tt...)) return true;
         o.set_error(std::move(e));
     }
     return false;
 }
 
 inline bool any_view::converts_to(std::string_view t, serpolicy policy) const {
-    return !uf::cant_convert(_type, t, policy, _value);
+    impl::quiet_conversion_errors_scope quiet;
+    auto err = uf::cant_convert(_type, t, policy, _value);
+    const bool ret = !err;
+    impl::recycle_quiet_error(std::move(err));
+    impl::stat_add(ret ? stat_event::converts_to : stat_event::converts_to_failed, _type, t);
+    return ret;
 }
 
 template <typename T, typename ...tags>
 inline bool any_view::converts_to(serpolicy policy, use_tags_t, tags...) const {
     static_assert(uf::impl::is_deserializable_f<T, true, true, tags...>(), "Type must be possible to deserializable into.");
-    return !uf::cant_convert(_type, deserialize_type<T, tags...>(), policy, _value);
+    return converts_to(deserialize_type<T, tags...>(), policy);
 }
 
 
@@ -5019,8 +6414,8 @@ template<bool view, typename ...tags>
 inline std::unique_ptr<value_error> deserialize_convert_from_helper(bool &can_disappear, deserialize_convert_params &p, long double &o, tags...)
 { double d; auto ret = deserialize_convert_from_helper<view>(can_disappear, p, d); o = d; return ret;}
 
-template<bool, typename ...tags>
-inline std::unique_ptr<value_error> deserialize_convert_from_helper(bool &can_disappear, deserialize_convert_params &p, std::string &s, tags...) {
+template<bool, typename A, typename ...tags>
+inline std::unique_ptr<value_error> deserialize_convert_from_helper(bool &can_disappear, deserialize_convert_params &p, std::basic_string<char, std::char_traits<char>, A> &s, tags...) {
     can_disappear = false;
     //allow conversion from 'lc'
     if (*p.type == 'l' && p.type + 1 < p.tend && p.type[1] == 'c') {
@@ -5721,7 +7116,7 @@ inline std::unique_ptr<value_error> deserialize_convert_from(bool &can_disappear
                         p.target_type += otypestr.size();
                         return {};
                     } else {
-                        typename deserializable_value_type<T>::type e;
+                        typename deserializable_value_type<T>::type e = make_container_element(o);
                         if constexpr (has_reserve_member<T>::value) o.reserve(size);
                         const char* original_type = p.type, *original_target_type = p.target_type+1; //+1 step over 'l' in target type
                         can_disappear = true;
@@ -5756,7 +7151,7 @@ inline std::unique_ptr<value_error> deserialize_convert_from(bool &can_disappear
                         //We dont check if they are compatible with T::value_type
                         p.target_type += otypestr.size();
                     } else {
-                        std::pair<typename T::key_type, typename T::mapped_type> e;
+                        std::pair<typename T::key_type, typename T::mapped_type> e = make_container_element(o);
                         const char* original_type = p.type, *original_target_type = p.target_type+1; //+1 step over 'm' in target type
                         while (size--) {
                             p.type = original_type;
@@ -5794,7 +7189,7 @@ inline std::unique_ptr<value_error> deserialize_convert_from(bool &can_disappear
                         //Create a copy, where tend is replaced by end_of_incoming and target type is
                         //replaced to the list's type
                         deserialize_convert_params local_p(p, end_of_incoming, p.target_type+otypestr.size());
-                        typename deserializable_value_type<T>::type key;
+                        typename deserializable_value_type<T>::type key = make_container_element(o);
                         if constexpr (has_reserve_member<T>::value) o.reserve(size);
                         std::monostate t;
                         while (size--) {
@@ -5836,7 +7231,7 @@ inline std::unique_ptr<value_error> deserialize_convert_from(bool &can_disappear
                         //Create a copy, where tend is replaced by end_of_incoming.
                         //We dont want to ready beyond the incoming tuple's type
                         deserialize_convert_params local_p(p, end_of_incoming, p.target_tend);
-                        typename deserializable_value_type<T>::type e;
+                        typename deserializable_value_type<T>::type e = make_container_element(o);
                         o.clear();
                         if constexpr (has_reserve_member<T>::value) o.reserve(size);
                         const char* const original_target_type = local_p.target_type+1; //+1 step over 'l' in target type
@@ -6114,31 +7509,31 @@ template <typename ...tags>
 inline bool serialize_print_append(std::string &to, bool json_like, unsigned max_len, const char &c, std::string_view chars, char escape_char, tags... tt)
 { to.push_back(json_like ? '\"' : '\''); print_escaped_to(to, max_len, std::string_view(&c,1), chars, escape_char); to.push_back(json_like ? '\"' : '\''); return false;}
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const uint16_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(std::to_string(unsigned(i))); return false; }
+inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const uint16_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_integer_to(to, unsigned(i)); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const int16_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(std::to_string(int(i))); return false; }
+inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const int16_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_integer_to(to, int(i)); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const uint32_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(std::to_string(i)); return false; }
+inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const uint32_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_integer_to(to, i); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const int32_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(std::to_string(i)); return false; }
+inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const int32_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_integer_to(to, i); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const uint64_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(std::to_string(i)); return false; }
+inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const uint64_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_integer_to(to, i); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const int64_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(std::to_string(i)); return false; }
+inline bool serialize_print_append(std::string &to, bool /*json_like*/, unsigned /*max_len*/, const int64_t &i, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_integer_to(to, i); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool json_like, unsigned /*max_len*/, const float &d, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(print_floating_point(d, json_like)); return false; }
+inline bool serialize_print_append(std::string &to, bool json_like, unsigned /*max_len*/, const float &d, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_floating_point_to(to, d, json_like); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool json_like, unsigned /*max_len*/, const double &d, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(print_floating_point(d, json_like)); return false; }
+inline bool serialize_print_append(std::string &to, bool json_like, unsigned /*max_len*/, const double &d, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_floating_point_to(to, d, json_like); return false; }
 template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool json_like, unsigned /*max_len*/, const long double &d, std::string_view /*chars*/, char /*escape_char*/, tags...) { to.append(print_floating_point(d, json_like)); return false; }
+inline bool serialize_print_append(std::string &to, bool json_like, unsigned /*max_len*/, const long double &d, std::string_view /*chars*/, char /*escape_char*/, tags...) { print_floating_point_to(to, d, json_like); return false; }
 template <typename ...tags>
 inline bool serialize_print_append(std::string &to, bool json_like, unsigned max_len, const std::string_view &s, std::string_view chars, char escape_char, tags...)
 { to.reserve(to.length()+s.length()+2); to.push_back('\"');
 if (json_like) {if (print_escaped_to(to, max_len, s, chars, escape_char)) return true; }
 else if (print_escaped_to(to, max_len, print_escaped_json_string(s), chars, escape_char)) return true;
 to.push_back('\"'); return false;}
-template <typename ...tags>
-inline bool serialize_print_append(std::string &to, bool json_like, unsigned max_len, const std::string &s, std::string_view chars, char escape_char, tags...)
+template <typename A, typename ...tags>
+inline bool serialize_print_append(std::string &to, bool json_like, unsigned max_len, const std::basic_string<char, std::char_traits<char>, A> &s, std::string_view chars, char escape_char, tags...)
 { to.reserve(to.length()+s.length()+2); to.push_back('\"');
 if (json_like) {if (print_escaped_to(to, max_len, s, chars, escape_char)) return true; }
 else if (print_escaped_to(to, max_len, print_escaped_json_string(s), chars, escape_char)) return true;
@@ -6177,7 +7572,7 @@ inline bool serialize_print_append(std::string &to, bool json_like, unsigned max
 template <typename E, typename ...tags> //enum
 inline typename std::enable_if_t<std::is_enum<E>::value, bool>
 serialize_print_append(std::string &to, bool json_like, unsigned max_len, const E &e, std::string_view /*chars*/, char /*escape_char*/, tags...)
-{ if (!json_like) to.append("Enum("); to.append(std::to_string(size_t(e))); if (!json_like) to.push_back(')'); return max_len && to.length()>max_len;}
+{ if (!json_like) to.append("Enum("); print_integer_to(to, size_t(e)); if (!json_like) to.push_back(')'); return max_len && to.length()>max_len;}
 template <typename C, typename ...tags> //containers/ranges with begin() end()
 inline typename std::enable_if_t<is_serializable_container<C>::value && !is_map_container<C>::value && !has_tuple_for_serialization<false, C, tags...>::value, bool>
 serialize_print_append(std::string &to, bool json_like, unsigned max_len, const C &c, std::string_view chars, char escape_char, tags... tt) {
@@ -6364,18 +7759,25 @@ inline int hex_digit(unsigned char c) noexcept
  * @param [in] escape_char What was the escape char when printed.*/
 inline void parse_escaped_string_to(std::string &to, std::string_view value, char escape_char = '%')
 {
-    while (value.length())
-        if (value.front()==escape_char && value.length()>2 && hex_digit(value[1])>=0 && hex_digit(value[2])>=0) {
+    //Copy runs between escape chars in bulk, most strings have none.
+    for (size_t pos; (pos = value.find(escape_char)) != std::string_view::npos; ) {
+        to.append(value.substr(0, pos));
+        value.remove_prefix(pos);
+        if (value.length()>2 && hex_digit(value[1])>=0 && hex_digit(value[2])>=0) {
             to.push_back(hex_digit(value[1])*16 + hex_digit(value[2]));
             value.remove_prefix(3);
         } else {
             to.push_back(value.front());
             value.remove_prefix(1);
         }
+    }
+    to.append(value);
 }
 
 inline void skip_whitespace(std::string_view &value)
 {
+    if (value.empty() || (value.front()!=' ' && value.front()!='\t' && value.front()!='\n' && value.front()!='\r'))
+        return; //fast path: no whitespace
     if (auto p = value.find_first_not_of(" \t\n\r"); p==std::string_view::npos)
         value = {value.data(), 0}; //all whitespace or already empty. Keep head pointer though.
     else
@@ -6402,6 +7804,41 @@ inline any::any(from_text_t, std::string_view v, bool json_like)
     _value = std::string_view(_storage).substr(0, _storage.size()-t.size());
 }
 
+/** Creates an 'any' of a given type from a textual description.
+ * This is faster than any(from_text, text).convert_to(type), since the text
+ * is parsed directly into 'type' without intermediate 'any' values.
+ * @param [in] type The type of the resulting value.
+ * @param [in] text The textual description. Whitespace may follow, but nothing else.
+ * @param [in] json_like If true, we parse JSON (see any(from_text_t, ...)).
+ * @exception uf::typestring_error if 'type' is invalid.
+ * @exception uf::value_mismatch_error if the text cannot be parsed or converted to 'type'.*/
+[[nodiscard]] inline any parse_text_as(std::string_view type, std::string_view text, bool json_like = false) {
+    if (auto [len, problem] = impl::parse_type(type, true); !!problem)
+        throw typestring_error(uf::concat(impl::ser_error_str(problem), " <%1>"), type, len);
+    else if (len < type.size())
+        throw typestring_error(uf::concat(impl::ser_error_str(impl::ser::tlong), " <%1>"), type, len);
+    std::string value;
+    std::string_view v = text, t = type;
+    auto err = impl::parse_value_as(value, v, t, json_like ? impl::ParseMode::JSON_Loose : impl::ParseMode::Liberal);
+    if (!err) {
+        impl::skip_whitespace(v);
+        if (v.size()) err = "Extra characters after the value.";
+    }
+    if (err)
+        throw value_mismatch_error(uf::concat("Error parsing text: '", text.substr(0, v.data() - text.data()),
+                                              '*', v, "': ", *err));
+    return any(from_type_value_unchecked, std::string(type), std::move(value));
+}
+
+/** Parses a textual description directly into a C++ type.
+ * @param [in] text The textual description.
+ * @param [in] json_like If true, we parse JSON (see any(from_text_t, ...)).
+ * @exception uf::value_mismatch_error if the text cannot be parsed or converted to T.*/
+template <typename T>
+[[nodiscard]] T parse_text_as(std::string_view text, bool json_like = false) {
+    return parse_text_as(serialize_type<T>(), text, json_like).template get_as<T>();
+}
+
 namespace impl
 {
 
@@ -6515,6 +7952,193 @@ inline constexpr bool is_deser_ok_v = uf::impl::is_deserializable_f<T, false, tr
 template <typename T, typename ...tags>
 inline constexpr bool is_deser_view_ok_v = uf::impl::is_deserializable_f<T, true, true, tags...>() || true;
 
+/** A growable output buffer for single-pass serialization.
+ * uf::serialize(serialize_sink&, t) writes the serialized form of 't' into this buffer
+ * without a separate serialize_len() pass over 't': the buffer grows geometrically
+ * and list/map counts are back-patched once the elements are written.
+ * This way tuple_for_serialization() is called only once per object and node based
+ * containers are walked only once.
+ * The buffer is kept between calls (clear() does not free), so re-using the same sink
+ * results in no allocation in steady state.*/
+class serialize_sink
+{
+    std::string _buf; ///<The storage. Its size() is our capacity.
+    size_t _len = 0;  ///<The number of bytes written so far.
+public:
+    serialize_sink() noexcept = default;
+    /** Create a sink with 'reserve' bytes pre-allocated. */
+    explicit serialize_sink(size_t reserve) : _buf(reserve, char(0)) {}
+    serialize_sink(const serialize_sink &) = default;
+    serialize_sink(serialize_sink &&o) noexcept : _buf(std::move(o._buf)), _len(std::exchange(o._len, 0)) {}
+    serialize_sink &operator=(const serialize_sink &) = default;
+    serialize_sink &operator=(serialize_sink &&o) noexcept { _buf = std::move(o._buf); _len = std::exchange(o._len, 0); return *this; }
+    /** Forget the content, but keep the allocated memory. */
+    void clear() noexcept { _len = 0; }
+    [[nodiscard]] size_t size() const noexcept { return _len; }
+    [[nodiscard]] size_t capacity() const noexcept { return _buf.size(); }
+    [[nodiscard]] bool empty() const noexcept { return _len == 0; }
+    /** The bytes written so far. Valid until the next modification of the sink.*/
+    [[nodiscard]] std::string_view view() const noexcept { return {_buf.data(), _len}; }
+    /** Move the content out as a string. The sink becomes empty and loses its memory.*/
+    [[nodiscard]] std::string release() { _buf.resize(_len); _len = 0; std::string ret = std::move(_buf); _buf.clear(); return ret; }
+    /** Extend the content by 'n' (uninitialized) bytes and return a pointer to them.
+     * The pointer is valid until the next append().*/
+    [[nodiscard]] char *append(size_t n) {
+        if (_len + n > _buf.size()) [[unlikely]] grow(n);
+        char *p = _buf.data() + _len;
+        _len += n;
+        return p;
+    }
+    /** Return a pointer to already written byte at 'pos'. Use for back-patching.*/
+    [[nodiscard]] char *at(size_t pos) noexcept { assert(pos <= _len); return _buf.data() + pos; }
+private:
+    ATTR_NOINLINE__ void grow(size_t n) { _buf.resize(std::max(_len + n, std::max<size_t>(_buf.size() * 2, 64))); }
+};
+
+class serialized_iov;
+template <typename T, typename ...tags>
+inline serialized_iov serialize_iov(const T &t, size_t threshold = 4096, uf::use_tags_t = {}, tags... tt);
+namespace impl {
+inline serialize_sink &sink_arena(serialize_sink &s) noexcept { return s; }
+inline serialize_sink &sink_arena(serialized_iov &s) noexcept;
+template <typename S> constexpr bool is_sink_v = std::is_same_v<S, serialize_sink> || std::is_same_v<S, serialized_iov>;
+} //ns impl
+
+/** The result of uf::serialize_iov(): the serialized form of a value as a sequence of
+ * segments (like an iovec array for writev()/sendmsg()). Small fields are packed into
+ * an internal header arena, whereas long strings, any values and lists of chars or
+ * doubles are referenced in place in the serialized object.
+ * Thus the serialized object must not be changed or destroyed while the segments are in use.
+ * If the serialized type has after_serialization(), it is called only when this object is
+ * destroyed or release() is called, so that any lock taken in before_serialization() is
+ * held while the segments reference the object.
+ * Moveable, but not copyable.*/
+class serialized_iov
+{
+    friend serialize_sink &impl::sink_arena(serialized_iov &s) noexcept;
+    template <typename T, typename ...tags> friend serialized_iov serialize_iov(const T &, size_t, uf::use_tags_t, tags...);
+    struct ref { size_t pos; const char *data; size_t len; }; ///<External bytes to insert after head byte 'pos'.
+    serialize_sink _head;
+    std::vector<ref> _refs;
+    size_t _threshold = 0;
+    std::function<void()> _after;
+public:
+    explicit serialized_iov(size_t threshold = 0) noexcept : _threshold(threshold) {}
+    serialized_iov(const serialized_iov &) = delete;
+    serialized_iov(serialized_iov &&o) noexcept : _head(std::move(o._head)), _refs(std::move(o._refs)), _threshold(o._threshold), _after(std::move(o._after)) { o._after = nullptr; }
+    serialized_iov &operator=(const serialized_iov &) = delete;
+    serialized_iov &operator=(serialized_iov &&o) noexcept {
+        if (this != &o) { release_noexcept(); _head = std::move(o._head); _refs = std::move(o._refs); _threshold = o._threshold; _after = std::move(o._after); o._after = nullptr; }
+        return *this;
+    }
+    ~serialized_iov() { release_noexcept(); }
+    /** Strings at least this long are referenced instead of copied. */
+    [[nodiscard]] size_t threshold() const noexcept { return _threshold; }
+    /** Reference 'len' bytes at 'data' at the current end of the header arena. */
+    void reference(const char *data, size_t len) { _refs.push_back({_head.size(), data, len}); }
+    /** Total number of serialized bytes. */
+    [[nodiscard]] size_t size() const noexcept { size_t ret = _head.size(); for (auto &r : _refs) ret += r.len; return ret; }
+    /** Return the segments in order. Empty segments are omitted. The views remain valid as long as
+     * this object is not modified (moving it is OK) and the serialized object is not changed.*/
+    [[nodiscard]] std::vector<std::string_view> segments() const {
+        std::vector<std::string_view> ret;
+        ret.reserve(_refs.size() * 2 + 1);
+        const std::string_view head = _head.view();
+        size_t pos = 0;
+        for (auto &r : _refs) {
+            if (r.pos > pos) ret.push_back(head.substr(pos, r.pos - pos));
+            if (r.len) ret.emplace_back(r.data, r.len);
+            pos = r.pos;
+        }
+        if (pos < head.size()) ret.push_back(head.substr(pos));
+        return ret;
+    }
+    /** Copies all segments into a single string. Same as what uf::serialize() would return.*/
+    [[nodiscard]] std::string flatten() const {
+        std::string ret;
+        ret.reserve(size());
+        for (std::string_view s : segments()) ret.append(s);
+        return ret;
+    }
+    /** Calls after_serialization() of the serialized object (if any) and drops all segments.
+     * @exception any exception thrown by a tuple_for_serialization() when we walk the object
+     *            for the after_serialization() calls. The segments are dropped nevertheless.*/
+    void release() {
+        std::function<void()> a = std::move(_after);
+        _after = nullptr;
+        _head.clear();
+        _refs.clear();
+        if (a) a();
+    }
+private:
+    //The destructor and the move assignment cannot report an error, so there we swallow it.
+    //It can only come from a tuple_for_serialization() that throws only in the after_serialization
+    //pass, in which case we cannot call the remaining after_serialization()s anyway.
+    void release_noexcept() noexcept { try { release(); } catch (...) {} }
+};
+
+namespace impl {
+
+inline serialize_sink &sink_arena(serialized_iov &s) noexcept { return s._head; }
+
+/** Serialize 't' to the end of a sink (serialize_sink or serialized_iov) in a single pass.
+ * Compound types are walked here; for leaf types (primitives, strings, bulk lists)
+ * we use the (cheap) serialize_len() to grow the buffer and then the usual serialize_to().
+ * Does not call before/after serialization.*/
+template <typename T, typename Sink, typename ...tags> requires is_sink_v<Sink>
+void serialize_to(const T &t, Sink &sink, tags... tt) {
+    using type = std::remove_cvref_t<T>;
+    serialize_sink &s = sink_arena(sink);
+    if constexpr (is_void_like<false, type, tags...>::value) return;
+    else if constexpr (is_fixed_len_v<type>) {
+        char *p = s.append(serialize_len(t, tt...));
+        serialize_to(t, p, tt...);
+    } else if constexpr (has_tuple_for_serialization<false, type, tags...>::value)
+        serialize_to(invoke_tuple_for_serialization(t, tt...), sink, tt...);
+#ifdef HAVE_BOOST_PFR
+    else if constexpr (is_really_auto_serializable_v<type>)
+        serialize_to(boost::pfr::structure_tie(t), sink, tt...);
+#endif
+    else if constexpr (is_bulk_serializable_container<type>::value || std::is_same_v<type, std::vector<bool>>
+                       || is_char_array<type>::value || std::is_same_v<std::decay_t<type>, const char*> || std::is_same_v<std::decay_t<type>, char*>) {
+        if constexpr (std::is_same_v<Sink, serialized_iov> && is_bulk_serializable_container<type>::value) {
+            using E = std::remove_cv_t<std::remove_pointer_t<decltype(t.data())>>;
+            if constexpr (is_bulk_memcpy_v<E, is_little_endian_v<tags...>>) //no byte-swap needed: reference in place
+                if (t.size() * sizeof(E) >= sink.threshold()) {
+                    char *p = s.append(4);
+                    serialize_to(uint32_t(t.size()), p, tt...);
+                    sink.reference(reinterpret_cast<const char *>(t.data()), t.size() * sizeof(E));
+                    return;
+                }
+        }
+        char *p = s.append(serialize_len(t, tt...));
+        serialize_to(t, p, tt...);
+    } else if constexpr (is_pair<type>::value || is_tuple<type>::value)
+        std::apply([&sink, &tt...](auto const &...e) { (serialize_to(e, sink, tt...), ...); }, t);
+    else if constexpr (is_std_array<type>::value || is_C_array<type>::value)
+        for (auto const &e : t) serialize_to(e, sink, tt...);
+    else if constexpr (is_serializable_container<type>::value) {
+        const size_t pos = s.size();
+        (void)s.append(4);
+        uint32_t num = 0;
+        for (auto const &e : t) { serialize_to(e, sink, tt...); num++; }
+        char *p = s.at(pos);
+        serialize_to(num, p, tt...);
+    } else if constexpr (is_optional<type>::value || is_smart_ptr<type>::value || std::is_pointer_v<type>) {
+        *s.append(1) = bool(t);
+        if (t) serialize_to(*t, sink, tt...);
+    } else if constexpr (is_expected<type>::value) {
+        *s.append(1) = t.has_value();
+        if (!t.has_value()) serialize_to(t.error(), sink, tt...);
+        else if constexpr (!is_void_like<false, typename type::value_type>::value) serialize_to(*t, sink, tt...);
+    } else {
+        char *p = s.append(serialize_len(t, tt...));
+        serialize_to(t, p, tt...);
+    }
+}
+
+} //ns impl
+
 /** Serialize a C++ variable of arbitrary type to a bytearray */
 template <typename T, typename ...tags>
 inline std::string serialize(const T &t, uf::use_tags_t = {}, tags... tt) {
@@ -6542,7 +8166,7 @@ inline std::string serialize(const T &t, uf::use_tags_t = {}, tags... tt) {
 
 
 /** Serialize a C++ variable of arbitrary type to a user-allocated area.
- * This function handes calling before/after serialization.
+ * This function handles calling before/after serialization.
  * On any exception, if the memory has been allocated, it will remain allocated.
  * @param [in] t The variable to serlialize
  * @param [in] alloc A char*(size_t) function taking the length and returning a char
@@ -6582,6 +8206,208 @@ inline std::pair<char*, size_t> serialize(Alloc alloc, const T &t, uf::use_tags_
         return {};
 }
 
+/** Serialize a C++ variable of arbitrary type into a sink in a single pass.
+ * This function handles calling before/after serialization.
+ * The previous content of the sink is discarded, but its memory is re-used.
+ * @param [in] sink The output buffer to use.
+ * @param [in] t The variable to serlialize
+ * @param [in] tt You can specify additional data, which will be used to select which
+ *                helper function (e.g., tuple_for_serialization) to apply.
+ * @returns the serialized bytes, which remain valid until the sink is next modified.
+ *          On exception the content of the sink is undefined.*/
+template <typename T, typename ...tags>
+inline std::string_view serialize(serialize_sink &sink, const T &t, uf::use_tags_t = {}, tags... tt)
+{
+    static_assert(uf::impl::is_serializable_f<T, true, tags...>(), "Type must be serializable.");
+    sink.clear();
+    if constexpr (uf::impl::is_serializable_f<T, false, tags...>()) {
+        using type = typename std::remove_cvref_t<T>;
+        if constexpr (impl::has_before_serialization_inside_v<type, tags...>)
+            if (auto r = impl::call_before_serialization(&t, tt...); r.obj)
+                impl::call_after_serialization(&t, r, tt...); //This shall throw
+        try {
+            impl::serialize_to(t, sink, tt...);
+            if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                impl::call_after_serialization(&t, true, tt...);
+        } catch (...) {
+            if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                impl::call_after_serialization(&t, false, tt...);
+            throw;
+        }
+    }
+    return sink.view();
+}
+
+namespace impl {
+/** Calls f(i) for each i in [0,n) using 'exec', which is either a standard execution policy
+ * or a callable exec(n, f) with the same semantics. Exceptions thrown by 'f' are caught and
+ * the one for the smallest 'i' is rethrown after all calls returned.*/
+template <typename Exec, typename F>
+void run_parallel(Exec &&exec, size_t n, F &&f) {
+    std::vector<std::exception_ptr> errors(n);
+    const std::function<void(size_t)> task = [&f, &errors](size_t i) {
+        try { f(i); } catch (...) { errors[i] = std::current_exception(); }
+    };
+    if constexpr (std::is_invocable_v<Exec, size_t, const std::function<void(size_t)> &>)
+        exec(n, task);
+    else { //An execution policy: we do not include <execution>, the caller had to.
+        std::vector<size_t> idx(n);
+        std::iota(idx.begin(), idx.end(), size_t(0));
+        std::for_each(std::forward<Exec>(exec), idx.begin(), idx.end(), task);
+    }
+    for (auto &e : errors)
+        if (e) std::rethrow_exception(e);
+}
+
+/** The result of planning a parallel check, see check_parallel().*/
+struct parallel_check_plan {
+    std::string_view elem_type; ///<The type of list elements or the key and value types of a map
+    std::vector<const char *> bounds; ///<Chunk boundaries: from the first element to the end of the value
+    bool checked = false;       ///<The value is already fully checked (and found OK)
+};
+/** Scans the elements of a top-level list or map without looking into anys, and
+ * splits them into ranges of 'chunk' elements. If the elements contain no anys, this
+ * is a full check. We leave 'bounds' empty on any error or if the value is not a list or
+ * map: the caller shall then perform a sequential check to get the error.*/
+[[nodiscard]] parallel_check_plan plan_parallel_check(std::string_view type, std::string_view value, size_t chunk);
+/** Checks (recursively) that [p, end) consists of values of 'elem_type' (a list
+ * element, or the key and value types of a map element).*/
+[[nodiscard]] bool check_elements(std::string_view elem_type, const char *p, const char *end) noexcept;
+} //ns impl
+
+/** Serialize a large random access container (like a vector) using several threads.
+ * Elements are split to chunks; first we take the length of the chunks (unless all elements
+ * have the same length), then serialize them in parallel directly into the result.
+ * Containers that serialize with a single memcpy or whose elements are void-like are
+ * serialized sequentially.
+ * This function handles calling before/after serialization the same way as serialize(),
+ * but since elements are serialized concurrently, their tuple_for_serialization() and
+ * serialization functions must be safe to call for different elements at the same time.
+ * @param [in] c The container to serialize.
+ * @param [in] exec What runs the chunks. Either a standard execution policy (like
+ *             std::execution::par) or a callable of signature
+ *             void exec(size_t n, const std::function<void(size_t)> &f), which must call
+ *             f(0)...f(n-1) (possibly concurrently) and return when all of them returned.
+ *             You can use this to run on your own thread pool.
+ * @param [in] chunk The number of elements serialized in one call of 'f'.
+ * @param [in] tt You can specify additional data, which will be used to select which
+ *                helper function (e.g., tuple_for_serialization) to apply.
+ * @returns the same bytes as serialize(c, use_tags, tt...).*/
+template <typename C, typename Exec, typename ...tags>
+inline std::string serialize_parallel(const C &c, Exec &&exec, size_t chunk = 1024, uf::use_tags_t = {}, tags... tt)
+{
+    using type = typename std::remove_cvref_t<C>;
+    if constexpr (!impl::is_serializable_container<type>::value || impl::is_bulk_serializable_container<type>::value)
+        return serialize(c, use_tags, tt...);
+    else if constexpr (!std::random_access_iterator<decltype(std::begin(c))>
+                       || impl::is_void_like<false, typename impl::serializable_value_type<type>::type, tags...>::value)
+        return serialize(c, use_tags, tt...);
+    else {
+        using E = typename impl::serializable_value_type<type>::type;
+        if constexpr (impl::has_before_serialization_inside_v<type, tags...>)
+            if (auto r = impl::call_before_serialization(&c, tt...); r.obj)
+                impl::call_after_serialization(&c, r, tt...); //This shall throw
+        try {
+            const size_t n = std::size(c);
+            const auto begin = std::begin(c);
+            chunk = std::max(chunk, size_t(1));
+            const size_t chunks = (n + chunk - 1) / chunk;
+            std::vector<size_t> offsets(chunks + 1, 0); //offsets[i+1] is first the length of chunk i, then the prefix sum
+            if constexpr (impl::is_fixed_layout_v<false, E, tags...>)
+                for (size_t i = 0; i < chunks; i++)
+                    offsets[i + 1] = (std::min(n, (i + 1) * chunk) - i * chunk) * impl::fixed_layout_len<false, E, tags...>();
+            else
+                impl::run_parallel(exec, chunks, [&](size_t i) {
+                    size_t len = 0;
+                    for (size_t u = i * chunk, e = std::min(n, u + chunk); u < e; u++)
+                        len += impl::serialize_len(begin[u], tt...);
+                    offsets[i + 1] = len;
+                });
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+            std::string ret(4 + offsets.back(), char(0));
+            char *p = ret.data();
+            impl::serialize_to(uint32_t(n), p, tt...);
+            impl::run_parallel(exec, chunks, [&](size_t i) {
+                char *q = p + offsets[i];
+                for (size_t u = i * chunk, e = std::min(n, u + chunk); u < e; u++)
+                    impl::serialize_to(begin[u], q, tt...);
+            });
+            if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                impl::call_after_serialization(&c, true, tt...);
+            return ret;
+        } catch (...) {
+            if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                impl::call_after_serialization(&c, false, tt...);
+            throw;
+        }
+    }
+}
+
+/** Check that 'value' is a valid serialized value of 'type' (including the content of
+ * anys recursively) using several threads. This is worth for large top-level lists or
+ * maps whose elements contain anys: we split the elements into chunks (by scanning them
+ * without looking into the anys) and check the chunks in parallel. Other values are
+ * checked sequentially. Use it instead of any_view(from_raw, v, true) or
+ * any_view(from_type_value, t, v), by creating the any_view unchecked first.
+ * @param [in] type The typestring.
+ * @param [in] value The serialized value.
+ * @param [in] exec What runs the chunks, see serialize_parallel().
+ * @param [in] chunk The number of elements checked in one go.
+ * @exception uf::typestring_error if 'type' is invalid.
+ * @exception uf::value_mismatch_error if 'value' does not match 'type'. Errors are
+ *            the same as for a sequential check.*/
+template <typename Exec>
+inline void check_parallel(std::string_view type, std::string_view value, Exec &&exec, size_t chunk = 1024)
+{
+    impl::parallel_check_plan plan = impl::plan_parallel_check(type, value, std::max(chunk, size_t(1)));
+    if (plan.checked) return;
+    if (plan.bounds.size() >= 2) {
+        std::vector<char> ok(plan.bounds.size() - 1);
+        impl::run_parallel(exec, ok.size(), [&plan, &ok](size_t i) {
+            ok[i] = impl::check_elements(plan.elem_type, plan.bounds[i], plan.bounds[i + 1]);
+        });
+        if (std::find(ok.begin(), ok.end(), char(0)) == ok.end()) return;
+    }
+    //Report errors exactly as a sequential check would
+    auto [err, tlen, vlen] = impl::serialize_scan_by_type(type, value, false, true);
+    if (err) err->throw_me();
+}
+
+/** Serialize a C++ variable of arbitrary type into a list of segments for scatter/gather IO.
+ * Strings, string_views, the value part of uf::any/any_view and lists of chars/doubles
+ * of at least 'threshold' bytes are not copied, but referenced in place; everything else
+ * is packed into an internal header arena.
+ * Before serialization is called here. After serialization is called with 'true', when the
+ * returned object is destroyed or released (as the referenced parts of 't' must
+ * remain valid and unchanged until then). On exception, it is called with 'false' right away.
+ * @param [in] t The variable to serlialize. Must outlive the returned object.
+ * @param [in] threshold Strings at least this long are referenced instead of copied.
+ * @param [in] tt You can specify additional data, which will be used to select which
+ *                helper function (e.g., tuple_for_serialization) to apply.
+ * @returns the segments, whose concatenation equals what uf::serialize() would return.*/
+template <typename T, typename ...tags>
+inline serialized_iov serialize_iov(const T &t, size_t threshold, uf::use_tags_t, tags... tt)
+{
+    static_assert(uf::impl::is_serializable_f<T, true, tags...>(), "Type must be serializable.");
+    serialized_iov ret(threshold);
+    if constexpr (uf::impl::is_serializable_f<T, false, tags...>()) {
+        using type = typename std::remove_cvref_t<T>;
+        if constexpr (impl::has_before_serialization_inside_v<type, tags...>)
+            if (auto r = impl::call_before_serialization(&t, tt...); r.obj)
+                impl::call_after_serialization(&t, r, tt...); //This shall throw
+        try {
+            impl::serialize_to(t, ret, tt...);
+            if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                ret._after = [&t, tt...]() { impl::call_after_serialization(&t, true, tt...); };
+        } catch (...) {
+            if constexpr (impl::has_after_serialization_inside_v<type, tags...>)
+                impl::call_after_serialization(&t, false, tt...);
+            throw;
+        }
+    }
+    return ret;
+}
+
 /** Deserialize from a bytearray to a type. Type cannot contain const or *_view elements.
  * @param [in] s The raw data to deserialize from.
  * @param [out] t The placeholder to deserialize into.
@@ -6627,6 +8453,21 @@ inline T deserialize_as(std::string_view s, bool allow_longer_data = false,
     return t;
 }
 
+/** Deserialize from a bytearray to a newly created allocator-aware object (e.g.,
+ * std::pmr::vector<std::pmr::string> or std::pmr::map), that takes its memory from 'mr'.
+ * Elements of containers are also created with the container's allocator, so, when
+ * using a monotonic resource, releasing it frees everything at once.
+ * For other types (e.g., structs with pmr members) create the object with the
+ * resource yourself and use deserialize().
+ * The parameters are the same as for deserialize_as() above.*/
+template <typename T, typename ...tags> requires std::uses_allocator_v<T, std::pmr::polymorphic_allocator<>>
+inline T deserialize_as(std::string_view s, std::pmr::memory_resource *mr, bool allow_longer_data = false,
+                        uf::use_tags_t = {}, tags...tt) {
+    T t = std::make_obj_using_allocator<T>(std::pmr::polymorphic_allocator<>(mr));
+    deserialize(s, t, allow_longer_data, uf::use_tags, tt...);
+    return t;
+}
+
 /** Deserialize from a bytearray with a known type to a C++ variable with potential conversions.
  * Type cannot contain const or *_view elements.
  * @param [in] s The raw data to deserialize from.
@@ -6659,7 +8500,7 @@ inline std::string_view  deserialize_convert(std::string_view s, std::string_vie
         throw value_mismatch_error("Bytes left after deserializing <%1>", from_type);
     if (errors.size())
         throw uf::expected_with_error("In uf::deserialize_convert <%1> -> <%2> cannot place errors in expected values. Errors: %e",
-                                      from_type, deserialize_type<T, tags...>, std::move(errors), std::move(error_pos));
+                                      from_type, deserialize_type<T, tags...>(), std::move(errors), std::move(error_pos));
     return { p.p, p.end>=p.p ? size_t(p.end - p.p) : 0 };
 }
 
@@ -6684,7 +8525,7 @@ inline std::string_view deserialize_convert(std::string_view s, std::string_view
                                             serpolicy convpolicy = uf::allow_converting_all,
                                             bool allow_longer_data = false,
                                             uf::use_tags_t = {}, tags... tt) {
-    return deserialize(s, from_type, v, convpolicy, allow_longer_data, uf::use_tags, tt...);
+    return deserialize_convert(s, from_type, v, convpolicy, allow_longer_data, uf::use_tags, tt...);
 }
 
 /** Deserialize from a bytearray with a known type to a C++ variable  with potential conversions.
@@ -6809,7 +8650,7 @@ inline std::string_view deserialize_view_convert(std::string_view s, std::string
         throw value_mismatch_error("Bytes left after deserializing <%1>", from_type);
     if (errors.size())
         throw uf::expected_with_error("In uf::deserialize_convert <%1> -> <%2> cannot place errors in expected values. Errors: %e",
-                                      from_type, deserialize_type<T, tags...>, std::move(errors), std::move(error_pos));
+                                      from_type, deserialize_type<T, tags...>(), std::move(errors), std::move(error_pos));
     return {p.p, p.end>=p.p ? size_t(p.end - p.p) : 0};
 }
 
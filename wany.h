@@ -6,9 +6,11 @@
 #include "ufser.h"
 #include <memory>
 #include <map>
+#include <unordered_map>
 #include <iostream>
 #include <forward_list>
 #include <atomic>
+#include <mutex>
 
 #define XSTR(x) STR(x)
 #define STR(x) #x
@@ -321,6 +323,9 @@ public:
      * We pay attention to preserve the 'next' field.*/
     chunk& resize(uint32_t l) & { if (l > len) reserve(l); else len = l; return *this; }
     bool is_writable() const noexcept { return root && root->is_writable(); }
+    /** Makes the underlying sview read-only, so that any later write via us or
+     * others sharing it will copy it first (see data_writable()).*/
+    void make_read_only() noexcept { if (is_writable()) root->make_read_only(); }
     /** Assigns content to us, by ensuring we are writable and then copying over.
      * We pay attention to preserve the 'next' field.*/
     chunk& assign(std::string_view s) & {
@@ -346,6 +351,23 @@ public:
         len = root->size();
         return *this;
     }
+    /** Make us view 'len' bytes of 's' from offset 'o', which must be the same bytes we view now.
+     * We pay attention to preserve the 'next' field.*/
+    void rebase(const sview_ptr &s, uint32_t o) noexcept {
+        assert(o + len <= s->size());
+        assert(!len || !memcmp(data(), s->data() + o, len));
+        root = s;
+        off = o;
+    }
+    /** Extends us with the next chunk and unlinks it. Our bytes and those of the
+     * next chunk must be consecutive in the same sview (or the next one is empty).*/
+    void absorb_next() noexcept {
+        assert(next);
+        assert(!next->len || (root == next->root && off + len == next->off));
+        len += next->len;
+        auto n = std::move(next->next); //keep it alive while the old next is released
+        next = std::move(n);
+    }
     /** Copy content to us from another chunk.
      * We pay attention to *copy* the 'next' field, as well.*/
     chunk& copy_from(const chunk &c) & {
@@ -487,6 +509,36 @@ inline string_variant flatten(typename chunk<has_refc, Allocator>::ptr from,
     return ret;
 }
 
+/// @return the number of chunks in the given range
+template <bool has_refc, template <typename> typename Allocator>
+inline uint32_t count_chunks(typename chunk<has_refc, Allocator>::ptr from,
+                             typename chunk<has_refc, Allocator>::ptr const& to) noexcept
+{
+    return std::distance(std::move(from), to);
+}
+
+/** Re-packs the bytes of the chunks ['from'..'to') into a single new sview.
+ * We keep the chunks themselves, as wviews may point to any of them, but
+ * rebase them to the new sview. If we have refcounts, chunks that only their
+ * predecessor points to are merged into that predecessor.*/
+template <bool has_refc, template <typename> typename Allocator>
+inline void compact(typename chunk<has_refc, Allocator>::ptr from,
+                    typename chunk<has_refc, Allocator>::ptr const& to)
+{
+    typename sview<has_refc, Allocator>::ptr s(flatten_size<has_refc, Allocator>(from, to));
+    flatten_to<has_refc, Allocator>(from, to, s->data_writable());
+    uint32_t off = 0;
+    for (auto c = std::move(from); c != to; c = c->next) {
+        c->rebase(s, off);
+        if constexpr (has_refc)
+            while (c->next != to && c->next.get_refcount() == 1) { //only 'c' points to it
+                c->next->rebase(s, off + c->size());
+                c->absorb_next();
+            }
+        off += c->size();
+    }
+}
+
 /// Checks if [from1,off1->to1) starts with the content of [from2,off2->last2,last2_off2)
 template <bool has_refc, template <typename> typename Allocator>
 inline bool startswidth(typename chunk<has_refc, Allocator>::ptr from1, size_t off1,
@@ -670,6 +722,17 @@ inline std::pair<std::string_view, std::string> parse_tuple_type(std::string_vie
     return {ret.substr(0, len), {}};
 }
 
+/** Binds a wview to the memory resource current when it was created (see uf::arena),
+ * so that later modifications allocate from the same one. Stateless allocators need
+ * no binding, so this is empty for them.*/
+template <template <typename> typename Allocator>
+struct allocator_binding {
+    struct scope {
+        explicit scope(const allocator_binding *) noexcept {}
+        ~scope() {} //not trivial, so that holding one does not warn as unused
+    };
+};
+
 /// A writable view of a serialized uf:: something
 template <bool has_refc, template <typename> typename Allocator= std::allocator>
 class wview : private std::conditional_t<has_refc, RefCount, NoRefCount>{
@@ -751,6 +814,8 @@ public:
         ptr& operator =(ptr&&) & noexcept = default;
 
         bool is_same_as(const ptr& o) const noexcept { return p == o.p; }
+        /** Makes the memory resource we were created with current for an operation that may allocate.*/
+        typename allocator_binding<Allocator>::scope bind() const noexcept { return typename allocator_binding<Allocator>::scope(p ? &p->binding : nullptr); }
 
         /** Returns our type character or zero if empty.*/
         char typechar() const noexcept { return p ? p->typechar() : 0; }
@@ -807,7 +872,7 @@ public:
         /** Get a wview to one of our constitutent. 'idx' starts at zero and
          *  must be lower than size() (or we throw std::out_of_range).
          * For types having no constitutent, we throw uf::type_mismatch_error.*/
-        ptr operator[](uint32_t idx) const { return p ? p->operator[](idx) : ptr{}; }
+        ptr operator[](uint32_t idx) const { const auto bound = bind(); return p ? p->operator[](idx) : ptr{}; }
 
         /** Set the value pointed to by us to the content of another wview. We make a copy,
          * so there is no link remaining between the wview we change and 'o', so chaning 'o'
@@ -816,7 +881,7 @@ public:
          * any such wviews continue to hold their value, but changes to them will have no effect
          * on 'this' or any parent of it.
          * If a type change is not possible, but needed we throw an uf::type_mismatch_error.*/
-        ptr& set(const ptr& o) & { assert(p); if (o) p->set(*o); else clear();  return *this; }
+        ptr& set(const ptr& o) & { assert(p); const auto bound = bind(); if (o) p->set(*o); else clear();  return *this; }
         /** Set the value pointed to by us to the content of another wview. We make a copy,
          * so there is no link remaining between the wview we change and 'o', so chaning 'o'
          * will have no effect on 'this' or its parents.
@@ -824,7 +889,7 @@ public:
          * any such wviews continue to hold their value, but changes to them will have no effect
          * on 'this' or any parent of it.
          * If a type change is not possible, but needed we throw an uf::type_mismatch_error.*/
-        ptr&& set(const ptr& o) && { assert(p); if (o) p->set(*o); else clear();  return std::move(*this); }
+        ptr&& set(const ptr& o) && { assert(p); const auto bound = bind(); if (o) p->set(*o); else clear();  return std::move(*this); }
         /** Set the value pointed to by us to a new type and value.
          * If we have wviews to any of our constitutent elements, we break any link with them:
          * any such wviews continue to hold their value, but changes to them will have no effect
@@ -834,6 +899,7 @@ public:
         ptr& set(T const& t) & {
             static_assert(is_serializable_v<T>);
             assert(p);
+            const auto bound = bind();
             p->set(uf::serialize_type(t), uf::serialize(t));
             return *this;
         }
@@ -846,6 +912,7 @@ public:
         ptr&& set(T const& t)&& {
             static_assert(is_serializable_v<T>);
             assert(p);
+            const auto bound = bind();
             p->set(uf::serialize_type(t), uf::serialize(t));
             return std::move(*this);
         }
@@ -854,13 +921,13 @@ public:
          * any such wviews continue to hold their value, but changes to them will have no effect
          * on 'this' or any parent of it.
          * If a type change is not possible, we throw an uf::type_mismatch_error.*/
-        ptr& set(std::string_view type, std::string_view value) & { assert(p); p->set(type, value); return *this; }
+        ptr& set(std::string_view type, std::string_view value) & { assert(p); const auto bound = bind(); p->set(type, value); return *this; }
         /** Set the value pointed to by us to a new type and value.
          * If we have wviews to any of our constitutent elements, we break any link with them:
          * any such wviews continue to hold their value, but changes to them will have no effect
          * on 'this' or any parent of it.
          * If a type change is not possible, but needed we throw an uf::type_mismatch_error.*/
-        ptr&& set(std::string_view type, std::string_view value) && { assert(p); p->set(type, value); return std::move(*this); }
+        ptr&& set(std::string_view type, std::string_view value) && { assert(p); const auto bound = bind(); p->set(type, value); return std::move(*this); }
         /** Set the value pointed to by us to void.
          * If we have wviews to any of our constitutent elements, we break any link with them:
          * any such wviews continue to hold their value, but changes to them will have no effect
@@ -880,6 +947,7 @@ public:
          * an uf::type_mismatch_error.*/
         void erase(uint32_t idx) {
             if (!p) throw std::out_of_range("Cannot erase from empty wview.");
+            const auto bound = bind();
             int32_t cindex;
             try {
                 auto ci = p->cindexof(operator[](idx));
@@ -899,6 +967,7 @@ public:
          * If this incurs a type change (for tuples), and that is not possible, we throw
          * an uf::type_mismatch_error.*/
         void erase(const ptr &what) {
+            const auto bound = bind();
             if (p)
                 if (auto cindex = p->cindexof(what)) {
                     if (p->do_erase(*cindex))
@@ -907,6 +976,24 @@ public:
                 }
             throw std::invalid_argument("Wview to erase is not my child.");
         }
+        /** Erase 'count' consecutive constituents starting at 'idx'.
+         * For lists and maps this is done in a single pass: the element count, the sizes
+         * of enclosing anys and any index are updated only once. For other types (optional,
+         * tuple) we erase the elements one by one, as with erase().
+         * We throw an std::out_of_range if the range does not fit into size().*/
+        void erase_many(uint32_t idx, uint32_t count) {
+            if (!p) throw std::out_of_range("Cannot erase from empty wview.");
+            const auto bound = bind();
+            if (!count) return;
+            if (const char c = p->typechar(); c != 'l' && c != 'm') {
+                while (count--)
+                    erase(idx);
+                return;
+            }
+            if (uint64_t(idx) + count > size())
+                throw std::out_of_range(uf::concat("Range [", idx, "..", uint64_t(idx) + count - 1, "] out of range [0..", size() - 1, "] in erase_many() for type <", type().as_view(), ">."));
+            p->do_erase_many(idx, count);
+        }
 
         /** Insert one more constitutent after 'idx'. To insert to the beginning
          * use any negative value for 'idx'.
@@ -916,6 +1003,7 @@ public:
          * If the type of what is not appropriate (for 'lmo') we also throw an uf::type_mismatch_error.*/
         void insert_after(int32_t idx, const ptr &what) {
             if (!p) throw std::out_of_range("Cannot insert to empty wview.");
+            const auto bound = bind();
             int32_t cindex = -1;
             if (idx>=0) try {
                 auto ci = p->cindexof(operator[](idx));
@@ -938,6 +1026,7 @@ public:
         void insert_after(const ptr& where, const ptr& what)
         {
             if (!p) throw std::out_of_range("Cannot insert to empty wview.");
+            const auto bound = bind();
             if (auto cindex = p->cindexof(where)) {
                 if (p->do_insert_after(*cindex, *what))
                     throw uf::type_mismatch_error("Cannot insert into a <%1>.", type(), {});
@@ -946,15 +1035,69 @@ public:
             throw std::invalid_argument("Wview to insert after is not my child.");
         }
 
+        /** Insert several constituents after 'idx' (to insert to the beginning use any
+         * negative value for 'idx'), keeping their order.
+         * For lists and maps this is done in a single pass: all types are checked
+         * first, then the element count, the sizes of enclosing anys and any index
+         * are updated only once. If a type is not appropriate, we throw an
+         * uf::type_mismatch_error and insert nothing. For other types (optional,
+         * tuple) we insert the elements one by one, as with insert_after().
+         * We throw an std::out_of_range if 'idx' is >= size().*/
+        void insert_many_after(int32_t idx, const std::vector<ptr>& what) {
+            if (!p) throw std::out_of_range("Cannot insert to empty wview.");
+            const auto bound = bind();
+            if (what.empty()) return;
+            if (const char c = p->typechar(); c != 'l' && c != 'm') {
+                for (idx = std::max(idx, -1); const ptr &w : what)
+                    insert_after(idx++, w);
+                return;
+            }
+            int32_t cindex = -1;
+            if (idx>=0) try {
+                auto ci = p->cindexof(operator[](idx));
+                assert(ci);
+                if (!ci) return;
+                cindex = *ci;
+            } catch (const std::out_of_range & e) {
+                throw std::out_of_range(uf::concat("Index (", idx, ") out of range [0..", size()-1, "] in insert_many_after() for type <", type().as_view(), ">."));
+            }
+            p->do_insert_many_after(cindex, what);
+        }
+
         /** Creates a copy of the current wview, with creating new chunks.
          * @returns a wview with no parents that can be modified without
          * modifying 'this'.*/
         ptr clone() const {
+            const auto bound = bind();
             return p ? ptr{ impl::clone_anew<has_refc, Allocator>(p->tbegin, p->tend), {},
                             impl::clone_anew<has_refc, Allocator>(p->vbegin, p->vend), {}, nullptr } :
                 ptr{};
         }
 
+        /** Creates an immutable snapshot of the current value of this wview.
+         * Unlike clone(), we do not copy any bytes: all the sviews we use are made
+         * read-only and are shared with the snapshot, only the chunks are new.
+         * Any later modification of 'this' copies just the chunks it writes to.
+         * With the refcounted uf::wview the snapshot (and further snapshots taken of
+         * it) can be used on other threads while 'this' is being modified. Readers
+         * should take their own snapshot() of a published one before traversing it,
+         * as creating sub-views of a wview modifies it.
+         * @returns a wview with no parents, or null if we are null.*/
+        ptr snapshot() const {
+            if (!p) return {};
+            p->make_read_only();
+            return clone();
+        }
+
+        /** Re-packs our type and value into a single allocation each, if they are
+         * spread over more than 'max_chunks' chunks (e.g., after many modifications).
+         * After this type(), value(), as_any() and get_as() work on contiguous memory
+         * without copying. Sub-views remain valid, but string_views previously
+         * obtained from us, our ancestors or descendants may be invalidated.
+         * Call it on the top-level wview to compact the whole document.
+         * @returns true if we have re-packed anything.*/
+        bool compact(uint32_t max_chunks = 1) const { const auto bound = bind(); return p && p->compact(max_chunks); }
+
         /** Create a wview containing an optional with the value (and type) provided.
          * We copy 'o' so it will not be linked to the result in any way.
          * For void 'o' we return null.*/
@@ -1065,6 +1208,7 @@ public:
         {
             assert(p && w.p);
             if (w.p == p) return;
+            const auto bound = bind();
             //Dont swap with your parent/child
             for (auto i = p->parent; i; i = i->parent)
                 if (i == w.p)
@@ -1094,6 +1238,11 @@ public:
             //Dont swap the tends. Those point to a chunk not affected by the swap.
             //Keep parsed children alive. Note: no children uses our tbegin or vbegin, so it safe
             std::swap(p->children, w.p->children);
+            for (auto &c : p->children) c.second->parent = p;
+            for (auto &c : w.p->children) c.second->parent = w.p;
+            std::swap(p->index, w.p->index);
+            p->update_ancestor_indices();
+            w.p->update_ancestor_indices();
             //And we keep our parents intact. Swapping content keeps
             assert(p->check(LOC));
             assert(w->check(LOC));
@@ -1128,9 +1277,32 @@ public:
          * if not found, empty string and set ptr for the first element found.*/
         std::pair<ptr, std::string> linear_search(const ptr &t, int n) const {
             if (!p || n<0) return {};
+            const auto bound = bind();
             return p->linear_search(t, n);
         }
 
+        /** Create a hash index on a list or map to speed up linear_search().
+         * The index is on the first 'n' members of the elements (for lists) or keys
+         * (for maps), with the same interpretation of 'n' as in linear_search().
+         * Subsequent calls to linear_search() with an 'n' selecting the same
+         * members are served from the index in O(1) (unless many elements share the
+         * same key). The index is kept up-to-date when elements are inserted, erased,
+         * swapped or changed via a wview to them or their descendants. If we ourselves
+         * are set() to a new value, the index is rebuilt at the next linear_search().
+         * Note that all elements are parsed into child wviews, which costs memory.
+         * We hold only one index, calling this again replaces it.
+         * @returns Human readable string if we are not a list/map or 'n' is bad for
+         *          our type, empty string on success.*/
+        std::string create_index(int n) const {
+            if (!p || n<0) return "Cannot create an index on an empty wview or with a negative 'n'.";
+            const auto bound = bind();
+            return p->create_index(n);
+        }
+        /** Removes the index created by create_index(), if any.*/
+        void drop_index() const noexcept { if (p) p->drop_index(); }
+        /** Returns true if we have an index created by create_index().*/
+        bool has_index() const noexcept { return p && p->index; }
+
         /** Throws a value_mismatch_error if there is a problem with the internal representation. */
         void check(std::string_view loc = "???") const { if (p) p->check(loc); }
     };
@@ -1142,17 +1314,32 @@ private:
     chunk_ptr vbegin;///< the first chunk holding the serialized value
     chunk_ptr vend;///< guess
     wview* parent = nullptr;
+    [[no_unique_address]] allocator_binding<Allocator> binding;
     using child = std::pair<uint32_t, wview::ptr>;
     friend bool operator<(const child& a, const child& b) { return a.first < b.first; }
     friend bool operator<(const child& a, uint32_t b) { return a.first < b; }
     std::vector<child, Allocator<child>> children;///< already parsed child wviews
+    /** An optional hash index over the elements of a list or map, see ptr::create_index().
+     * It holds a reference to every element, which are all parsed into 'children'.
+     * We store the hash of the key bytes only and compare the bytes on lookup.*/
+    struct key_index {
+        int n; ///< The number of leading members of the element/key we index by (at least 1)
+        std::basic_string<char, std::char_traits<char>, Allocator<char>> key_type; ///< The type of the leading members
+        std::unordered_multimap<size_t, ptr, std::hash<size_t>, std::equal_to<size_t>,
+                                Allocator<std::pair<const size_t, ptr>>> by_hash;
+        std::unordered_map<const wview*, size_t, std::hash<const wview*>, std::equal_to<const wview*>,
+                           Allocator<std::pair<const wview* const, size_t>>> hash_of;
+        bool stale = false; ///< Set if we have been overwritten and need to rebuild before the next lookup
+        void clear() noexcept { by_hash.clear(); hash_of.clear(); stale = true; }
+    };
+    key_index *index = nullptr;
 public:
     wview() noexcept = delete;
     wview(const wview&) = delete; ///non-movable, non copyable, so that its parent keeps knowing about it.
     wview(wview&&) noexcept = delete;
     //wview& operator =(const wview&) = default; //but assignable (?)
     //wview& operator =(wview&&) noexcept = default;
-    ~wview() { disown_children(true); }
+    ~wview() { drop_index(); disown_children(true); }
 
     explicit wview(chunk_ptr &&tb, chunk_ptr &&te,
                    chunk_ptr &&vb, const chunk_ptr &ve, wview *p) noexcept
@@ -1640,6 +1827,7 @@ private:
     void disown_children(bool destructor) //TODO: remove destructor. Overwirting a parent will never impact a child as tbegin and vbegin are not shared by parents & children
         //This will assume we change tbegin and vbegin after this (or drop them)
     {
+        if (index) index->clear(); //drops the references it holds to 'children'
         if (children.empty()) return;
         /** This is true if only the children remain after the operation calling disown_children().*/
         const bool children_only = destructor && !parent;
@@ -1808,6 +1996,7 @@ private:
         const int32_t diff = int32_t(w_tlen - old_tlen) + int32_t(w_vlen - old_vlen);
         if (ptype == 'a') parent->update_parent_any_sizes(diff); //skip adjusting our parent, just do the parent's parent and up
         else update_parent_any_sizes(diff);
+        update_ancestor_indices();
         assert(check(LOC));
     }
 
@@ -1892,6 +2081,7 @@ private:
         const int32_t diff = int32_t(type.length() - old_tlen) + int32_t(value.length() - old_vlen);
         if (ptype == 'a') parent->update_parent_any_sizes(diff);
         else update_parent_any_sizes(diff);
+        update_ancestor_indices();
         assert(check(LOC));
     }
 
@@ -1974,15 +2164,58 @@ private:
             children[i].first--;
         //disown and delete this guy from children
         size_diff -= children[cindex].second->flatten_size();         //We insert remove this from the value
+        if (index) index_remove(&*children[cindex].second);
         disown_child(cindex, typechar()!='t', false);
         children.erase(children.begin() + cindex);
         update_parent_any_sizes(size_diff);
+        update_ancestor_indices();
         assert(check(LOC));
         return false;
     }
 
+    /** Erase 'count' elements of a list or map starting at index 'idx' in one go.*/
+    void do_erase_many(uint32_t idx, uint32_t count) {
+        assert(check(LOC));
+        assert(typechar() == 'l' || typechar() == 'm');
+        assert(count && idx + count <= size());
+        const uint32_t new_size = size() - count;
+        //make sure the first and the last erased elements are among 'children'
+        const ptr first_child = operator[](idx), last_child = operator[](idx + count - 1);
+        const uint32_t first = *cindexof(first_child), last = *cindexof(last_child);
+        //decrement the size field at the beginning
+        if (!vbegin->is_writable()) {
+            split<has_refc, Allocator>(vbegin, 4); //does nothing if vbegin is already only 4 bytes.
+            vbegin->reserve(4); //make sure length is writable (destroys original content)
+        }
+        char* p = vbegin->data_writable();
+        serialize_to(new_size, p);
+        //unlink the data of all of them
+        const int32_t size_diff = -int32_t(::uf::impl::flatten_size<has_refc, Allocator>(
+            children[first].second->vbegin, children[last].second->vend));
+        auto vprev = find_before<has_refc, Allocator>(
+            children[first].second->vbegin,
+            first ? children[first - 1].second->vbegin : vbegin, vend);
+        const bool just_after = first && vprev->next == children[first - 1].second->vend;
+        vprev->next = children[last].second->vend;
+        if (just_after)
+            children[first - 1].second->change_vend(vprev->next);
+        //Decrease the indices after
+        for (size_t i = last + 1; i < children.size(); i++)
+            children[i].first -= count;
+        //disown and delete the erased ones (also those in between) from children
+        for (size_t i = first; i <= last; i++) {
+            if (index) index_remove(&*children[i].second);
+            disown_child(i, true, false);
+        }
+        children.erase(children.begin() + first, children.begin() + last + 1);
+        update_parent_any_sizes(size_diff);
+        update_ancestor_indices();
+        assert(check(LOC));
+    }
+
     bool do_insert_after(int cindex, const wview& what) {
         int32_t size_diff = 0;
+        const uint32_t new_idx = cindex < 0 ? 0 : children[cindex].first + 1;
         switch (typechar()) {
         default: return true;
         case 'o': {
@@ -2073,10 +2306,185 @@ private:
         //Adjust parent's any sizes
         size_diff += what.flatten_size();         //We insert this into the value
         update_parent_any_sizes(size_diff);
+        if (index && !index->stale) index_add(operator[](new_idx));
+        update_ancestor_indices();
         assert(check(LOC));
         return false;
     }
 
+    /** Insert all of 'what' after the child at 'cindex' of a list or map in one go.*/
+    void do_insert_many_after(int cindex, const std::vector<ptr>& what) {
+        assert(typechar() == 'l' || typechar() == 'm');
+        const auto t1_ = type();
+        const std::string_view t1 = t1_.as_view().substr(1);
+        for (const ptr &w : what)
+            if (auto t2 = w.type(); typechar() == 'l' ? t1 != t2.as_view()
+                                                     : t2.as_view().substr(0,2)!="t2" || t1 != t2.as_view().substr(2))
+                throw uf::type_mismatch_error("Cannot insert a <%2> into <%1>.", t1_.as_view(), t2.as_view(), 1);
+        const uint32_t new_idx = cindex < 0 ? 0 : children[cindex].first + 1;
+        //increment the size field at the beginning
+        const uint32_t new_size = size() + what.size();
+        if (!vbegin->is_writable() || cindex<0) { //if we insert to the front, ensure vbegin is the length only and we can insert after it.
+            split<has_refc, Allocator>(vbegin, 4); //ensure length is its own chunk
+            vbegin->reserve(4); //make sure writable. Destroys size()
+        }
+        char* p = vbegin->data_writable();
+        serialize_to(new_size, p);
+        //link in a clone of the data of all of 'what', starting from the last
+        const chunk_ptr& link_after = cindex < 0 ?
+            vbegin :
+            find_before<has_refc, Allocator>(children[cindex].second->vend,
+                                             children[cindex].second->vbegin,
+                                             children[cindex].second->vend);
+        chunk_ptr vcopy = link_after->next;
+        int32_t size_diff = 0;
+        for (size_t i = what.size(); i; --i) {
+            vcopy = clone_anew<has_refc, Allocator>(what[i-1]->vbegin, what[i-1]->vend, vcopy);
+            size_diff += what[i-1]->flatten_size();
+        }
+        link_after->next = std::move(vcopy);
+        if (cindex >= 0)
+            children[cindex].second->change_vend(link_after->next);
+        //increase the index of everyone behind us in 'children'
+        for (size_t i = cindex + 1; i < children.size(); i++)
+            children[i].first += what.size();
+        update_parent_any_sizes(size_diff);
+        if (index && !index->stale)
+            for (uint32_t i = 0; i < what.size(); i++)
+                index_add(operator[](new_idx + i));
+        update_ancestor_indices();
+        assert(check(LOC));
+    }
+
+    bool compact(uint32_t max_chunks) {
+        bool ret = false;
+        if (count_chunks<has_refc, Allocator>(tbegin, tend) > max_chunks) {
+            impl::compact<has_refc, Allocator>(tbegin, tend);
+            ret = true;
+        }
+        if (count_chunks<has_refc, Allocator>(vbegin, vend) > max_chunks) {
+            impl::compact<has_refc, Allocator>(vbegin, vend);
+            ret = true;
+        }
+        assert(check(LOC));
+        return ret;
+    }
+
+    void make_read_only() noexcept {
+        for (auto c = tbegin; c != tend; c = c->next) c->make_read_only();
+        for (auto c = vbegin; c != vend; c = c->next) c->make_read_only();
+    }
+
+    /** Compute the key bytes of 'w' according to 'key_type': the leading part of its value
+     * holding the members in 'key_type'. Works for elements of lists, maps and for search values.*/
+    static std::unique_ptr<value_error> index_key_of(const wview &w, std::string_view key_type, std::string &key) {
+        key.resize(w.flatten_size());
+        w.flatten_to(key.data());
+        const char *p = key.data(), *const end = p + key.size();
+        while (key_type.length())
+            if (auto err = serialize_scan_by_type_from(key_type, p, end, false))
+                return err;
+        key.resize(p - key.data());
+        return {};
+    }
+
+    void index_add(const ptr &w) {
+        assert(index);
+        std::string key;
+        if (auto err = index_key_of(*w, index->key_type, key))
+            err->append_msg(" (wany index)").throw_me();
+        const size_t hash = std::hash<std::string_view>()(key);
+        index->by_hash.emplace(hash, w);
+        index->hash_of[&*w] = hash;
+    }
+
+    /** Removes 'w' from our index and returns the reference we held to it.*/
+    ptr index_remove(const wview *w) noexcept {
+        assert(index);
+        ptr ret;
+        auto i = index->hash_of.find(w);
+        if (i == index->hash_of.end()) return ret;
+        for (auto [b, e] = index->by_hash.equal_range(i->second); b != e; ++b)
+            if (&*b->second == w) {
+                ret = std::move(b->second);
+                index->by_hash.erase(b);
+                break;
+            }
+        index->hash_of.erase(i);
+        return ret;
+    }
+
+    /** Call after our value has changed: re-hash the element on our path in all
+     * indexed ancestors.*/
+    void update_ancestor_indices() {
+        for (wview *w = this; w->parent; w = w->parent)
+            if (wview *const a = w->parent; a->index && !a->index->stale)
+                if (ptr c = a->index_remove(w))
+                    a->index_add(c);
+    }
+
+    void rebuild_index() {
+        assert(index);
+        index->clear();
+        const uint32_t s = size();
+        for (uint32_t i = 0; i < s; i++)
+            index_add(operator[](i));
+        index->stale = false;
+    }
+
+    std::string create_index(int n) {
+        const char c = typechar();
+        if (c != 'l' && c != 'm')
+            return uf::concat("create_index() is possible only in lists/maps and not in <", type().as_view(), ">.");
+        auto t1_ = type();
+        std::string_view key_type = t1_.as_view().substr(1); //for lists the key is the whole element
+        if (c == 'm') {
+            if (auto [len, err] = parse_type(key_type, false); err != ser::ok)
+                return uf::concat("internal error in create_index(): ", key_type);
+            else key_type = key_type.substr(0, len);
+        }
+        auto [t1x, err1] = parse_tuple_type(key_type, std::max(1, n));
+        if (err1.length()) return uf::concat(err1, " (<", key_type, ">)");
+        drop_index();
+        index = new(Allocator<key_index>().allocate(1)) key_index{std::max(1, n), {t1x.data(), t1x.size()}, {}, {}};
+        try {
+            rebuild_index();
+        } catch (const std::exception &e) {
+            drop_index();
+            return e.what();
+        }
+        return {};
+    }
+
+    void drop_index() noexcept {
+        if (!index) return;
+        index->~key_index();
+        Allocator<key_index>().deallocate(index, 1);
+        index = nullptr;
+    }
+
+    /** Look up 't' in our index. We return the first matching element, like the linear scan does.*/
+    std::pair<ptr, std::string> index_search(const ptr &t) {
+        if (index->stale)
+            try { rebuild_index(); }
+            catch (const std::exception &e) { return {{}, e.what()}; }
+        std::string key, candidate;
+        if (auto err = index_key_of(*t, index->key_type, key))
+            return {{}, uf::concat("Internal value error #5 in linear_search(): ", err->what())};
+        auto position = [this](const ptr &w) {
+            return std::find_if(children.begin(), children.end(), [&w](const child &c) { return c.second == w; }) - children.begin();
+        };
+        const ptr *found = nullptr;
+        for (auto [b, e] = index->by_hash.equal_range(std::hash<std::string_view>()(key)); b != e; ++b) {
+            if (auto err = index_key_of(*b->second, index->key_type, candidate))
+                return {{}, uf::concat("Internal value error #6 in linear_search(): ", err->what())};
+            if (candidate == key && (!found || position(b->second) < position(*found))) //on duplicate keys select the one in front
+                found = &b->second;
+        }
+        if (!found) return {};
+        return {*found, {}};
+    }
+
     std::pair<ptr, std::string> linear_search(const ptr &t, int n) {
         const char c = typechar();
         if (c != 'l' && c != 'm')
@@ -2103,6 +2511,7 @@ private:
                 if (t1x != t2x) return { {}, uf::concat("Mismatching types: <", t1x, "> and <", t2x, ">.") };
             }
         }
+        if (index && index->n == std::max(1, n)) return index_search(t);
         const uint32_t no_elements = size();
         if (no_elements==0) return {}; //avoid calling vc->data() below as vc will be tend below which may be null
         //Determine the last byte of the value to search for
@@ -2210,6 +2619,7 @@ template <size_t page_size>
 struct MonotonicAllocatorBaseGlobal
 {
     static inline std::forward_list<std::array<char, page_size>> pool;
+    static inline std::forward_list<std::unique_ptr<char[]>> oversize;
     static inline size_t offset = 0;
 };
 
@@ -2217,6 +2627,7 @@ template <size_t page_size>
 struct MonotonicAllocatorBaseThread
 {
     static inline thread_local std::forward_list<std::array<char, page_size>> pool;
+    static inline thread_local std::forward_list<std::unique_ptr<char[]>> oversize;
     static inline thread_local size_t offset = 0;
 };
 
@@ -2225,20 +2636,23 @@ class MonotonicAllocatorBase : Base<page_size>
 {
     using Base<page_size>::pool;
     using Base<page_size>::offset;
+    using Base<page_size>::oversize;
 protected:
     void* do_allocate(size_t l) {
-        assert(l <= page_size);
         l = (l + 7) & (-8); //round up to nex multiple of 8 for alignment
         if (!pool.empty() && (offset + l <= page_size)) { size_t ret = offset; offset += l; return ret+pool.front().data(); }
-        if (l > page_size) return nullptr;
+        if (l > page_size) { //does not use up the current page
+            std::unique_ptr<char[]> big(new char[l]);
+            return oversize.emplace_front(std::move(big)).get();
+        }
         pool.emplace_front();
         offset = l;
         return pool.front().data();
     }
 public:
-    static void clear() noexcept { pool.clear(); offset = 0; }
-    static void reset() noexcept { if (!pool.empty()) pool.resize(1); offset = 0; } ///<Keeps one page allocated (but empty)
-    constexpr size_t max_size() const noexcept { return page_size; }
+    static void clear() noexcept { pool.clear(); oversize.clear(); offset = 0; }
+    static void reset() noexcept { if (!pool.empty()) pool.resize(1); oversize.clear(); offset = 0; } ///<Keeps one page allocated (but empty)
+    constexpr size_t max_size() const noexcept { return std::numeric_limits<size_t>::max(); }
 };
 
 /** A monotonic allocator with either global or per-thread state.
@@ -2269,6 +2683,161 @@ template <typename T>
 using TMonoAllocator = MonotonicAllocator<T, MonotonicAllocatorBaseThread, page_size>;
 } // impl::
 
+/** A thread-safe pool of free pages that arenas of the same page size can share.
+ * Arenas created with a pool take their pages from it and return them on reset()
+ * or destruction, so a steady stream of short-lived arenas allocates no new pages.
+ * At most 'max_pages' free pages are kept, the rest are freed.
+ * The pool must outlive the arenas using it.*/
+class arena_page_pool
+{
+    const size_t _page_size;
+    const size_t _max_pages;
+    mutable std::mutex _lock;
+    std::vector<std::unique_ptr<char[]>> _free;
+public:
+    explicit arena_page_pool(size_t page_size = impl::page_size, size_t max_pages = 64) :
+        _page_size((page_size + 7) & (-8)), _max_pages(max_pages) {}
+    arena_page_pool(const arena_page_pool &) = delete;
+    arena_page_pool &operator=(const arena_page_pool &) = delete;
+    [[nodiscard]] size_t page_size() const noexcept { return _page_size; }
+    /** The number of free pages currently in the pool.*/
+    [[nodiscard]] size_t free_pages() const { std::lock_guard g(_lock); return _free.size(); }
+    /** Take a page from the pool, or allocate a new one if empty (uninitialized).*/
+    [[nodiscard]] std::unique_ptr<char[]> get() {
+        {
+            std::lock_guard g(_lock);
+            if (_free.size()) {
+                std::unique_ptr<char[]> ret = std::move(_free.back());
+                _free.pop_back();
+                return ret;
+            }
+        }
+        return std::unique_ptr<char[]>(new char[_page_size]);
+    }
+    /** Return a page to the pool. It must have been allocated with our page size.*/
+    void put(std::unique_ptr<char[]> &&page) noexcept {
+        std::lock_guard g(_lock);
+        if (_free.size() < _max_pages) try { _free.push_back(std::move(page)); } catch (...) {}
+        page.reset();
+    }
+};
+
+/** A monotonic memory arena with its own lifetime, an alternative to the global and
+ * thread-local monotonic allocators of uf::gwview and uf::twview.
+ * Use uf::awview and uf::asview to allocate from an arena. Since allocators of wviews are
+ * stateless, they are created in the arena made current on the thread via an arena::scope
+ * (or see make_awview()). An awview remembers its arena: later modifications of it (or of
+ * its sub-views) allocate from there, whichever arena is current at the time, if any.
+ * Scopes can be nested and each request being processed on a worker thread can use its own arena,
+ * so releasing one does not invalidate the views of another.
+ * Allocations larger than the page size are served individually and freed with the arena.
+ * Deallocation is a no-op, memory is released on reset() or destruction, which invalidates
+ * all views allocated from the arena. An arena is not thread safe, use it from one thread at a time.*/
+class arena
+{
+    static inline thread_local arena *_current = nullptr;
+    const size_t _page_size;
+    arena_page_pool *const _pool = nullptr;
+    std::vector<std::unique_ptr<char[]>> _pages;    ///<The last one is being filled
+    std::vector<std::unique_ptr<char[]>> _oversize; ///<Allocations larger than a page
+    size_t _offset = 0;                             ///<Into the last page
+public:
+    /** Create an arena allocating its own pages.*/
+    explicit arena(size_t page_size = impl::page_size) noexcept : _page_size((page_size + 7) & (-8)) {}
+    /** Create an arena taking its pages from (and returning them to) a pool.*/
+    explicit arena(arena_page_pool &pool) noexcept : _page_size(pool.page_size()), _pool(&pool) {}
+    arena(const arena &) = delete;
+    arena &operator=(const arena &) = delete;
+    ~arena() { release(); }
+
+    /** Makes an arena current for the thread for its lifetime, restoring the previous one after.*/
+    class scope
+    {
+        arena *const _prev;
+    public:
+        explicit scope(arena &a) noexcept : scope(&a) {}
+        /** Makes 'a' (which may be null) current.*/
+        explicit scope(arena *a) noexcept : _prev(_current) { _current = a; }
+        scope(const scope &) = delete;
+        scope &operator=(const scope &) = delete;
+        ~scope() { _current = _prev; }
+    };
+    /** The arena current on this thread or nullptr if none.*/
+    [[nodiscard]] static arena *current() noexcept { return _current; }
+
+    /** Allocate 'l' bytes aligned to 8.*/
+    [[nodiscard]] void *allocate(size_t l) {
+        l = (l + 7) & (-8);
+        if (l > _page_size) {
+            std::unique_ptr<char[]> big(new char[l]);
+            return _oversize.emplace_back(std::move(big)).get();
+        }
+        if (_pages.empty() || _offset + l > _page_size) {
+            _pages.push_back(_pool ? _pool->get() : std::unique_ptr<char[]>(new char[_page_size]));
+            _offset = 0;
+        }
+        void *ret = _pages.back().get() + _offset;
+        _offset += l;
+        return ret;
+    }
+    /** Invalidate all allocations. Keeps one page for reuse if we have no pool.*/
+    void reset() noexcept {
+        if (_pool || _pages.empty()) release();
+        else {
+            _pages.resize(1);
+            _oversize.clear();
+            _offset = 0;
+        }
+    }
+    /** Invalidate all allocations and free (or return to the pool) all pages.*/
+    void release() noexcept {
+        if (_pool)
+            for (auto &p : _pages)
+                _pool->put(std::move(p));
+        _pages.clear();
+        _oversize.clear();
+        _offset = 0;
+    }
+    [[nodiscard]] size_t page_size() const noexcept { return _page_size; }
+    /** The number of pages (not counting oversize allocations) we hold.*/
+    [[nodiscard]] size_t pages() const noexcept { return _pages.size(); }
+};
+
+namespace impl {
+/** A stateless allocator allocating from the current arena (see uf::arena::scope).
+ * @exception uf::api_error if no arena is current on the thread.*/
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+    template <typename U> struct rebind { using other = ArenaAllocator<U>; };
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    constexpr ArenaAllocator(const ArenaAllocator<U>&) noexcept {};
+    T* allocate(size_t n) {
+        arena *const a = arena::current();
+        if (!a) throw api_error("Allocation from an uf::arena without an active uf::arena::scope.");
+        return (T*)a->allocate(n * sizeof(T));
+    }
+    static void deallocate(T*, size_t) noexcept {}
+    constexpr size_t max_size() const noexcept { return std::numeric_limits<size_t>::max() / sizeof(T); }
+    template <typename U>
+    constexpr bool operator ==(const ArenaAllocator<U>&) noexcept { return true; }
+    template <typename U>
+    constexpr bool operator !=(const ArenaAllocator<U>&) noexcept { return false; }
+};
+
+/** Wviews allocating from an arena remember the one current at their creation.*/
+template <>
+struct allocator_binding<ArenaAllocator> {
+    arena *const a = arena::current();
+    struct scope : arena::scope {
+        explicit scope(const allocator_binding *b) noexcept : arena::scope(b ? b->a : arena::current()) {}
+    };
+};
+} // impl::
+
 
 /** A shared string view using the default allocator. */
 using sview = impl::sview<true, std::allocator>::ptr;
@@ -2285,6 +2854,18 @@ using tsview = impl::sview<false, impl::TMonoAllocator>::ptr;
 /** A shared writable any view using a thread-local monotonic allocator. */
 using twview = impl::wview<false, impl::TMonoAllocator>::ptr;
 
+/** A shared string view allocating from the current uf::arena. */
+using asview = impl::sview<false, impl::ArenaAllocator>::ptr;
+/** A shared writable any view allocating from the uf::arena current at its creation. */
+using awview = impl::wview<false, impl::ArenaAllocator>::ptr;
+
+/** Create an uf::awview in arena 'a' (with any constructor arguments of it), without an arena::scope.*/
+template <typename ...Args>
+[[nodiscard]] awview make_awview(arena &a, Args&&... args) {
+    arena::scope s(a);
+    return awview(std::forward<Args>(args)...);
+}
+
 /** Reset the global monotonic allocator, keeping one page allocated (but empty).
  * All uf::gsview and uf::gwview objects become invalid.*/
 inline void gallocator_reset() noexcept { impl::MonotonicAllocatorBase<impl::MonotonicAllocatorBaseGlobal, impl::page_size>::reset(); }
@@ -2311,6 +2892,10 @@ inline void tallocator_reset() noexcept { impl::MonotonicAllocatorBase<impl::Mon
  * - You can, however, use wview::set() setting the content of a wview to
  *   the value of some other wview, like A.set(B) - and later use A and B
  *   concurrently.
+ * - For a single writer and many readers, the writer can publish B = A.snapshot()
+ *   (e.g., under a mutex or via an atomic shared_ptr) and keep modifying A.
+ *   Each reader takes its own R = B.snapshot() and uses R freely. This is cheap,
+ *   since no bytes are copied, only chunks. Needs the refcounted uf::wview.
  */
 
 /* LUA language design